@@ -0,0 +1,620 @@
+#include <benchmark/benchmark.h>
+#include <requirements.hpp>
+#include <requirements_concurrent.hpp>
+#include <requirements_mapped.hpp>
+#include <requirements_packed.hpp>
+#include <requirements_parallel.hpp>
+#include <requirements_static.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Synthetic graphs. All generators produce relations that satisfy the rules of Requirements,
+// so they can be loaded with bulk_set() whatever their size.
+
+using Edges = std::vector<std::pair<int, int>>;
+
+// 0 -> 1 -> 2 -> ... -> n
+Edges chain(int64_t edges)
+{
+    Edges result{};
+    for (int i = 0; i < edges; ++i)
+        result.push_back({ i, i + 1 });
+    return result;
+}
+
+// 0 -> 1, 0 -> 2, ..., 0 -> n
+Edges fan_out(int64_t edges)
+{
+    Edges result{};
+    for (int i = 1; i <= edges; ++i)
+        result.push_back({ 0, i });
+    return result;
+}
+
+// layers of `width` objects, each object requires `degree` random objects of the previous layer
+Edges random_dag(int64_t edges, int width = 1024, int degree = 4)
+{
+    std::mt19937 rng{ 42 };
+    std::uniform_int_distribution<int> pick{ 0, width - 1 };
+    Edges result{};
+    for (int layer = 1; static_cast<int64_t>(result.size()) < edges; ++layer)
+        for (int i = 0; i < width && static_cast<int64_t>(result.size()) < edges; ++i)
+        {
+            std::vector<int> reqs{};
+            while (static_cast<int>(reqs.size()) < degree)
+            {
+                auto req = (layer - 1) * width + pick(rng);
+                if (std::find(reqs.begin(), reqs.end(), req) == reqs.end())
+                    reqs.push_back(req);
+            }
+            for (auto req : reqs)
+                result.push_back({ layer * width + i, req });
+        }
+    return result;
+}
+
+// `depth` layers of 2 objects fully connected to the previous layer: 2^depth chains
+Edges diamonds(int64_t depth)
+{
+    Edges result{};
+    for (int layer = 1; layer <= depth; ++layer)
+        for (int i = 0; i < 2; ++i)
+            for (int j = 0; j < 2; ++j)
+                result.push_back({ layer * 2 + i, (layer - 1) * 2 + j });
+    return result;
+}
+
+// cycles of `length` objects, loaded in a reflexive instance
+Edges cycles(int64_t edges, int length = 16)
+{
+    Edges result{};
+    for (int i = 0; i < edges; ++i)
+    {
+        auto base = i / length * length;
+        result.push_back({ i, base + (i - base + 1) % length });
+    }
+    return result;
+}
+
+Requirements::Requirements<int> load(const Edges& edges, bool reflexive = false)
+{
+    Requirements::Requirements<int> result{ reflexive };
+    auto violations = result.bulk_merge(edges.begin(), edges.end());
+    if (!violations.empty())
+        std::abort();
+    return result;
+}
+
+// each benchmark processes `edges` relations, from 1k to 1M
+#define EDGES_RANGE RangeMultiplier(8)->Range(1 << 10, 1 << 20)
+
+static void BM_Add_Chain(benchmark::State& state)
+{
+    auto edges = chain(state.range(0));
+    for (auto _ : state)
+    {
+        Requirements::Requirements<int> req{};
+        for (const auto& edge : edges)
+            req.add(edge.first, edge.second);
+        benchmark::DoNotOptimize(req.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Add_Chain)->EDGES_RANGE;
+
+static void BM_Add_Random_Dag(benchmark::State& state)
+{
+    auto edges = random_dag(state.range(0));
+    for (auto _ : state)
+    {
+        Requirements::Requirements<int> req{};
+        req.cache_reachability(state.range(1) != 0);
+        for (const auto& edge : edges)
+            req.add(edge.first, edge.second);
+        benchmark::DoNotOptimize(req.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Add_Random_Dag)->ArgsProduct({ { 1 << 10, 1 << 13, 1 << 16 }, { 0, 1 } });
+
+// relations added in random order, so the topological order kept by add() is often updated
+static void BM_Add_Shuffled_Random_Dag(benchmark::State& state)
+{
+    auto edges = random_dag(state.range(0));
+    std::shuffle(edges.begin(), edges.end(), std::mt19937{ 7 });
+    for (auto _ : state)
+    {
+        Requirements::Requirements<int> req{};
+        for (const auto& edge : edges)
+            req.add(edge.first, edge.second);
+        benchmark::DoNotOptimize(req.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Add_Shuffled_Random_Dag)->RangeMultiplier(8)->Range(1 << 10, 1 << 16);
+
+static void BM_Add_String(benchmark::State& state)
+{
+    std::vector<std::pair<std::string, std::string>> edges{};
+    for (const auto& edge : random_dag(state.range(0)))
+        edges.push_back({ "package-" + std::to_string(edge.first), "package-" + std::to_string(edge.second) });
+    for (auto _ : state)
+    {
+        Requirements::Requirements<std::string> req{};
+        auto violations = req.bulk_merge(edges.begin(), edges.end());
+        benchmark::DoNotOptimize(violations.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Add_String)->EDGES_RANGE;
+
+// closure of a bottom object and bytes per relation: Requirements, after shrink_to_fit(), frozen and packed copies
+static void BM_Memory_String_Random_Dag(benchmark::State& state)
+{
+    std::vector<std::pair<std::string, std::string>> edges{};
+    for (const auto& edge : random_dag(1 << 18))
+        edges.push_back({ "package-" + std::to_string(edge.first), "package-" + std::to_string(edge.second) });
+    Requirements::Requirements<std::string> req{};
+    req.bulk_merge(edges.begin(), edges.end());
+    req.transitive_dependents("package-0");
+    if (state.range(0) != 0)
+        req.shrink_to_fit();
+    Requirements::FrozenRequirements<std::string> frozen{};
+    Requirements::PackedRequirements<std::string> packed{};
+    Requirements::MemoryUsage usage{ req.memory_usage() };
+    if (state.range(0) == 2)
+        usage = (frozen = Requirements::FrozenRequirements<std::string>{ req }).memory_usage();
+    else if (state.range(0) == 3)
+        usage = (packed = Requirements::PackedRequirements<std::string>{ req }).memory_usage();
+    for (auto _ : state)
+    {
+        if (state.range(0) == 2)
+            benchmark::DoNotOptimize(frozen.transitive_dependents("package-0"));
+        else if (state.range(0) == 3)
+            benchmark::DoNotOptimize(packed.transitive_dependents("package-0"));
+        else
+            benchmark::DoNotOptimize(req.transitive_dependents("package-0"));
+    }
+    state.counters["bytes_per_edge"] = static_cast<double>(usage.total()) / static_cast<double>(edges.size());
+    state.counters["adjacency_per_edge"] = static_cast<double>(usage.adjacency) / static_cast<double>(edges.size());
+}
+BENCHMARK(BM_Memory_String_Random_Dag)->DenseRange(0, 3);
+
+static void BM_Bulk_Set_Random_Dag(benchmark::State& state)
+{
+    auto edges = random_dag(state.range(0));
+    std::unordered_multimap<int, int> table(edges.begin(), edges.end());
+    Requirements::Requirements<int> req{};
+    for (auto _ : state)
+    {
+        auto violations = req.bulk_set(table);
+        benchmark::DoNotOptimize(violations.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Bulk_Set_Random_Dag)->EDGES_RANGE;
+
+static void BM_Bulk_Merge_Stream_Random_Dag(benchmark::State& state)
+{
+    std::string text{};
+    for (const auto& edge : random_dag(state.range(0)))
+        text += std::to_string(edge.first) + ',' + std::to_string(edge.second) + '\n';
+    for (auto _ : state)
+    {
+        std::istringstream input{ text };
+        Requirements::Requirements<int> req{};
+        auto violations = req.bulk_merge(input);
+        benchmark::DoNotOptimize(violations.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+BENCHMARK(BM_Bulk_Merge_Stream_Random_Dag)->EDGES_RANGE;
+
+static void BM_Merge_Random_Dag(benchmark::State& state)
+{
+    auto edges = random_dag(state.range(0));
+    std::unordered_multimap<int, int> table(edges.begin(), edges.end());
+    Requirements::Requirements<int> req{};
+    for (auto _ : state)
+    {
+        req.set(table);
+        benchmark::DoNotOptimize(req.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Merge_Random_Dag)->RangeMultiplier(8)->Range(1 << 10, 1 << 16);
+
+static void BM_Mapped_Open_Random_Dag(benchmark::State& state)
+{
+    auto edges = random_dag(state.range(0));
+    const std::string path{ "requirements-bench.bin" };
+    Requirements::save(load(edges).freeze(), path);
+    for (auto _ : state)
+    {
+        Requirements::MappedRequirements<int> mapped{ path };
+        benchmark::DoNotOptimize(mapped.exists(edges.back().first, edges.back().second));
+    }
+    std::remove(path.c_str());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Mapped_Open_Random_Dag)->EDGES_RANGE;
+
+static void BM_Exists_Recursive_Chain(benchmark::State& state)
+{
+    auto req = load(chain(state.range(0)));
+    req.cache_reachability(state.range(1) != 0);
+    auto last = static_cast<int>(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(req.exists(0, last, true));
+}
+BENCHMARK(BM_Exists_Recursive_Chain)->ArgsProduct({ { 1 << 10, 1 << 13, 1 << 16 }, { 0, 1 } });
+
+// 64 objects in a chain, dynamic (0) or static (1) backend, from building the relations to a recursive check
+static void BM_Small_Chain_Add_Exists(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        if (state.range(0) == 0)
+        {
+            Requirements::Requirements<int> req{};
+            for (int i = 0; i < 63; ++i)
+                req.add(i, i + 1);
+            benchmark::DoNotOptimize(req.exists(0, 63, true));
+        }
+        else
+        {
+            Requirements::StaticRequirements<int, 64> req{};
+            for (int i = 0; i < 63; ++i)
+                req.add(i, i + 1);
+            benchmark::DoNotOptimize(req.exists(0, 63, true));
+        }
+    }
+}
+BENCHMARK(BM_Small_Chain_Add_Exists)->DenseRange(0, 1);
+
+static void BM_Exists_Recursive_Random_Dag(benchmark::State& state)
+{
+    auto edges = random_dag(state.range(0));
+    auto req = load(edges);
+    std::mt19937 rng{ 7 };
+    std::uniform_int_distribution<size_t> pick{ 0, edges.size() - 1 };
+    for (auto _ : state)
+        benchmark::DoNotOptimize(req.exists(edges.back().first, edges[pick(rng)].second, true));
+}
+BENCHMARK(BM_Exists_Recursive_Random_Dag)->EDGES_RANGE;
+
+// 256 recursive queries from 16 dependents of the last layer, answered one by one (0) or as a batch (1)
+static void BM_Exists_Many_Random_Dag(benchmark::State& state)
+{
+    auto edges = random_dag(state.range(0));
+    auto req = load(edges);
+    std::mt19937 rng{ 7 };
+    std::uniform_int_distribution<size_t> pick{ 0, edges.size() - 1 };
+    Edges queries{};
+    for (int dep = 0; dep < 16; ++dep)
+        for (int i = 0; i < 16; ++i)
+            queries.push_back({ edges[edges.size() - 1 - dep * 4].first, edges[pick(rng)].second });
+    Requirements::Bitset results{};
+    for (auto _ : state)
+    {
+        if (state.range(1) == 0)
+            for (size_t i = 0; i < queries.size(); ++i)
+            {
+                if (req.exists(queries[i].first, queries[i].second, true))
+                    results.set(i);
+            }
+        else
+            req.exists_many(queries.begin(), queries.end(), results, true);
+        benchmark::DoNotOptimize(results);
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(BM_Exists_Many_Random_Dag)->ArgsProduct({ { 1 << 13, 1 << 16, 1 << 20 }, { 0, 1 } });
+
+static void BM_Build_Reachability_Random_Dag(benchmark::State& state)
+{
+    auto edges = random_dag(state.range(0));
+    auto req = load(edges);
+    for (auto _ : state)
+    {
+        req.cache_reachability(true);
+        benchmark::DoNotOptimize(req.exists(edges.back().first, edges.front().second, true));    // builds the cache
+        state.PauseTiming();
+        req.cache_reachability(false);
+        state.ResumeTiming();
+    }
+    state.SetLabel(Requirements::BitsetKernels::name());
+}
+BENCHMARK(BM_Build_Reachability_Random_Dag)->RangeMultiplier(8)->Range(1 << 10, 1 << 18);
+
+static void BM_Exists_Recursive_Cycles(benchmark::State& state)
+{
+    auto req = load(cycles(state.range(0), static_cast<int>(state.range(0))), true);
+    auto last = static_cast<int>(state.range(0)) - 1;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(req.exists(1, last, true) && req.exists(last, 1, true));
+}
+BENCHMARK(BM_Exists_Recursive_Cycles)->EDGES_RANGE;
+
+static void BM_Frozen_Exists_Recursive_Random_Dag(benchmark::State& state)
+{
+    auto edges = random_dag(state.range(0));
+    auto req = load(edges).freeze();
+    std::mt19937 rng{ 7 };
+    std::uniform_int_distribution<size_t> pick{ 0, edges.size() - 1 };
+    for (auto _ : state)
+        benchmark::DoNotOptimize(req.exists(edges.back().first, edges[pick(rng)].second, true));
+}
+BENCHMARK(BM_Frozen_Exists_Recursive_Random_Dag)->EDGES_RANGE;
+
+static void BM_Requirements_Fan_Out(benchmark::State& state)
+{
+    auto req = load(fan_out(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(req.requirements(0));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Requirements_Fan_Out)->EDGES_RANGE;
+
+static void BM_Dependents_Fan_Out(benchmark::State& state)
+{
+    auto req = load(fan_out(state.range(0)));
+    int object{ 1 };
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(req.dependents(object));
+        benchmark::DoNotOptimize(req.has_dependents(object));
+        object = object % static_cast<int>(state.range(0)) + 1;
+    }
+}
+BENCHMARK(BM_Dependents_Fan_Out)->EDGES_RANGE;
+
+static void BM_Requirements_View_Fan_Out(benchmark::State& state)
+{
+    auto req = load(fan_out(state.range(0)));
+    for (auto _ : state)
+    {
+        size_t count{ 0 };
+        for (const auto& object : req.requirements_view(0))
+            count += static_cast<size_t>(object);
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Requirements_View_Fan_Out)->EDGES_RANGE;
+
+static void BM_Frozen_Requirements_Fan_Out(benchmark::State& state)
+{
+    auto req = load(fan_out(state.range(0))).freeze();
+    for (auto _ : state)
+    {
+        size_t count{ 0 };
+        for (const auto& object : req.requirements(0))
+            count += static_cast<size_t>(object);
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Frozen_Requirements_Fan_Out)->EDGES_RANGE;
+
+static void BM_Remove_Requirement_Fan_In(benchmark::State& state)
+{
+    Edges edges{};
+    for (int i = 1; i <= state.range(0); ++i)
+        edges.push_back({ i, 0 });
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto req = load(edges);
+        state.ResumeTiming();
+        req.remove_requirement(0);
+        benchmark::DoNotOptimize(req.size());
+    }
+}
+BENCHMARK(BM_Remove_Requirement_Fan_In)->EDGES_RANGE;
+
+static void BM_Remove_All_Compact_Fan_In(benchmark::State& state)
+{
+    Edges edges{};
+    for (int i = 1; i <= state.range(0); ++i)
+        edges.push_back({ i, 0 });
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto req = load(edges);
+        state.ResumeTiming();
+        req.remove_all(0);
+        for (int i = 1; i <= 64; ++i)
+            req.remove_all(i);
+        benchmark::DoNotOptimize(req.compact());
+    }
+}
+BENCHMARK(BM_Remove_All_Compact_Fan_In)->EDGES_RANGE;
+
+static void BM_Transitive_Requirements_Random_Dag(benchmark::State& state)
+{
+    auto edges = random_dag(state.range(0));
+    auto req = load(edges);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(req.transitive_requirements(edges.back().first));
+}
+BENCHMARK(BM_Transitive_Requirements_Random_Dag)->EDGES_RANGE;
+
+static void BM_All_Requirements_Diamonds(benchmark::State& state)
+{
+    auto req = load(diamonds(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(req.all_requirements(true));
+    state.counters["chains"] = static_cast<double>(int64_t{ 2 } << state.range(0));
+}
+BENCHMARK(BM_All_Requirements_Diamonds)->DenseRange(4, 16, 4);
+
+static void BM_Requirement_Chains_Diamonds(benchmark::State& state)
+{
+    auto req = load(diamonds(state.range(0)));
+    for (auto _ : state)
+    {
+        size_t count{ 0 };
+        for (const auto& chain : req.requirement_chains(true))
+            count += chain.size();
+        benchmark::DoNotOptimize(count);
+    }
+    state.counters["chains"] = static_cast<double>(int64_t{ 2 } << state.range(0));
+}
+BENCHMARK(BM_Requirement_Chains_Diamonds)->DenseRange(4, 16, 4);
+
+// diamonds closed into a single cycle: branches of objects vs branches of the condensation
+static void BM_Chains_Cyclic_Diamonds(benchmark::State& state)
+{
+    const int top = static_cast<int>(state.range(0)) * 2;
+    Requirements::Requirements<int> req{ true };
+    for (const auto& edge : diamonds(state.range(0)))
+        req.add(edge.first, edge.second);
+    req.add(0, top);
+    for (auto _ : state)
+    {
+        if (state.range(1) == 0)
+            benchmark::DoNotOptimize(req.all_requirements(top));
+        else
+        {
+            auto graph = req.condensation();
+            benchmark::DoNotOptimize(graph.requirement_chains(graph.component_of(top)));
+        }
+    }
+}
+BENCHMARK(BM_Chains_Cyclic_Diamonds)->ArgsProduct({ { 4, 8, 12 }, { 0, 1 } });
+
+static void BM_All_Requirements_Chain(benchmark::State& state)
+{
+    auto req = load(chain(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(req.all_requirements(true));
+}
+BENCHMARK(BM_All_Requirements_Chain)->RangeMultiplier(8)->Range(1 << 10, 1 << 16);
+
+// every object of a forest of 64 levels is a root: the member function vs a pool of 1 to 8 threads
+static void BM_All_Requirements_Parallel_Forest(benchmark::State& state)
+{
+    auto req = load(random_dag(1 << 16, 1024, 1));
+    std::unique_ptr<Requirements::ThreadPool> pool{};
+    if (state.range(0) != 0)
+        pool = std::make_unique<Requirements::ThreadPool>(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        if (pool)
+            benchmark::DoNotOptimize(Requirements::all_requirements(req, false, *pool));
+        else
+            benchmark::DoNotOptimize(req.all_requirements(false));
+    }
+}
+BENCHMARK(BM_All_Requirements_Parallel_Forest)->Arg(0)->Arg(1)->Arg(2)->Arg(8)->UseRealTime();
+
+static void BM_Topological_Levels_Random_Dag(benchmark::State& state)
+{
+    auto req = load(random_dag(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(req.topological_levels());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Topological_Levels_Random_Dag)->EDGES_RANGE;
+
+static void BM_Topological_Order_Random_Dag(benchmark::State& state)
+{
+    auto req = load(random_dag(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(req.topological_order());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Topological_Order_Random_Dag)->EDGES_RANGE;
+
+static void BM_Get_Random_Dag(benchmark::State& state)
+{
+    auto req = load(random_dag(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(req.get());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Get_Random_Dag)->EDGES_RANGE;
+
+// a consumer following a batch of 2 modifications: journal vs snapshot of the whole table
+static void BM_Changes_Since_Random_Dag(benchmark::State& state)
+{
+    auto req = load(random_dag(state.range(0)));
+    req.journal_changes(state.range(1) != 0);
+    for (auto _ : state)
+    {
+        auto version = req.version();
+        req.add(-1, -2);
+        req.remove(-1, -2);
+        if (state.range(1) != 0)
+        {
+            benchmark::DoNotOptimize(req.changes_since(version).size());
+            req.forget_changes(req.version());
+        }
+        else
+            benchmark::DoNotOptimize(req.get());
+    }
+}
+BENCHMARK(BM_Changes_Since_Random_Dag)->ArgsProduct({ { 1 << 10, 1 << 16, 1 << 20 }, { 0, 1 } });
+
+// the direct and second-level dependents of a bottom object: bounded walk vs whole closure
+static void BM_Impacted_Dependents_Random_Dag(benchmark::State& state)
+{
+    auto req = load(random_dag(state.range(0)));
+    for (auto _ : state)
+    {
+        if (state.range(1) != 0)
+            benchmark::DoNotOptimize(req.impacted_dependents(0, 2, 64));
+        else
+            benchmark::DoNotOptimize(req.transitive_dependents(0));
+    }
+}
+BENCHMARK(BM_Impacted_Dependents_Random_Dag)->ArgsProduct({ { 1 << 10, 1 << 16, 1 << 20 }, { 0, 1 } });
+
+// closure of a bottom object in one call vs resumed by steps of 256 or 4096 objects
+static void BM_Closure_Walk_Random_Dag(benchmark::State& state)
+{
+    auto req = load(random_dag(1 << 20));
+    const auto budget = static_cast<size_t>(state.range(0));
+    for (auto _ : state)
+    {
+        if (budget == 0)
+            benchmark::DoNotOptimize(req.transitive_dependents(0));
+        else
+        {
+            auto walk = req.transitive_dependents_walk(0);
+            while (walk.resume(budget) == Requirements::WalkStatus::Running)
+                ;
+            benchmark::DoNotOptimize(walk.objects().size());
+        }
+    }
+}
+BENCHMARK(BM_Closure_Walk_Random_Dag)->Arg(0)->Arg(256)->Arg(4096);
+
+static void BM_Concurrent_Exists_Random_Dag(benchmark::State& state)
+{
+    static const auto edges = random_dag(1 << 16);
+    static Requirements::ConcurrentRequirements<int> shared{};
+    if (state.thread_index() == 0 && shared.empty())
+        shared.bulk_merge(std::unordered_multimap<int, int>(edges.begin(), edges.end()));
+    std::mt19937 rng{ static_cast<unsigned>(state.thread_index()) };
+    std::uniform_int_distribution<size_t> pick{ 0, edges.size() - 1 };
+    for (auto _ : state)
+    {
+        const auto& edge = edges[pick(rng)];
+        benchmark::DoNotOptimize(shared.exists(edge.first, edge.second));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Concurrent_Exists_Random_Dag)->ThreadRange(1, 8);
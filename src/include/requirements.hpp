@@ -9,25 +9,759 @@
 *   \author Christophe COUAILLET
 */
 
+#include <algorithm>
 #include <cassert>
+#include <charconv>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "requirements_simd.hpp"
+
+// Define REQUIREMENTS_ENABLE_INSTRUMENTATION, the same way in the whole program, to maintain the statistics of the instances
+// and call their trace hook. Otherwise the counters below expand to nothing.
+#ifdef REQUIREMENTS_ENABLE_INSTRUMENTATION
+#define REQUIREMENTS_COUNT(counter, value) (m_statistics.counter += (value))
+#define REQUIREMENTS_PEAK(counter, value) (m_statistics.counter = std::max<size_t>(m_statistics.counter, (value)))
+#define REQUIREMENTS_GROWTH(container) (m_statistics.allocations += (container).size() == (container).capacity())
+#define REQUIREMENTS_TRACE(operation) Tracer _tracer{ *this, operation }
+#else
+#define REQUIREMENTS_COUNT(counter, value) ((void)0)
+#define REQUIREMENTS_PEAK(counter, value) ((void)0)
+#define REQUIREMENTS_GROWTH(container) ((void)0)
+#define REQUIREMENTS_TRACE(operation) ((void)0)
+#endif
+
 namespace Requirements
 {
 
+    /*! \brief BasicBitset is a growable set of bits used to store sets of node ids.
+
+        Bits beyond the current size read as false and the set grows when a bit beyond its size is set.
+        The words are allocated with Allocator, and the constructors taking a trailing allocator let containers
+        using uses-allocator construction, such as std::pmr ones, pass their allocator to their bitsets.
+        Unions, intersections and counts run on the vectorized loops of BitsetKernels.
+    */
+    template <typename Allocator = std::allocator<std::uint64_t>>
+    class BasicBitset
+    {
+    public:
+
+        using word_type = std::uint64_t;                                                        //!< storage unit of the bits
+        using allocator_type = Allocator;                                                       //!< allocator of the words
+        static constexpr size_t word_bits = 64;                                                 //!< number of bits per word
+        static constexpr size_t npos = std::numeric_limits<size_t>::max();                      //!< position returned when no bit is found
+
+        BasicBitset() = default;
+        BasicBitset(const BasicBitset&) = default;
+        BasicBitset(BasicBitset&&) noexcept = default;
+        BasicBitset& operator=(const BasicBitset&) = default;
+        BasicBitset& operator=(BasicBitset&&) = default;
+
+        /*! \brief Constructor. Creates an empty set.
+        *   \param allocator the allocator of the words
+        */
+        explicit BasicBitset(const Allocator& allocator) noexcept : m_words(allocator) {};
+
+        /*! \brief Constructor. Allocates the given number of bits, all set to false.
+        *   \param size the number of bits
+        *   \param allocator the allocator of the words
+        */
+        explicit BasicBitset(size_t size, const Allocator& allocator = Allocator()) : m_words((size + word_bits - 1) / word_bits, 0, allocator) {};
+
+        BasicBitset(const BasicBitset& other, const Allocator& allocator) : m_words(other.m_words, allocator) {};         //!< copy with another allocator
+        BasicBitset(BasicBitset&& other, const Allocator& allocator) : m_words(std::move(other.m_words), allocator) {};   //!< move with another allocator
+
+        /*! \brief Gets the number of bits currently allocated.
+        *   \return the allocated number of bits, a multiple of word_bits
+        */
+        size_t size() const noexcept { return m_words.size() * word_bits; }
+
+        /*! \brief Checks the bit at the given position.
+        *   \param pos the position to check
+        *   \return true if the bit is set
+        */
+        bool test(size_t pos) const noexcept
+        {
+            auto word = pos / word_bits;
+            return word < m_words.size() && (m_words[word] >> (pos % word_bits) & 1) != 0;
+        }
+
+        /*! \brief Sets the bit at the given position, growing the set if needed.
+        *   \param pos the position to set
+        */
+        void set(size_t pos)
+        {
+            auto word = pos / word_bits;
+            if (word >= m_words.size())
+                m_words.resize(word + 1, 0);
+            m_words[word] |= word_type{ 1 } << (pos % word_bits);
+        }
+
+        /*! \brief Clears the bit at the given position.
+        *   \param pos the position to clear
+        */
+        void reset(size_t pos) noexcept
+        {
+            auto word = pos / word_bits;
+            if (word < m_words.size())
+                m_words[word] &= ~(word_type{ 1 } << (pos % word_bits));
+        }
+
+        /*! \brief Changes the number of bits allocated, new bits are set to false.
+        *   \param size the number of bits to allocate
+        */
+        void resize(size_t size) { m_words.resize((size + word_bits - 1) / word_bits, 0); }
+
+        /*! \brief Releases the words allocated beyond the current size.
+        */
+        void shrink_to_fit() { m_words.shrink_to_fit(); }
+
+        /*! \brief Gets the number of bytes allocated for the words.
+        *   \return the capacity of the set in bytes
+        */
+        size_t memory_usage() const noexcept { return m_words.capacity() * sizeof(word_type); }
+
+        /*! \brief Clears all bits, keeping the allocated size.
+        */
+        void reset() noexcept { std::fill(m_words.begin(), m_words.end(), word_type{ 0 }); }
+
+        /*! \brief Finds the first bit set at or after the given position.
+        *   \param pos the position to start from
+        *   \return the position of the bit found, or npos
+        */
+        size_t find_next(size_t pos) const noexcept
+        {
+            auto word = pos / word_bits;
+            if (word >= m_words.size())
+                return npos;
+            auto bits = m_words[word] & (~word_type{ 0 } << (pos % word_bits));
+            while (bits == 0)
+            {
+                if (++word >= m_words.size())
+                    return npos;
+                bits = m_words[word];
+            }
+            return word * word_bits + BitsetKernels::lowest(bits);
+        }
+
+        /*! \brief Sets the bits that are set in the other set.
+        *   \param other the set to merge
+        *   \return this set
+        */
+        template <typename OtherAllocator>
+        BasicBitset& operator|=(const BasicBitset<OtherAllocator>& other)
+        {
+            if (other.m_words.size() > m_words.size())
+                m_words.resize(other.m_words.size(), 0);
+            BitsetKernels::or_words(m_words.data(), other.m_words.data(), other.m_words.size());
+            return *this;
+        }
+
+        /*! \brief Clears the bits that are not set in the other set.
+        *   \param other the set to intersect with
+        *   \return this set
+        */
+        template <typename OtherAllocator>
+        BasicBitset& operator&=(const BasicBitset<OtherAllocator>& other) noexcept
+        {
+            auto common = std::min(m_words.size(), other.m_words.size());
+            BitsetKernels::and_words(m_words.data(), other.m_words.data(), common);
+            std::fill(m_words.begin() + common, m_words.end(), word_type{ 0 });
+            return *this;
+        }
+
+        /*! \brief Checks if the 2 sets have at least one bit set in common.
+        *   \param other the set to check
+        *   \return true if a bit is set in both sets
+        */
+        template <typename OtherAllocator>
+        bool intersects(const BasicBitset<OtherAllocator>& other) const noexcept
+        {
+            return BitsetKernels::intersects(m_words.data(), other.m_words.data(), std::min(m_words.size(), other.m_words.size()));
+        }
+
+        /*! \brief Counts the bits that are set.
+        *   \return the number of bits set
+        */
+        size_t count() const noexcept { return BitsetKernels::popcount(m_words.data(), m_words.size()); }
+
+    private:
+        template <typename OtherAllocator>
+        friend class BasicBitset;
+
+        std::vector<word_type, typename std::allocator_traits<Allocator>::template rebind_alloc<word_type>> m_words{};
+    };
+
+    using Bitset = BasicBitset<>;                                                               //!< set of bits with the default allocator
+
+    /*! \brief Kinds of broken rules reported by the bulk loading functions.
+    */
+    enum class ViolationKind
+    {
+        SelfRequirement,            //!< the dependent and the requirement are the same object
+        Duplicate,                  //!< the relation already exists
+        ImplicitDuplicate,          //!< the relation is implied by other relations
+        Cycle                       //!< the relation closes a cycle while reflexivity is not allowed
+    };
+
+    /*! \brief Describes a relation rejected by the bulk loading functions.
+    */
+    template <typename T>
+    struct Violation
+    {
+        T dependent;                //!< the object that depends on the other object
+        T requirement;              //!< the object on which the first object depends
+        ViolationKind kind;         //!< the broken rule
+    };
+
+    /*! \brief States of a walk of a Requirements object resumed step by step.
+    */
+    enum class WalkStatus
+    {
+        Running,                    //!< the walk has more objects to visit
+        Done,                       //!< the walk is complete
+        Cancelled,                  //!< the walk has been cancelled
+        Expired,                    //!< the deadline of the walk has passed
+        Invalidated                 //!< the relations have been modified since the walk started
+    };
+
+    /*! \brief Kinds of modifications recorded by the journal of a Requirements object.
+    */
+    enum class ChangeKind
+    {
+        Added,                      //!< the relation has been created
+        Removed                     //!< the relation has been removed
+    };
+
+    /*! \brief Describes a modification of the relations, recorded by the journal of a Requirements object.
+    */
+    template <typename T>
+    struct Change
+    {
+        size_t version;             //!< version of the instance once the relation is modified
+        ChangeKind kind;            //!< the modification
+        T dependent;                //!< the object that depends on the other object
+        T requirement;              //!< the object on which the first object depends
+    };
+
+    /*! \brief Counters of the work done by a Requirements object, maintained when REQUIREMENTS_ENABLE_INSTRUMENTATION is defined.
+    */
+    struct Statistics
+    {
+        size_t lookups{ 0 };                //!< probes of the table of interned objects
+        size_t allocations{ 0 };            //!< growths of the node list and of the adjacency lists
+        size_t walks{ 0 };                  //!< recursive walks of exists(), exists_many() and the transitive queries
+        size_t visited{ 0 };                //!< objects visited by the walks
+        size_t peak_visited{ 0 };           //!< largest number of objects visited by a single walk
+        size_t chains{ 0 };                 //!< branches returned by all_requirements() and all_dependencies()
+        size_t peak_chains{ 0 };            //!< largest number of branches returned by a single call
+        size_t peak_chain_objects{ 0 };     //!< largest number of objects returned by a single call
+    };
+
+    /*! \brief Bytes allocated by an instance, by part, as returned by memory_usage().
+
+        Containers are counted by their capacity, and the elements of node-based containers with one pointer and one hash each.
+        The memory owned by the objects themselves, such as the characters of long strings, is not counted.
+    */
+    struct MemoryUsage
+    {
+        size_t index{ 0 };                  //!< interned objects and the table object -> node id
+        size_t adjacency{ 0 };              //!< lists of requirements and dependents
+        size_t order{ 0 };                  //!< online topological order
+        size_t cache{ 0 };                  //!< reachability cache
+        size_t journal{ 0 };                //!< journal of the changes
+        size_t scratch{ 0 };                //!< scratch buffers of the traversals
+
+        size_t total() const noexcept { return index + adjacency + order + cache + journal + scratch; }    //!< sum of all the parts
+    };
+
+    /*! \brief Describes a call, passed to the trace hook of a Requirements object when REQUIREMENTS_ENABLE_INSTRUMENTATION is defined.
+    */
+    struct TraceSpan
+    {
+        const char* operation;                              //!< name of the member called
+        std::chrono::steady_clock::time_point start;        //!< start of the call
+        std::chrono::steady_clock::duration duration;       //!< duration of the call
+        const Statistics* statistics;                       //!< counters of the instance at the end of the call
+    };
+
+    /*! \brief Span is a read-only view on contiguous elements, standing for std::span until C++20.
+    */
+    template <typename V>
+    class Span
+    {
+    public:
+
+        using value_type = V;                                                                   //!< type of the elements
+        using const_iterator = const V*;                                                        //!< iterator on the elements
+
+        Span() = default;
+
+        /*! \brief Constructor.
+        *   \param data the first element of the view
+        *   \param size the number of elements of the view
+        */
+        Span(const V* data, size_t size) noexcept : m_data(data), m_size(size) {};
+
+        const V* data() const noexcept { return m_data; }                                       //!< first element of the view
+        size_t size() const noexcept { return m_size; }                                         //!< number of elements of the view
+        bool empty() const noexcept { return m_size == 0; }                                     //!< true if the view has no element
+        const V& operator[](size_t pos) const noexcept { return m_data[pos]; }                  //!< element at the given position
+        const V& front() const noexcept { return m_data[0]; }                                   //!< first element of the view
+        const V& back() const noexcept { return m_data[m_size - 1]; }                           //!< last element of the view
+        const_iterator begin() const noexcept { return m_data; }                                //!< iterator on the first element
+        const_iterator end() const noexcept { return m_data + m_size; }                         //!< iterator past the last element
+
+    private:
+        const V* m_data{ nullptr };
+        size_t m_size{ 0 };
+    };
+
+    namespace detail
+    {
+        /*! \brief Walks breadth-first the neighbours of a node, within a depth and a number of nodes, as impacted_dependents() does.
+        *   \param start the id of the node to start from
+        *   \param max_depth the maximum distance of a node reported, at least 1
+        *   \param max_objects the maximum number of nodes reported, at least 1
+        *   \param nodes the number of nodes, i.e. the upper bound of node ids
+        *   \param scratch_trail the scratch list of the caller, borrowed during the walk and given back cleared
+        *   \param scratch_visited the scratch set of the caller, borrowed during the walk and given back cleared
+        *   \param neighbours the function that returns the ids of the neighbours of a node
+        *   \param expand the function that returns false when the walk must not go through a node reported
+        *   \param found the function called with each node reported, nearest first
+        *   \return the number of nodes visited, the start included
+        *
+        *   The scratch buffers are moved out for the walk, so that expand and found may query their owner, and given back
+        *   cleared even if one of them throws.
+        */
+        template <typename Ids, typename Set, typename Neighbours, typename Expand, typename Found>
+        size_t bounded_walk(typename Ids::value_type start, size_t max_depth, size_t max_objects, size_t nodes, Ids& scratch_trail, Set& scratch_visited,
+            Neighbours neighbours, Expand expand, Found found)
+        {
+            // gives the buffers back to the caller when the walk ends
+            struct Borrow
+            {
+                Ids& scratch_trail;
+                Set& scratch_visited;
+                Ids trail;
+                Set visited;
+                ~Borrow()
+                {
+                    for (auto id : trail)
+                        visited.reset(id);
+                    trail.clear();
+                    scratch_trail = std::move(trail);
+                    scratch_visited = std::move(visited);
+                }
+            } borrow{ scratch_trail, scratch_visited, std::move(scratch_trail), std::move(scratch_visited) };
+            auto& trail = borrow.trail;
+            auto& visited = borrow.visited;
+            if (visited.size() < nodes)
+                visited.resize(nodes);
+            trail.push_back(start);
+            visited.set(start);
+            size_t count{ 0 };                                          // nodes reported
+            size_t depth{ 0 };                                          // distance of the nodes being expanded
+            size_t level_end{ 1 };                                      // end of the nodes at this distance in the trail
+            for (size_t head = 0; head < trail.size() && count < max_objects; ++head)
+            {
+                if (head == level_end)
+                {
+                    if (++depth == max_depth)
+                        break;
+                    level_end = trail.size();
+                }
+                auto id = trail[head];
+                if (head != 0 && !expand(id))
+                    continue;
+                for (auto next : neighbours(id))
+                    if (!visited.test(next))
+                    {
+                        visited.set(next);
+                        trail.push_back(next);
+                        found(next);
+                        if (++count == max_objects)
+                            break;
+                    }
+            }
+            return trail.size();
+        }
+    }
+
+    template <typename T>
+    class FrozenRequirements;
+
     /*! \brief Requirements is a class that handles pairs of objects for which the first object depends on the second object.
 
         Pairs are ensured to be unique.
         By default reflexivity is not allowed (objects that depend on each other) but it can be activated at construction.
         Because it does not have any sense, the reflexivity status can not be changed after instantiation.
+
+        Objects are interned: each distinct object is stored once and receives a dense node id, and relations are kept
+        as contiguous lists of ids in both directions. The id-based members give access to this representation for hot loops.
+        Ids remain valid until the instance is cleared or compacted.
+        Objects retired by remove_all() keep their slot as a tombstone until compact() reclaims it.
+
+        Traversals reuse scratch buffers owned by the instance, so const members must not be called concurrently on the same instance.
+
+        The interned objects, the lists, the scratch buffers and the lists returned by queries are allocated with Allocator,
+        so a whole instance can live in an arena such as a std::pmr::monotonic_buffer_resource (see pmr::Requirements).
+        Nested containers receive the allocator of their parent through uses-allocator construction, so stateful allocators
+        must support it, like std::pmr::polymorphic_allocator or std::scoped_allocator_adaptor.
     */
-    template <typename T>
+    template <typename T, typename Allocator = std::allocator<T>>
     class Requirements
     {
     public:
 
+        using node_id = std::uint32_t;                                                          //!< dense identifier of an interned object
+        static constexpr node_id npos = std::numeric_limits<node_id>::max();                    //!< id returned for unknown objects
+        using allocator_type = Allocator;                                                       //!< allocator of the instance
+        template <typename V>
+        using vector_type = std::vector<V, typename std::allocator_traits<Allocator>::template rebind_alloc<V>>;   //!< vector using the allocator of the instance
+        using list_type = vector_type<T>;                                                       //!< list of objects
+        using chains_type = vector_type<list_type>;                                             //!< list of lists of objects
+        using ids_type = vector_type<node_id>;                                                  //!< list of node ids
+        using table_type = std::unordered_multimap<T, T, std::hash<T>, std::equal_to<T>,
+            typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<const T, T>>>;     //!< table of pairs (dependent, requirement)
+
+        class Chains;
+        class Condensation;
+        class ClosureWalk;
+        class ChainsWalk;
+
+        /*! \brief Objects is a view on an adjacency list that gives access to the interned objects without copying them.
+
+            The view is invalidated by any modification of the relations.
+        */
+        class Objects
+        {
+        public:
+
+            /*! \brief Iterator on the objects of a list.
+            */
+            class const_iterator
+            {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const T*;
+                using reference = const T&;
+
+                const_iterator() = default;
+                reference operator*() const noexcept { return m_owner->m_nodes[*m_id]; }
+                pointer operator->() const noexcept { return &m_owner->m_nodes[*m_id]; }
+                const_iterator& operator++() noexcept { ++m_id; return *this; }
+                const_iterator operator++(int) noexcept { auto result = *this; ++m_id; return result; }
+                bool operator==(const const_iterator& other) const noexcept { return m_id == other.m_id; }
+                bool operator!=(const const_iterator& other) const noexcept { return m_id != other.m_id; }
+
+            private:
+                friend class Objects;
+                const_iterator(const Requirements<T, Allocator>* owner, const node_id* id) noexcept : m_owner(owner), m_id(id) {};
+                const Requirements<T, Allocator>* m_owner{ nullptr };
+                const node_id* m_id{ nullptr };
+            };
+
+            size_t size() const noexcept { return m_ids.size(); }                                   //!< number of objects of the list
+            bool empty() const noexcept { return m_ids.empty(); }                                   //!< true if the list has no object
+            const T& operator[](size_t pos) const noexcept { return m_owner->m_nodes[m_ids[pos]]; }     //!< object at the given position
+            const_iterator begin() const noexcept { return { m_owner, m_ids.begin() }; }            //!< iterator on the first object
+            const_iterator end() const noexcept { return { m_owner, m_ids.end() }; }                //!< iterator past the last object
+            Span<node_id> ids() const noexcept { return m_ids; }                                    //!< node ids of the objects of the list
+            list_type to_vector() const { return { begin(), end(), m_owner->get_allocator() }; }    //!< copy of the objects of the list
+
+        private:
+            friend class Requirements<T, Allocator>;
+            friend class Condensation;
+            Objects(const Requirements<T, Allocator>* owner, Span<node_id> ids) noexcept : m_owner(owner), m_ids(ids) {};
+            const Requirements<T, Allocator>* m_owner;
+            Span<node_id> m_ids;
+        };
+
+        /*! \brief Chain is a view on a branch of objects produced by Chains.
+
+            The view is only valid until the range produces the next branch. Use to_vector() to keep a copy.
+        */
+        class Chain
+        {
+        public:
+
+            /*! \brief Iterator on the objects of a branch.
+            */
+            class const_iterator
+            {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const T*;
+                using reference = const T&;
+
+                const_iterator() = default;
+                reference operator*() const noexcept { return m_owner->m_nodes[*m_id]; }
+                pointer operator->() const noexcept { return &m_owner->m_nodes[*m_id]; }
+                const_iterator& operator++() noexcept { ++m_id; return *this; }
+                const_iterator operator++(int) noexcept { auto result = *this; ++m_id; return result; }
+                bool operator==(const const_iterator& other) const noexcept { return m_id == other.m_id; }
+                bool operator!=(const const_iterator& other) const noexcept { return m_id != other.m_id; }
+
+            private:
+                friend class Chain;
+                const_iterator(const Requirements<T, Allocator>* owner, const node_id* id) noexcept : m_owner(owner), m_id(id) {};
+                const Requirements<T, Allocator>* m_owner{ nullptr };
+                const node_id* m_id{ nullptr };
+            };
+
+            size_t size() const noexcept { return m_ids->size(); }                                  //!< number of objects of the branch
+            const T& operator[](size_t pos) const noexcept { return m_owner->m_nodes[(*m_ids)[pos]]; }   //!< object at the given position
+            const T& front() const noexcept { return (*this)[0]; }                                  //!< first object of the branch
+            const T& back() const noexcept { return (*this)[size() - 1]; }                          //!< last object of the branch
+            const_iterator begin() const noexcept { return { m_owner, m_ids->data() }; }            //!< iterator on the first object
+            const_iterator end() const noexcept { return { m_owner, m_ids->data() + m_ids->size() }; }   //!< iterator past the last object
+            const std::vector<node_id>& ids() const noexcept { return *m_ids; }                     //!< node ids of the objects of the branch
+            list_type to_vector() const { return { begin(), end(), m_owner->get_allocator() }; }    //!< copy of the objects of the branch
+
+        private:
+            friend class Chains;
+            Chain(const Requirements<T, Allocator>* owner, const std::vector<node_id>* ids) noexcept : m_owner(owner), m_ids(ids) {};
+            const Requirements<T, Allocator>* m_owner;
+            const std::vector<node_id>* m_ids;
+        };
+
+        /*! \brief Chains is a range that produces branches of objects one at a time.
+
+            Branches are built in a single path buffer by a depth-first walk, so memory does not depend on the number of branches
+            and the walk can be stopped at any time. An object is never repeated in a branch, so the walk ends while reflexivity is active.
+            The relations must not be modified while the range is used, and the range must not be moved once iterated.
+        */
+        class Chains
+        {
+        public:
+
+            /*! \brief Input iterator on the branches of the range.
+            */
+            class iterator
+            {
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type = Chain;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = Chain;
+
+                iterator() = default;
+                Chain operator*() const noexcept { return { m_chains->m_owner, &m_chains->m_path }; }
+                iterator& operator++() { if (!m_chains->_advance()) m_chains = nullptr; return *this; }
+                void operator++(int) { ++*this; }
+                bool operator==(const iterator& other) const noexcept { return m_chains == other.m_chains; }
+                bool operator!=(const iterator& other) const noexcept { return m_chains != other.m_chains; }
+
+            private:
+                friend class Chains;
+                explicit iterator(Chains* chains) noexcept : m_chains(chains) {};
+                Chains* m_chains{ nullptr };
+            };
+
+            iterator begin();                                                                   // starts the walk
+            iterator end() noexcept { return {}; }                                              //!< iterator past the last branch
+
+        private:
+            friend class Requirements<T, Allocator>;
+            friend class ChainsWalk;
+            Chains(const Requirements<T, Allocator>& owner, bool forward, bool all, node_id root, bool without_duplicates,
+                node_id first = 0, node_id last = npos) noexcept
+                : m_owner(&owner), m_forward(forward), m_all(all), m_root(root), m_without_duplicates(without_duplicates), m_first(first), m_last(last) {};
+
+            const Requirements<T, Allocator>* m_owner;
+            bool m_forward;                                             // walks requirements if true, dependents otherwise
+            bool m_all;                                                 // walks from all roots if true, from m_root otherwise
+            node_id m_root;                                             // the only root of the walk
+            bool m_without_duplicates;
+            node_id m_first;                                            // first node id considered as a root when walking from all roots
+            node_id m_last;                                             // node id past the last one considered as a root
+            node_id m_cursor{ 0 };                                      // next root to walk
+            bool m_emitted{ false };                                    // the path holds the last branch produced
+            std::vector<node_id> m_path{};
+            std::vector<size_t> m_next{};                               // position of the next neighbour to walk for each object of the path
+            std::vector<bool> m_extended{};                             // the object of the path has been extended at least once
+            Bitset m_on_path{};
+
+            const ids_type& _neighbours(node_id id) const noexcept;
+            bool _is_root(node_id id) const noexcept;
+            void _push(node_id id);
+            void _pop() noexcept;
+            bool _advance();
+        };
+
+        /*! \brief Condensation is the acyclic graph of the strongly connected components of the relations.
+
+            A component gathers objects that all depend on each other, directly or indirectly, or a single object.
+            Components are numbered from requirements to dependents: a component only requires components with a lower index,
+            so the index order is a topological order and the walks of the condensation never loop, whatever the cycles of the relations.
+            The condensation is a copy computed in O(V+E): it is not updated by the modifications of the relations,
+            which invalidate its views on objects.
+        */
+        class Condensation
+        {
+        public:
+
+            size_t size() const noexcept { return m_member_offsets.size() - 1; }                   //!< number of components
+            node_id component(node_id id) const noexcept { return m_component[id]; }                //!< component of the object with the given node id
+            node_id component_of(const T& object) const noexcept;                                   // component of an object or npos
+            Span<node_id> members(node_id component) const noexcept { return _range(m_member_offsets, m_members, component); }     //!< node ids of the objects of a component
+            Objects objects(node_id component) const noexcept { return { m_owner, members(component) }; }      //!< objects of a component
+            bool cyclic(node_id component) const noexcept { return members(component).size() > 1; }     //!< true if the objects of a component form a cycle
+            Span<node_id> requirements(node_id component) const noexcept { return _range(m_requirement_offsets, m_requirement_targets, component); }    //!< components directly required by a component, once each
+            Span<node_id> dependents(node_id component) const noexcept { return _range(m_dependent_offsets, m_dependent_targets, component); }          //!< components that directly require a component, once each
+            ids_type transitive_requirements(node_id component) const { return _closure(component, true); }    //!< components required directly or indirectly by a component
+            ids_type transitive_dependents(node_id component) const { return _closure(component, false); }      //!< components that require a component directly or indirectly
+            vector_type<ids_type> levels() const;                                                   // groups components in levels that only require components of previous levels
+            vector_type<ids_type> requirement_chains(node_id component) const { return _chains(component, true); }   //!< branches of components from a component to components without requirement
+            vector_type<ids_type> dependency_chains(node_id component) const { return _chains(component, false); }   //!< branches of components from a component to components without dependent
+
+        private:
+            friend class Requirements<T, Allocator>;
+            explicit Condensation(const Requirements<T, Allocator>& owner);
+
+            const Requirements<T, Allocator>* m_owner;
+            ids_type m_component;                                       // node id -> component
+            vector_type<size_t> m_member_offsets;                       // component -> position of its first member, followed by the number of objects
+            ids_type m_members;
+            vector_type<size_t> m_requirement_offsets;                  // the same for the components each component requires
+            ids_type m_requirement_targets;
+            vector_type<size_t> m_dependent_offsets;                    // and for the components that require each component
+            ids_type m_dependent_targets;
+
+            static Span<node_id> _range(const vector_type<size_t>& offsets, const ids_type& targets, node_id component) noexcept
+            {
+                return { targets.data() + offsets[component], offsets[component + 1] - offsets[component] };
+            }
+            ids_type _closure(node_id component, bool forward) const;
+            vector_type<ids_type> _chains(node_id component, bool forward) const;
+        };
+
+        /*! \brief Walk holds the state shared by the walks that are resumed step by step, so that long queries can share a thread.
+
+            Each call to resume() visits a bounded number of objects and returns, the results found so far staying available.
+            A walk ends when it is complete, cancelled, or when its deadline has passed at the start of a step.
+            The walk detects the modifications of the relations, and any compact(), made between 2 steps and stops as invalidated.
+            The walk must not outlive its instance, nor be used after the instance has been moved.
+        */
+        class Walk
+        {
+        public:
+
+            /*! \brief Gets the state of the walk.
+            *   \return Running until the walk ends, then the reason why it ended
+            */
+            WalkStatus status() const noexcept { return m_status; }
+
+            /*! \brief Gets the number of objects visited so far.
+            *   \return the number of objects whose neighbours have been walked
+            */
+            size_t visited() const noexcept { return m_visited; }
+
+            /*! \brief Stops the walk, the results found so far staying available.
+            */
+            void cancel() noexcept
+            {
+                if (m_status == WalkStatus::Running)
+                    m_status = WalkStatus::Cancelled;
+            }
+
+            /*! \brief Sets the time after which the walk is not resumed anymore.
+            *   \param deadline the time checked at the start of each step
+            */
+            void set_deadline(std::chrono::steady_clock::time_point deadline) noexcept { m_deadline = deadline; }
+
+        protected:
+            explicit Walk(const Requirements<T, Allocator>& owner) noexcept
+                : m_owner(&owner), m_version(owner.m_version), m_nodes(owner.m_nodes.size()) {};
+
+            const Requirements<T, Allocator>* m_owner;
+            WalkStatus m_status{ WalkStatus::Running };
+            size_t m_visited{ 0 };
+
+            bool _proceed() noexcept;
+
+        private:
+            size_t m_version;                                           // version of the relations when the walk started
+            size_t m_nodes;                                             // number of objects when the walk started, changed by compact()
+            std::chrono::steady_clock::time_point m_deadline{ std::chrono::steady_clock::time_point::max() };
+        };
+
+        /*! \brief ClosureWalk lists the objects reachable from an object breadth-first, a bounded number of objects at each step.
+
+            The objects are the ones of transitive_requirements() or transitive_dependents() once the walk is done, in breadth-first order,
+            which is also the order of these members unless the reachability is cached: they then list the objects by node id.
+            The walk has buffers of its own, so other queries can be made on the instance between 2 steps.
+        */
+        class ClosureWalk : public Walk
+        {
+        public:
+
+            WalkStatus resume(size_t budget = 1024);                                            // visits at most budget objects
+
+            /*! \brief Gets the objects found so far.
+            *   \return the objects reached so far, in breadth-first order
+            */
+            const list_type& objects() const noexcept { return m_objects; }
+
+        private:
+            friend class Requirements<T, Allocator>;
+            ClosureWalk(const Requirements<T, Allocator>& owner, node_id start, bool forward);
+
+            node_id m_start;
+            bool m_forward;                                             // walks requirements if true, dependents otherwise
+            bool m_cycle{ false };                                      // the start object has been reached again
+            size_t m_head{ 0 };                                         // position of the next object to visit in the trail
+            ids_type m_trail;
+            Bitset m_marks{};
+            list_type m_objects;
+        };
+
+        /*! \brief ChainsWalk collects the branches produced by a Chains range, a bounded number of objects at each step.
+
+            The branches are the ones of all_requirements() or all_dependencies(), in the same order.
+        */
+        class ChainsWalk : public Walk
+        {
+        public:
+
+            explicit ChainsWalk(Chains chains);                                                 // takes the range to walk, not iterated yet
+            WalkStatus resume(size_t budget = 1024);                                            // collects branches of at most budget objects in all
+
+            /*! \brief Gets the branches collected so far.
+            *   \return the branches, in the order of the range
+            */
+            const chains_type& chains() const noexcept { return m_result; }
+
+        private:
+            std::unique_ptr<Chains> m_chains;                           // the range must not move once iterated
+            typename Chains::iterator m_iterator{};
+            bool m_started{ false };
+            chains_type m_result;
+        };
+
         /*! \brief Default constructor. Set the reflexive status to false.
         */
         Requirements() : Requirements(false) {};
@@ -38,168 +772,2993 @@ namespace Requirements
         Requirements(const bool reflexive) noexcept
             : m_reflexive(reflexive) {};
 
+        /*! \brief Constructor. Set the reflexive status to true to allow mutual dependencies.
+        *   \param reflexive sets the reflexive mode
+        *   \param allocator the allocator of the objects, lists and results of the instance
+        */
+        Requirements(const bool reflexive, const Allocator& allocator)
+            : m_ids(allocator), m_nodes(allocator), m_requirements(allocator), m_dependents(allocator),
+            m_tombstones(allocator), m_retired(allocator), m_reflexive(reflexive),
+            m_reach(allocator), m_visited(allocator), m_stack(allocator), m_trail(allocator),
+            m_position(allocator), m_order(allocator), m_region(allocator), m_labels(allocator),
+            m_journal(allocator), m_pending(allocator) {};
+
+        /*! \brief Gets the allocator of the instance.
+        *   \return a copy of the allocator
+        */
+        allocator_type get_allocator() const noexcept { return allocator_type(m_nodes.get_allocator()); }
+
         /*! \brief Informs on the reflexive status of the instance.
         *   \return true if reflexive mode is activated
         */
         bool reflexive() const noexcept { return m_reflexive; }
 
-        /*! \brief Clears all dependencies.
+        /*! \brief Clears all dependencies and interned objects.
         */
-        void clear() noexcept { m_requirements.clear(); }
+        void clear();
 
         /*! \brief Checks if the instance contains dependencies.
         *   \return true if no dependency exists
         */
-        bool empty() const noexcept { return m_requirements.empty(); }
+        bool empty() const noexcept { return m_size == 0; }
 
         /*! \brief Gets the number of dependencies of the instance.
         *   \return the number of dependencies
         */
-        size_t size() const noexcept { return m_requirements.size(); }
+        size_t size() const noexcept { return m_size; }
 
         void add(const T& dependent, const T& requirement);
+        void add(T&& dependent, T&& requirement);                                               // same as above, moving new objects into the table
+        template <typename D, typename R>
+        void emplace(D&& dependent, R&& requirement);                                           // same as add() with objects built from the arguments
         void remove(const T& dependent, const T& requirement);
         void remove_dependent(const T& dependent);
         void remove_requirement(const T& requirement);
         void remove_all(const T& object);
+        size_t compact(size_t limit = std::numeric_limits<size_t>::max());                     // reclaims the slots of the objects retired by remove_all()
+
+        /*! \brief Gets the number of objects retired by remove_all() whose slot has not been reclaimed yet.
+        *   \return the number of pending tombstones, an upper bound of the number of slots compact() can reclaim
+        */
+        size_t tombstones() const noexcept { return m_tombstones.size(); }
+
+        void shrink_to_fit();                                                                   // releases the memory allocated beyond the needs of the relations
+        MemoryUsage memory_usage() const noexcept;                                              // reports the bytes allocated by the instance, by part
+
         bool exists(const T& dependent, const T& requirement, bool recurse = false) const;           // check direct dependency
         bool has_requirements(const T& dependent) const noexcept;
         bool has_dependents(const T& requirement) const noexcept;
-        std::vector<T> requirements(const T& dependent) const;                                  // lists direct requirements of dependent
-        std::vector<T> dependents(const T& requirement) const;                                  // lists direct dependents of requirement
-        std::vector<std::vector<T>> all_requirements(const T& dependent) const;                 // returns all requirements of dependent in chains
-        std::vector<std::vector<T>> all_dependencies(const T& requirement) const;               // returns all dependencies of requirement in chains
-        std::vector<std::vector<T>> all_requirements(bool without_duplicates = true) const;       // returns all chains of requirements
-        std::vector<std::vector<T>> all_dependencies(bool without_duplicates = true) const;       // returns all chains of dependencies
-        std::unordered_multimap<T, T> get() const;                                          // returns a copy of the table of requirements
-        void set(const std::unordered_multimap<T, T>& requirements);                        // initialize the table of requirements with the one provided, performing checks
-        void merge(const std::unordered_multimap<T, T>& requirements);                      // append the table provided to the existing table of requirements
+        list_type requirements(const T& dependent) const;                                       // lists direct requirements of dependent
+        list_type dependents(const T& requirement) const;                                       // lists direct dependents of requirement
+        Objects requirements_view(const T& dependent) const noexcept;                           // views direct requirements of dependent, without copy
+        Objects dependents_view(const T& requirement) const noexcept;                           // views direct dependents of requirement, without copy
+        template <typename InputIt, typename BitsetAllocator>
+        void exists_many(InputIt first, InputIt last, BasicBitset<BitsetAllocator>& results, bool recurse = false) const;   // checks a range of pairs (dependent, requirement) at once
+        template <typename InputIt>
+        chains_type requirements_many(InputIt first, InputIt last) const;                       // lists direct requirements of each object of a range
+        chains_type all_requirements(const T& dependent) const;                                 // returns all requirements of dependent in chains
+        chains_type all_dependencies(const T& requirement) const;                               // returns all dependencies of requirement in chains
+        chains_type all_requirements(bool without_duplicates = true) const;                       // returns all chains of requirements
+        chains_type all_dependencies(bool without_duplicates = true) const;                       // returns all chains of dependencies
+        Chains requirement_chains(const T& dependent) const;                                    // same as all_requirements(dependent), one chain at a time
+        Chains dependency_chains(const T& requirement) const;                                   // same as all_dependencies(requirement), one chain at a time
+        Chains requirement_chains(bool without_duplicates = true) const;                        // same as all_requirements(without_duplicates), one chain at a time
+        Chains dependency_chains(bool without_duplicates = true) const;                         // same as all_dependencies(without_duplicates), one chain at a time
+        Chains requirement_chains(bool without_duplicates, node_id first, node_id last) const;  // same as above, from the roots with a node id in [first, last)
+        Chains dependency_chains(bool without_duplicates, node_id first, node_id last) const;   // same as above, from the roots with a node id in [first, last)
+        list_type transitive_requirements(const T& dependent) const;                             // lists direct and indirect requirements of dependent, once each
+        list_type transitive_dependents(const T& requirement) const;                            // lists direct and indirect dependents of requirement, once each
+        template <typename OutputIt>
+        OutputIt transitive_requirements(const T& dependent, OutputIt out) const;               // same as above, writing to an output iterator
+        template <typename OutputIt>
+        OutputIt transitive_dependents(const T& requirement, OutputIt out) const;               // same as above, writing to an output iterator
+        list_type impacted_dependents(const T& requirement, size_t max_depth, size_t max_objects = std::numeric_limits<size_t>::max()) const;  // lists the nearest dependents of requirement, within limits
+        template <typename Predicate>
+        list_type impacted_dependents(const T& requirement, size_t max_depth, size_t max_objects, Predicate expand) const;  // same as above, expanding only the objects accepted by expand
+        list_type topological_order() const;                                                // lists objects so that requirements come before their dependents
+        chains_type topological_levels() const;                                             // groups objects in levels that only require objects of previous levels
+        Condensation condensation() const;                                                  // computes the strongly connected components and the acyclic graph between them
+        ClosureWalk transitive_requirements_walk(const T& dependent) const;                     // same as transitive_requirements(), resumed step by step
+        ClosureWalk transitive_dependents_walk(const T& requirement) const;                     // same as transitive_dependents(), resumed step by step
+        table_type get() const;                                                             // returns a copy of the table of requirements
+        void set(const table_type& requirements);                                           // initialize the table of requirements with the one provided, performing checks
+        void set(table_type&& requirements);                                                // same as above, moving the objects out of the table provided
+        void merge(const table_type& requirements);                                         // append the table provided to the existing table of requirements
+        void merge(table_type&& requirements);                                              // same as above, moving the objects out of the table provided
+        std::vector<Violation<T>> bulk_set(const table_type& requirements);                 // same as set() but checks the whole table at once
+        std::vector<Violation<T>> bulk_merge(const table_type& requirements);               // same as merge() but checks the whole table at once
+        template <typename InputIt>
+        std::vector<Violation<T>> bulk_merge(InputIt first, InputIt last);                  // same as merge() for a range of pairs (dependent, requirement)
+        template <typename Parse>
+        std::vector<Violation<T>> bulk_merge(std::istream& input, Parse parse, size_t chunk = 1 << 20);             // same as merge() for the lines of a stream, parsed by parse
+        std::vector<Violation<T>> bulk_merge(std::istream& input, char separator = ',', size_t chunk = 1 << 20);    // same as merge() for the lines "dependent,requirement" of a stream
+        FrozenRequirements<T> freeze() const;                                               // returns an immutable copy optimized for queries
+
+#ifdef REQUIREMENTS_ENABLE_INSTRUMENTATION
+        /*! \brief Gets the counters of the work done since construction or the last reset.
+        *   \return the counters of the instance
+        */
+        const Statistics& statistics() const noexcept { return m_statistics; }
+
+        /*! \brief Resets the counters of the instance.
+        */
+        void reset_statistics() noexcept { m_statistics = {}; }
+
+        /*! \brief Sets the function called at the end of the main members, for instance to feed a tracing system.
+        *   \param hook the function called with the description of each call, or an empty function to stop tracing
+        *   \warning The hook must not throw nor modify the instance.
+        */
+        void set_trace_hook(std::function<void(const TraceSpan&)> hook) { m_trace_hook = std::move(hook); }
+#endif
+
+        // id-based access to the interned representation
+
+        /*! \brief Gets the number of interned objects, i.e. the upper bound of node ids.
+        *   \return the number of interned objects
+        */
+        size_t node_count() const noexcept { return m_nodes.size(); }
+
+        /*! \brief Gets the object interned with the given id.
+        *   \param id a node id lower than node_count()
+        *   \return the interned object
+        */
+        const T& node(node_id id) const noexcept { return m_nodes[id]; }
+
+        node_id id_of(const T& object) const noexcept;                                          // returns the id of an interned object or npos
+        bool exists_ids(node_id dependent, node_id requirement, bool recurse = false) const;     // id-based overload of exists()
+        const ids_type& requirement_ids(node_id dependent) const noexcept;                      // direct requirements of dependent as ids
+        const ids_type& dependent_ids(node_id requirement) const noexcept;                      // direct dependents of requirement as ids
+
+        void cache_reachability(bool enable);                                                   // activates the reachability cache used by recursive checks
+
+        /*! \brief Informs on the status of the reachability cache.
+        *   \return true if the reachability cache is activated
+        */
+        bool reachability_cached() const noexcept { return m_reach_cached; }
+
+        // journal of the modifications
+
+        /*! \brief Gets the version of the relations, increased by one for each relation created or removed.
+        *   \return the number of modifications since construction
+        */
+        size_t version() const noexcept { return m_version; }
+
+        void journal_changes(bool enable);                                                      // activates the journal of the modifications
+        Span<Change<T>> changes_since(size_t version) const noexcept;                           // views the modifications made after a version
+        void forget_changes(size_t version);                                                    // drops the modifications up to a version from the journal
+
+        /*! \brief Informs on the status of the journal.
+        *   \return true if the modifications are recorded
+        */
+        bool changes_journaled() const noexcept { return m_journaled; }
+
+        /*! \brief Gets the oldest version accepted by changes_since().
+        *   \return the version from which the modifications are kept
+        */
+        size_t journal_origin() const noexcept { return m_journal_origin; }
+
+        /*! \brief Sets the function called with the modifications made by each member, once it has made them all.
+        *   \param hook the function called with the new modifications, or an empty function to stop notifications
+        *   \warning The hook must not modify the instance. The view is only valid during the call.
+        */
+        void set_change_hook(std::function<void(Span<Change<T>>)> hook) { m_change_hook = std::move(hook); }
 
     private:
-        std::unordered_multimap<T, T> m_requirements{};
+        using bitset_type = BasicBitset<typename std::allocator_traits<Allocator>::template rebind_alloc<Bitset::word_type>>;
+
+        std::unordered_map<T, node_id, std::hash<T>, std::equal_to<T>,
+            typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<const T, node_id>>> m_ids{};    // object -> node id
+        list_type m_nodes{};                                            // node id -> object
+        vector_type<ids_type> m_requirements{};                         // node id -> ids of its requirements
+        vector_type<ids_type> m_dependents{};                           // node id -> ids of its dependents, reverse index kept in sync with m_requirements
+        ids_type m_tombstones{};                                        // ids retired by remove_all(), in retirement order
+        bitset_type m_retired{};                                        // node id -> retired and not reclaimed yet
+        size_t m_size{ 0 };
         bool m_reflexive{ false };
+        bool m_reach_cached{ false };
+        mutable bool m_reach_valid{ false };
+        mutable vector_type<bitset_type> m_reach{};                     // node id -> ids reachable through at least one relation
+        mutable bitset_type m_visited{};                                // scratch buffers of the traversals, left cleared after use
+        mutable ids_type m_stack{};
+        mutable ids_type m_trail{};
+        mutable vector_type<std::int64_t> m_position{};                 // node id -> position in the topological order, kept while reflexivity is not allowed
+        mutable std::deque<node_id, typename std::allocator_traits<Allocator>::template rebind_alloc<node_id>> m_order{};     // position - m_first -> node id
+        mutable std::int64_t m_first{ 0 };                              // position of the first object of the order, new requirements are placed before it
+        mutable bool m_order_valid{ true };                             // false from a compaction or a relation that would have moved too many objects, until the order is rebuilt
+        mutable size_t m_since_rebuild{ 0 };                            // relations added since the order was last rebuilt or cleared
+        ids_type m_region{};                                            // scratch buffers of the reordering
+        vector_type<std::int64_t> m_labels{};
+        size_t m_version{ 0 };
+        bool m_journaled{ false };
+        size_t m_journal_origin{ 0 };                                   // version before the first change of m_journal
+        vector_type<Change<T>> m_journal{};
+        vector_type<Change<T>> m_pending{};                             // changes of the current member, published when it ends
+        size_t m_unpublished{ 0 };                                      // number of changes of the current member
+        std::function<void(Span<Change<T>>)> m_change_hook{};
+#ifdef REQUIREMENTS_ENABLE_INSTRUMENTATION
+        mutable Statistics m_statistics{};
+        std::function<void(const TraceSpan&)> m_trace_hook{};
+
+        // calls the trace hook when the member that created it ends
+        class Tracer
+        {
+        public:
+            Tracer(const Requirements& owner, const char* operation) noexcept
+                : m_owner(owner), m_operation(operation), m_start(owner.m_trace_hook ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{}) {};
+            Tracer(const Tracer&) = delete;
+            Tracer& operator=(const Tracer&) = delete;
+            ~Tracer()
+            {
+                if (m_owner.m_trace_hook)
+                    m_owner.m_trace_hook({ m_operation, m_start, std::chrono::steady_clock::now() - m_start, &m_owner.m_statistics });
+            }
+
+        private:
+            const Requirements& m_owner;
+            const char* m_operation;
+            std::chrono::steady_clock::time_point m_start;
+        };
+#endif
+
+        // state of a bulk load between _bulk_begin() and _bulk_end()
+        struct Bulk
+        {
+            size_t nodes{ 0 };                                          // node count before the load
+            std::vector<std::pair<node_id, node_id>> relations{};      // relations inserted without checks, in insertion order
+            std::vector<Violation<T>> violations{};
+        };
+
+        template <typename U>
+        node_id _intern(U&& object);
+        template <typename D, typename R>
+        void _add(D&& dependent, R&& requirement);
+        template <typename C>
+        static size_t _bytes(const C& container) noexcept { return container.capacity() * sizeof(typename C::value_type); }
+        static void _erase(ids_type& ids, node_id id) noexcept;
+        chains_type _to_objects(const vector_type<ids_type>& chains) const;
+        chains_type _collect(Chains chains) const;
+        vector_type<ids_type> _topological_levels() const;
+        static std::optional<std::pair<T, T>> _parse(std::string_view line, char separator, size_t number);
+        static T _field(std::string_view text, size_t number);
+
+        // query of exists_many()
+        struct Query
+        {
+            node_id dependent;
+            node_id requirement;
+            size_t index;                                               // position of the query in the range
+        };
+
+        bool _requires(node_id dependent, node_id requirement) const;
+        template <typename BitsetAllocator>
+        void _requires_many(const Query* first, const Query* last, bitset_type& targets, BasicBitset<BitsetAllocator>& results) const;
+        template <typename OutputIt>
+        OutputIt _closure(node_id start, bool forward, OutputIt out) const;
+        bool _reaches(node_id dependent, node_id requirement) const;
+        bool _recording() const noexcept { return m_journaled || static_cast<bool>(m_change_hook); }     // changes are kept for the journal or the hook
+        void _record(ChangeKind kind, node_id dependent, node_id requirement);
+        void _publish();
+        void _invalidate_reachability() noexcept { m_reach_valid = false; }
+        void _update_reachability(node_id dependent, node_id requirement);
+        void _build_reachability() const;
+        ids_type _components(node_id& count) const;
+        void _place(node_id id, bool first);
+        bool _rebuild_order() const;
+        bool _reorder(node_id dependent, node_id requirement);
+        size_t _reorder_budget() const noexcept { return 64 + m_nodes.size() / 64; }    // objects moved at most by a reordering
+        size_t _rebuild_interval() const noexcept { return (m_nodes.size() + m_size) / 4; }    // relations added at least between 2 rebuilds of the order by add()
+
+        void _bulk_begin(Bulk& bulk);
+        template <typename D, typename R>
+        void _bulk_insert(Bulk& bulk, D&& dependent, R&& requirement);
+        void _bulk_end(Bulk& bulk);
+        void _bulk_duplicates(Bulk& bulk, std::vector<bool>& rejected);
+        void _bulk_implicits(Bulk& bulk, std::vector<bool>& rejected) const;
+        void _bulk_rollback(Bulk& bulk);
+    };
+
+    namespace pmr
+    {
+        /*! \brief Requirements allocating its objects, lists and results from a std::pmr::memory_resource.
+        *
+        *   The resource is given at construction, for instance Requirements::pmr::Requirements<T> req{ false, &resource };
+        */
+        template <typename T>
+        using Requirements = ::Requirements::Requirements<T, std::pmr::polymorphic_allocator<T>>;
+    }
+
+    /*! \brief FrozenRequirements is an immutable copy of a Requirements object laid out for read-heavy workloads.
+
+        Relations are stored as compressed sparse rows in both directions: the ids of the requirements of all the objects
+        follow each other in a single array, delimited by an array of offsets, and the same goes for the dependents.
+        Lists are returned as views on these arrays, so queries do not allocate and traversals walk contiguous memory.
+        Objects keep the node ids of the Requirements object they were frozen from.
+
+        Traversals use scratch buffers owned by the calling thread, so all members can be called concurrently.
+    */
+    template <typename T>
+    class FrozenRequirements
+    {
+    public:
+
+        using node_id = typename Requirements<T>::node_id;                                      //!< dense identifier of an interned object
+        static constexpr node_id npos = Requirements<T>::npos;                                  //!< id returned for unknown objects
+
+        /*! \brief Objects is a view on a list of node ids that gives access to the interned objects.
+        */
+        class Objects
+        {
+        public:
+
+            /*! \brief Iterator on the objects of a list.
+            */
+            class const_iterator
+            {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const T*;
+                using reference = const T&;
+
+                const_iterator() = default;
+                reference operator*() const noexcept { return m_owner->m_nodes[*m_id]; }
+                pointer operator->() const noexcept { return &m_owner->m_nodes[*m_id]; }
+                const_iterator& operator++() noexcept { ++m_id; return *this; }
+                const_iterator operator++(int) noexcept { auto result = *this; ++m_id; return result; }
+                bool operator==(const const_iterator& other) const noexcept { return m_id == other.m_id; }
+                bool operator!=(const const_iterator& other) const noexcept { return m_id != other.m_id; }
+
+            private:
+                friend class Objects;
+                const_iterator(const FrozenRequirements<T>* owner, const node_id* id) noexcept : m_owner(owner), m_id(id) {};
+                const FrozenRequirements<T>* m_owner{ nullptr };
+                const node_id* m_id{ nullptr };
+            };
+
+            size_t size() const noexcept { return m_ids.size(); }                                   //!< number of objects of the list
+            bool empty() const noexcept { return m_ids.empty(); }                                   //!< true if the list has no object
+            const T& operator[](size_t pos) const noexcept { return m_owner->m_nodes[m_ids[pos]]; }     //!< object at the given position
+            const_iterator begin() const noexcept { return { m_owner, m_ids.begin() }; }            //!< iterator on the first object
+            const_iterator end() const noexcept { return { m_owner, m_ids.end() }; }                //!< iterator past the last object
+            Span<node_id> ids() const noexcept { return m_ids; }                                    //!< node ids of the objects of the list
+            std::vector<T> to_vector() const { return { begin(), end() }; }                         //!< copy of the objects of the list
+
+        private:
+            friend class FrozenRequirements<T>;
+            Objects(const FrozenRequirements<T>* owner, Span<node_id> ids) noexcept : m_owner(owner), m_ids(ids) {};
+            const FrozenRequirements<T>* m_owner;
+            Span<node_id> m_ids;
+        };
+
+        /*! \brief Default constructor. Creates an empty non reflexive instance.
+        */
+        FrozenRequirements() = default;
+
+        template <typename Allocator>
+        explicit FrozenRequirements(const Requirements<T, Allocator>& requirements);            // copies the relations of a Requirements object
+
+        /*! \brief Informs on the reflexive status of the instance.
+        *   \return true if reflexive mode is activated
+        */
+        bool reflexive() const noexcept { return m_reflexive; }
+
+        /*! \brief Checks if the instance contains dependencies.
+        *   \return true if no dependency exists
+        */
+        bool empty() const noexcept { return m_requirement_targets.empty(); }
+
+        /*! \brief Gets the number of dependencies of the instance.
+        *   \return the number of dependencies
+        */
+        size_t size() const noexcept { return m_requirement_targets.size(); }
+
+        /*! \brief Gets the number of interned objects, i.e. the upper bound of node ids.
+        *   \return the number of interned objects
+        */
+        size_t node_count() const noexcept { return m_nodes.size(); }
+
+        /*! \brief Gets the object interned with the given id.
+        *   \param id a node id lower than node_count()
+        *   \return the interned object
+        */
+        const T& node(node_id id) const noexcept { return m_nodes[id]; }
+
+        node_id id_of(const T& object) const noexcept;                                          // returns the id of an interned object or npos
+        bool exists(const T& dependent, const T& requirement, bool recurse = false) const;         // checks direct or indirect dependency
+        bool exists_ids(node_id dependent, node_id requirement, bool recurse = false) const;    // id-based overload of exists()
+        bool has_requirements(const T& dependent) const noexcept;
+        bool has_dependents(const T& requirement) const noexcept;
+        Objects requirements(const T& dependent) const noexcept;                               // views direct requirements of dependent
+        Objects dependents(const T& requirement) const noexcept;                               // views direct dependents of requirement
+        Span<node_id> requirement_ids(node_id dependent) const noexcept;                        // direct requirements of dependent as ids
+        Span<node_id> dependent_ids(node_id requirement) const noexcept;                        // direct dependents of requirement as ids
+        std::vector<T> transitive_requirements(const T& dependent) const;                        // lists direct and indirect requirements of dependent, once each
+        std::vector<T> transitive_dependents(const T& requirement) const;                       // lists direct and indirect dependents of requirement, once each
+        std::vector<T> impacted_dependents(const T& requirement, size_t max_depth, size_t max_objects = std::numeric_limits<size_t>::max()) const;     // lists the nearest dependents of requirement, within limits
+        template <typename Predicate>
+        std::vector<T> impacted_dependents(const T& requirement, size_t max_depth, size_t max_objects, Predicate expand) const;     // same as above, expanding only the objects accepted by expand
+        MemoryUsage memory_usage() const noexcept;                                              // reports the bytes allocated by the instance, by part
+
+    private:
+        std::unordered_map<T, node_id> m_ids{};                         // object -> node id
+        std::vector<T> m_nodes{};                                       // node id -> object
+        std::vector<size_t> m_requirement_offsets{ 0 };                 // node id -> position of its first requirement, node_count() + 1 values
+        std::vector<node_id> m_requirement_targets{};                   // ids of the requirements of all the objects, by dependent
+        std::vector<size_t> m_dependent_offsets{ 0 };                   // node id -> position of its first dependent, node_count() + 1 values
+        std::vector<node_id> m_dependent_targets{};                     // ids of the dependents of all the objects, by requirement
+        bool m_reflexive{ false };
+
+        // scratch buffers of the traversals of the calling thread, left cleared after use
+        struct Scratch
+        {
+            Bitset visited{};
+            std::vector<node_id> stack{};
+            std::vector<node_id> trail{};
+        };
+
+        static Scratch& _scratch() noexcept;
+        std::vector<T> _closure(node_id start, bool forward) const;
+    };
+
+    // Implementation of templates classes and functions
+
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::clear()
+    {
+        if (_recording())
+        {
+            for (node_id dep = 0; dep < m_nodes.size(); ++dep)
+                for (auto req : m_requirements[dep])
+                    _record(ChangeKind::Removed, dep, req);
+        }
+        else
+            m_unpublished += m_size;
+        _publish();
+        m_ids.clear();
+        m_nodes.clear();
+        m_requirements.clear();
+        m_dependents.clear();
+        m_tombstones.clear();
+        m_retired.reset();
+        m_size = 0;
+        m_reach.clear();
+        m_reach_valid = false;
+        m_position.clear();
+        m_order.clear();
+        m_first = 0;
+        m_order_valid = true;
+        m_since_rebuild = 0;
+    }
+
+    /*! \brief Add a relation where dependent depends on requirement.
+    *   \param dependent the object that depends on the other object
+    *   \param requirement the object on which the first object depends
+    *   \warning An assertion occurs if:
+    *   \li dependent and requirements are the same object,
+    *   \li the relation already exists,
+    *   \li the opposite relation already exists while reflexivity is not allowed.
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::add(const T& dependent, const T& requirement)
+    {
+        _add(dependent, requirement);
+    }
+
+    /*! \brief Adds a relation where dependent depends on requirement, moving the objects not yet known into the table.
+    *   \param dependent,requirement the 2 objects involved in the new dependency
+    *   \sa Requirements< T >::add(const T&, const T&)
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::add(T&& dependent, T&& requirement)
+    {
+        _add(std::move(dependent), std::move(requirement));
+    }
+
+    /*! \brief Adds a relation where dependent depends on requirement, the objects being built from the arguments.
+    *   \param dependent,requirement the arguments from which the 2 objects are built, for instance a const char* for std::string
+    *   \sa Requirements< T >::add(const T&, const T&)
+    *
+    *   Each object is built once, then moved into the table if it is not known yet.
+    */
+    template <typename T, typename Allocator>
+    template <typename D, typename R>
+    void Requirements<T, Allocator>::emplace(D&& dependent, R&& requirement)
+    {
+        _add(T(std::forward<D>(dependent)), T(std::forward<R>(requirement)));
+    }
+
+    template <typename T, typename Allocator>
+    template <typename D, typename R>
+    void Requirements<T, Allocator>::_add(D&& dependent, R&& requirement)
+    {
+        REQUIREMENTS_TRACE("add");
+        assert(!(dependent == requirement) && "A requirement can't be requested for object itself.");
+        const auto nodes = m_nodes.size();
+        auto dep = _intern(std::forward<D>(dependent));
+        auto req = _intern(std::forward<R>(requirement));
+        if (!m_reflexive && m_order_valid)
+        {
+            // a new dependent can be placed last and a new requirement first, so building from either end never reorders
+            if (dep >= nodes)
+                _place(dep, false);
+            if (req >= nodes)
+                _place(req, true);
+        }
+        // we must ensure the implicit requirement does not already exist
+        assert(!_reaches(dep, req) && "(Implicit) requirement is already defined.");
+        bool rebuild{ false };
+        if (!m_reflexive)
+        {
+            // opposite requirement is only allowed if reflexivity is activated, directly or indirectly;
+            // keeping the topological order finds it as a side effect
+            bool acyclic{ !m_order_valid || _reorder(dep, req) };
+            if (!acyclic)
+                m_order_valid = false;
+            // an order given up is rebuilt with the relation, unless the previous rebuild is too recent to amortize the cost
+            ++m_since_rebuild;
+            rebuild = acyclic && !m_order_valid && m_since_rebuild >= _rebuild_interval();
+            assert(acyclic && (m_order_valid || rebuild || !_reaches(req, dep)) && "Opposite requirement cannot be set while reflexivity is not allowed.");
+        }
+        REQUIREMENTS_GROWTH(m_requirements[dep]);
+        REQUIREMENTS_GROWTH(m_dependents[req]);
+        m_requirements[dep].push_back(req);
+        m_dependents[req].push_back(dep);
+        ++m_size;
+        if (rebuild)
+        {
+            // rebuilding the order with the relation finds a cycle closed by it
+            [[maybe_unused]] bool acyclic{ _rebuild_order() };
+            assert(acyclic && "Opposite requirement cannot be set while reflexivity is not allowed.");
+        }
+        if (m_reach_cached && m_reach_valid)
+            _update_reachability(dep, req);
+        _record(ChangeKind::Added, dep, req);
+        _publish();
+    }
+
+    /*! \brief Removes an existing relation where dependent depends on requirement.
+    *   \param dependent,requirement the 2 objects involved in the dependency to remove
+    *   \warning An assertion occurs if the relation does not exist.
+    *   \warning This function does not remove the opposite relation.
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::remove(const T& dependent, const T& requirement)
+    {
+        auto dep = id_of(dependent);
+        auto req = id_of(requirement);
+        bool found = dep != npos && req != npos && exists_ids(dep, req);
+        assert(found && "Requirement does not exist.");
+        if (!found)
+            return;
+        _erase(m_requirements[dep], req);
+        _erase(m_dependents[req], dep);
+        --m_size;
+        _invalidate_reachability();
+        _record(ChangeKind::Removed, dep, req);
+        _publish();
+    }
+
+    /*! \brief Removes all relations involving the object as a dependent.
+    *   \param dependent the object that is declared as a dependent in the relations to remove
+    *   \warning An assertion occurs if no requirement has been set for this object.
+    *
+    *   Relations involving the object as a requirement are left.
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::remove_dependent(const T& dependent)
+    {
+        assert(has_requirements(dependent) && "No requirement exists for this argument.");
+        auto dep = id_of(dependent);
+        if (dep == npos)
+            return;
+        auto& reqs = m_requirements[dep];
+        for (auto req : reqs)
+        {
+            _erase(m_dependents[req], dep);
+            _record(ChangeKind::Removed, dep, req);
+        }
+        m_size -= reqs.size();
+        reqs.clear();
+        _invalidate_reachability();
+        _publish();
+    }
+
+    /*! \brief Removes all relations involving the object as a requirement.
+    *   \param requirement the object that is declared as a requirement in the relations to remove
+    *   \warning An assertion occurs if no dependent has been set for this object.
+    *
+    *   Relations involving the object as a dependent are left.
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::remove_requirement(const T& requirement)
+    {
+        assert(has_dependents(requirement) && "No requirement exists for this argument.");
+        auto req = id_of(requirement);
+        if (req == npos)
+            return;
+        auto& deps = m_dependents[req];
+        for (auto dep : deps)
+        {
+            _erase(m_requirements[dep], req);
+            _record(ChangeKind::Removed, dep, req);
+        }
+        m_size -= deps.size();
+        deps.clear();
+        _invalidate_reachability();
+        _publish();
+    }
+
+    /*! \brief Removes all existing relations involving the object as a dependent or a requirement, and retires the object.
+    *   \param object the object involved as a dependent or a requirement in the relations to remove
+    *   \sa Requirements< T >::compact()
+    *
+    *   The cost only depends on the lists of the object and of its neighbours. The lists of the object are released and
+    *   its slot is left as a tombstone: the object keeps its id until compact() reclaims the slot.
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::remove_all(const T& object)
+    {
+        REQUIREMENTS_TRACE("remove_all");
+        auto id = id_of(object);
+        if (id == npos)
+            return;
+        auto& reqs = m_requirements[id];
+        auto& deps = m_dependents[id];
+        if (!reqs.empty() || !deps.empty())
+        {
+            for (auto req : reqs)
+            {
+                _erase(m_dependents[req], id);
+                _record(ChangeKind::Removed, id, req);
+            }
+            for (auto dep : deps)
+            {
+                _erase(m_requirements[dep], id);
+                _record(ChangeKind::Removed, dep, id);
+            }
+            m_size -= reqs.size() + deps.size();
+            ids_type{ get_allocator() }.swap(reqs);
+            ids_type{ get_allocator() }.swap(deps);
+            _invalidate_reachability();
+            _publish();
+        }
+        if (!m_retired.test(id))
+        {
+            m_retired.set(id);
+            m_tombstones.push_back(id);
+        }
+    }
+
+    /*! \brief Releases the memory allocated beyond the needs of the relations.
+    *
+    *   Shrinks the lists, the table of objects, the topological order and the journal to their size, and releases the scratch buffers
+    *   of the traversals, which grow again on the next traversal. The relations, the node ids and the version are not changed.
+    *   \warning Views on lists of objects obtained before the call are invalidated.
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::shrink_to_fit()
+    {
+        REQUIREMENTS_TRACE("shrink_to_fit");
+        m_ids.rehash(0);
+        m_nodes.shrink_to_fit();
+        for (auto& reqs : m_requirements)
+            reqs.shrink_to_fit();
+        for (auto& deps : m_dependents)
+            deps.shrink_to_fit();
+        m_requirements.shrink_to_fit();
+        m_dependents.shrink_to_fit();
+        m_tombstones.shrink_to_fit();
+        m_retired.shrink_to_fit();
+        for (auto& reach : m_reach)
+            reach.shrink_to_fit();
+        m_reach.shrink_to_fit();
+        m_position.shrink_to_fit();
+        m_order.shrink_to_fit();
+        m_journal.shrink_to_fit();
+        m_pending.shrink_to_fit();
+        m_visited.resize(0);
+        m_visited.shrink_to_fit();
+        m_stack.shrink_to_fit();
+        m_trail.shrink_to_fit();
+        m_region.shrink_to_fit();
+        m_labels.shrink_to_fit();
+    }
+
+    /*! \brief Reports the bytes allocated by the instance, by part.
+    *   \return the bytes of the objects and their table, of the lists, of the topological order, of the reachability cache,
+    *   of the journal and of the scratch buffers
+    *   \sa MemoryUsage
+    */
+    template <typename T, typename Allocator>
+    MemoryUsage Requirements<T, Allocator>::memory_usage() const noexcept
+    {
+        MemoryUsage result{};
+        result.index = m_ids.bucket_count() * sizeof(void*) + m_ids.size() * (sizeof(typename decltype(m_ids)::value_type) + sizeof(void*) + sizeof(size_t))
+            + _bytes(m_nodes) + _bytes(m_tombstones) + m_retired.memory_usage();
+        result.adjacency = _bytes(m_requirements) + _bytes(m_dependents);
+        for (const auto& reqs : m_requirements)
+            result.adjacency += _bytes(reqs);
+        for (const auto& deps : m_dependents)
+            result.adjacency += _bytes(deps);
+        result.order = _bytes(m_position) + m_order.size() * sizeof(node_id);
+        result.cache = _bytes(m_reach);
+        for (const auto& reach : m_reach)
+            result.cache += reach.memory_usage();
+        result.journal = _bytes(m_journal) + _bytes(m_pending);
+        result.scratch = m_visited.memory_usage() + _bytes(m_stack) + _bytes(m_trail) + _bytes(m_region) + _bytes(m_labels);
+        return result;
+    }
+
+    /*! \brief Reclaims the slots of the objects retired by remove_all(), oldest first.
+    *   \param limit the maximum number of slots to reclaim, so that compaction can be spread over several calls
+    *   \return the number of slots reclaimed
+    *
+    *   A retired object that is involved in relations again is kept and its tombstone is dropped.
+    *   Each slot is filled with the object of the highest id, whose id changes: only the lists of its neighbours are updated,
+    *   so the cost of a slot depends on the degree of the moved object. The reachability cache is rebuilt on the next recursive check,
+    *   and the topological order in O(V+E) by the next add().
+    *   \warning Node ids obtained before the call may designate other objects afterwards.
+    */
+    template <typename T, typename Allocator>
+    size_t Requirements<T, Allocator>::compact(size_t limit)
+    {
+        REQUIREMENTS_TRACE("compact");
+        size_t reclaimed{ 0 };
+        size_t pos{ 0 };
+        for (; pos < m_tombstones.size() && reclaimed < limit; ++pos)
+        {
+            auto hole = m_tombstones[pos];
+            if (hole >= m_nodes.size() || !m_retired.test(hole))
+                continue;               // entry left by an object moved to another slot
+            m_retired.reset(hole);
+            if (!m_requirements[hole].empty() || !m_dependents[hole].empty())
+                continue;
+            auto last = static_cast<node_id>(m_nodes.size() - 1);
+            m_ids.erase(m_nodes[hole]);
+            if (hole != last)
+            {
+                for (auto req : m_requirements[last])
+                    *std::find(m_dependents[req].begin(), m_dependents[req].end(), last) = hole;
+                for (auto dep : m_dependents[last])
+                    *std::find(m_requirements[dep].begin(), m_requirements[dep].end(), last) = hole;
+                m_nodes[hole] = std::move(m_nodes[last]);
+                m_requirements[hole] = std::move(m_requirements[last]);
+                m_dependents[hole] = std::move(m_dependents[last]);
+                m_ids[m_nodes[hole]] = hole;
+                if (m_retired.test(last))
+                {
+                    // the moved object is retired too, its tombstone follows it
+                    m_retired.reset(last);
+                    m_retired.set(hole);
+                    m_tombstones.push_back(hole);
+                }
+            }
+            m_nodes.pop_back();
+            m_requirements.pop_back();
+            m_dependents.pop_back();
+            ++reclaimed;
+        }
+        m_tombstones.erase(m_tombstones.begin(), m_tombstones.begin() + pos);
+        if (reclaimed != 0)
+        {
+            m_reach_valid = false;
+            m_order_valid = false;
+            m_since_rebuild = _rebuild_interval();          // the next add() rebuilds the order with the new ids
+            if (m_tombstones.empty())
+                m_retired.reset();
+        }
+        return reclaimed;
+    }
+
+    /*! \brief Checks if a direct relationship between the given objects exists.
+    *   \param dependent,requirement the 2 objects to check
+    *   \param recurse also checks indirect dependencies when set to true, false by default
+    *   \return true if a direct relationship exists with the given direction
+    *   \sa Requirements< T >::requires()
+    */
+    template <typename T, typename Allocator>
+    bool Requirements<T, Allocator>::exists(const T& dependent, const T& requirement, bool recurse) const
+    {
+        REQUIREMENTS_TRACE("exists");
+        auto dep = id_of(dependent);
+        auto req = id_of(requirement);
+        if (dep == npos || req == npos)
+            return false;
+        return exists_ids(dep, req, recurse);
+    }
+
+    /*! \brief Checks if an object has at least one requirement.
+    *   \param dependent the object to check
+    *   \return true if at least one requirement has been found for the given object
+    */
+    template <typename T, typename Allocator>
+    bool Requirements<T, Allocator>::has_requirements(const T& dependent) const noexcept
+    {
+        auto dep = id_of(dependent);
+        return dep != npos && !m_requirements[dep].empty();
+    }
+
+    /*! \brief Checks if an object as at least one dependent.
+    *   \param requirement the object to check
+    *   \return true if at least one dependent has been found for the given object
+    */
+    template <typename T, typename Allocator>
+    bool Requirements<T, Allocator>::has_dependents(const T& requirement) const noexcept
+    {
+        auto req = id_of(requirement);
+        return req != npos && !m_dependents[req].empty();
+    }
+
+    /*! \brief Lists the direct requirements of an object.
+    *   \param dependent the object for which direct requirements are searched for
+    *   \return the list of its direct requirements
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::list_type Requirements<T, Allocator>::requirements(const T& dependent) const
+    {
+        list_type result{ get_allocator() };
+        auto dep = id_of(dependent);
+        if (dep == npos)
+            return result;
+        result.reserve(m_requirements[dep].size());
+        for (auto req : m_requirements[dep])
+            result.push_back(m_nodes[req]);
+        return result;
+    }
+
+    /*! \brief Lists the direct dependents of an object.
+    *   \param requirement the object for which direct dependents are searched for
+    *   \return the list of its direct dependents
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::list_type Requirements<T, Allocator>::dependents(const T& requirement) const
+    {
+        list_type result{ get_allocator() };
+        auto req = id_of(requirement);
+        if (req == npos)
+            return result;
+        result.reserve(m_dependents[req].size());
+        for (auto dep : m_dependents[req])
+            result.push_back(m_nodes[dep]);
+        return result;
+    }
+
+    /*! \brief Views the direct requirements of an object, without copying them.
+    *   \param dependent the object for which direct requirements are searched for
+    *   \return the view on its direct requirements, empty if the object is unknown
+    *   \sa Requirements< T >::requirements()
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::Objects Requirements<T, Allocator>::requirements_view(const T& dependent) const noexcept
+    {
+        auto dep = id_of(dependent);
+        if (dep == npos)
+            return { this, {} };
+        return { this, { m_requirements[dep].data(), m_requirements[dep].size() } };
+    }
+
+    /*! \brief Views the direct dependents of an object, without copying them.
+    *   \param requirement the object for which direct dependents are searched for
+    *   \return the view on its direct dependents, empty if the object is unknown
+    *   \sa Requirements< T >::dependents()
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::Objects Requirements<T, Allocator>::dependents_view(const T& requirement) const noexcept
+    {
+        auto req = id_of(requirement);
+        if (req == npos)
+            return { this, {} };
+        return { this, { m_dependents[req].data(), m_dependents[req].size() } };
+    }
+
+    /*! \brief Checks a range of pairs (dependent, requirement) at once.
+    *   \param first,last the range of pairs to check
+    *   \param results receives at the position of each pair in the range true if the relation exists, grown if needed
+    *   \param recurse also checks indirect dependencies when set to true, false by default
+    *   \sa Requirements< T >::exists()
+    *
+    *   Recursive queries are grouped by dependent and each group is answered by a single walk from its dependent,
+    *   stopped once all the requirements of the group have been reached. When the reachability cache is active,
+    *   each query is a single bit test instead.
+    */
+    template <typename T, typename Allocator>
+    template <typename InputIt, typename BitsetAllocator>
+    void Requirements<T, Allocator>::exists_many(InputIt first, InputIt last, BasicBitset<BitsetAllocator>& results, bool recurse) const
+    {
+        REQUIREMENTS_TRACE("exists_many");
+        vector_type<Query> queries{ get_allocator() };
+        size_t count{ 0 };
+        for (; first != last; ++first, ++count)
+        {
+            results.reset(count);
+            auto dep = id_of((*first).first);
+            auto req = id_of((*first).second);
+            if (dep != npos && req != npos)
+                queries.push_back({ dep, req, count });
+        }
+        if (!recurse || m_reach_cached)
+        {
+            for (const auto& query : queries)
+                if (exists_ids(query.dependent, query.requirement, recurse))
+                    results.set(query.index);
+            return;
+        }
+        std::sort(queries.begin(), queries.end(), [](const Query& a, const Query& b) { return a.dependent < b.dependent; });
+        bitset_type targets{ m_nodes.size(), get_allocator() };
+        for (size_t begin = 0, end = 0; begin < queries.size(); begin = end)
+        {
+            while (end < queries.size() && queries[end].dependent == queries[begin].dependent)
+                ++end;
+            _requires_many(queries.data() + begin, queries.data() + end, targets, results);
+        }
+    }
+
+    /*! \brief Lists the direct requirements of each object of a range.
+    *   \param first,last the range of objects for which direct requirements are searched for
+    *   \return the direct requirements of each object, in the order of the range, empty for unknown objects
+    *   \sa Requirements< T >::requirements()
+    */
+    template <typename T, typename Allocator>
+    template <typename InputIt>
+    typename Requirements<T, Allocator>::chains_type Requirements<T, Allocator>::requirements_many(InputIt first, InputIt last) const
+    {
+        chains_type result{ get_allocator() };
+        for (; first != last; ++first)
+            result.push_back(requirements(*first));
+        return result;
+    }
+
+    /*! \brief Lists the branches of objects on which the object depends, directly or indirectly.
+    *   \param dependent the object for which direct or indirect requirements are searched for
+    *   \return the list of requirement branches starting with the given object
+    *   \warning An assertion occurs if the object has no direct requirement.
+    *   \sa Requirements< T >::requirement_chains()
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type Requirements<T, Allocator>::all_requirements(const T& dependent) const
+    {
+        REQUIREMENTS_TRACE("all_requirements");
+        return _collect(requirement_chains(dependent));
+    }
+
+    /*! \brief Lists the branches of objects that requires the object, directly or indirectly.
+    *   \param requirement the object for which direct or indirect dependents are searched for
+    *   \return the list of dependent branches starting with the given object
+    *   \warning An assertion occurs if the objects has no direct dependent.
+    *   \sa Requirements< T >::dependency_chains()
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type Requirements<T, Allocator>::all_dependencies(const T& requirement) const
+    {
+        REQUIREMENTS_TRACE("all_dependencies");
+        return _collect(dependency_chains(requirement));
+    }
+
+    /*! \brief Lists all branches of dependencies, from dependents to requirements.
+    *   \param without_duplicates if true only objects that have no dependents are considered as first element of a branch
+    *   \return the list of all branches, from dependents to requirements
+    *   \sa Requirements< T >::requirement_chains()
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type Requirements<T, Allocator>::all_requirements(bool without_duplicates) const
+    {
+        REQUIREMENTS_TRACE("all_requirements");
+        return _collect(requirement_chains(without_duplicates));
+    }
+
+    /*! \brief Lists all branches of dependencies, from requirements to dependents.
+    *   \param without_duplicates if true only objects that not depends on another object are considered as first element of a branch
+    *   \return the list of all branches, from requirements to dependents
+    *   \sa Requirements< T >::dependency_chains()
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type Requirements<T, Allocator>::all_dependencies(bool without_duplicates) const
+    {
+        REQUIREMENTS_TRACE("all_dependencies");
+        return _collect(dependency_chains(without_duplicates));
+    }
+
+    /*! \brief Produces the branches of objects on which the object depends, one at a time.
+    *   \param dependent the object for which direct or indirect requirements are searched for
+    *   \return the range of requirement branches starting with the given object
+    *   \warning An assertion occurs if the object has no direct requirement.
+    *
+    *   A branch ends with an object that has no requirement, or whose requirements are all already in the branch.
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::Chains Requirements<T, Allocator>::requirement_chains(const T& dependent) const
+    {
+        assert(has_requirements(dependent) && "No requirement exists for this argument.");
+        auto dep = id_of(dependent);
+        return { *this, true, false, dep, false };
+    }
+
+    /*! \brief Produces the branches of objects that requires the object, one at a time.
+    *   \param requirement the object for which direct or indirect dependents are searched for
+    *   \return the range of dependent branches starting with the given object
+    *   \warning An assertion occurs if the objects has no direct dependent.
+    *
+    *   A branch ends with an object that has no dependent, or whose dependents are all already in the branch.
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::Chains Requirements<T, Allocator>::dependency_chains(const T& requirement) const
+    {
+        assert(has_dependents(requirement) && "No dependent exists for this argument.");
+        auto req = id_of(requirement);
+        return { *this, false, false, req, false };
+    }
+
+    /*! \brief Produces all branches of dependencies, from dependents to requirements, one at a time.
+    *   \param without_duplicates if true only objects that have no dependents are considered as first element of a branch
+    *   \return the range of all branches, from dependents to requirements
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::Chains Requirements<T, Allocator>::requirement_chains(bool without_duplicates) const
+    {
+        return { *this, true, true, npos, without_duplicates };
+    }
+
+    /*! \brief Produces all branches of dependencies, from requirements to dependents, one at a time.
+    *   \param without_duplicates if true only objects that not depends on another object are considered as first element of a branch
+    *   \return the range of all branches, from requirements to dependents
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::Chains Requirements<T, Allocator>::dependency_chains(bool without_duplicates) const
+    {
+        return { *this, false, true, npos, without_duplicates };
+    }
+
+    /*! \brief Produces the branches of dependencies, from dependents to requirements, that start with a range of node ids.
+    *   \param without_duplicates if true only objects that have no dependents are considered as first element of a branch
+    *   \param first,last the range of node ids of the first elements of the branches
+    *   \return the range of the branches, from dependents to requirements
+    *
+    *   Consecutive ranges of node ids produce, one after the other, the same branches as requirement_chains(without_duplicates),
+    *   so the walk can be split between threads.
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::Chains Requirements<T, Allocator>::requirement_chains(bool without_duplicates, node_id first, node_id last) const
+    {
+        return { *this, true, true, npos, without_duplicates, first, last };
+    }
+
+    /*! \brief Produces the branches of dependencies, from requirements to dependents, that start with a range of node ids.
+    *   \param without_duplicates if true only objects that not depends on another object are considered as first element of a branch
+    *   \param first,last the range of node ids of the first elements of the branches
+    *   \return the range of the branches, from requirements to dependents
+    *   \sa Requirements< T >::requirement_chains(bool, node_id, node_id)
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::Chains Requirements<T, Allocator>::dependency_chains(bool without_duplicates, node_id first, node_id last) const
+    {
+        return { *this, false, true, npos, without_duplicates, first, last };
+    }
+
+    /*! \brief Lists the objects on which the object depends, directly or indirectly, each object once.
+    *   \param dependent the object for which direct or indirect requirements are searched for
+    *   \return the list of its direct and indirect requirements, in no particular order
+    *   \sa Requirements< T >::transitive_requirements(const T&, OutputIt)
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::list_type Requirements<T, Allocator>::transitive_requirements(const T& dependent) const
+    {
+        REQUIREMENTS_TRACE("transitive_requirements");
+        list_type result{ get_allocator() };
+        transitive_requirements(dependent, std::back_inserter(result));
+        return result;
+    }
+
+    /*! \brief Lists the objects that depend on the object, directly or indirectly, each object once.
+    *   \param requirement the object for which direct or indirect dependents are searched for
+    *   \return the list of its direct and indirect dependents, in no particular order
+    *   \sa Requirements< T >::transitive_dependents(const T&, OutputIt)
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::list_type Requirements<T, Allocator>::transitive_dependents(const T& requirement) const
+    {
+        REQUIREMENTS_TRACE("transitive_dependents");
+        list_type result{ get_allocator() };
+        transitive_dependents(requirement, std::back_inserter(result));
+        return result;
+    }
+
+    /*! \brief Writes the objects on which the object depends, directly or indirectly, each object once.
+    *   \param dependent the object for which direct or indirect requirements are searched for
+    *   \param out the output iterator that receives the objects
+    *   \return the output iterator past the last object written
+    *
+    *   The object itself is written if it belongs to a cycle. The walk visits each relation at most once,
+    *   and reads the reachability cache instead when it is activated.
+    */
+    template <typename T, typename Allocator>
+    template <typename OutputIt>
+    OutputIt Requirements<T, Allocator>::transitive_requirements(const T& dependent, OutputIt out) const
+    {
+        auto dep = id_of(dependent);
+        if (dep == npos)
+            return out;
+        if (m_reach_cached)
+        {
+            if (!m_reach_valid)
+                _build_reachability();
+            const auto& reach = m_reach[dep];
+            for (auto pos = reach.find_next(0); pos != Bitset::npos; pos = reach.find_next(pos + 1))
+                *out++ = m_nodes[pos];
+            return out;
+        }
+        return _closure(dep, true, out);
+    }
+
+    /*! \brief Writes the objects that depend on the object, directly or indirectly, each object once.
+    *   \param requirement the object for which direct or indirect dependents are searched for
+    *   \param out the output iterator that receives the objects
+    *   \return the output iterator past the last object written
+    *
+    *   The object itself is written if it belongs to a cycle. The walk visits each relation at most once.
+    */
+    template <typename T, typename Allocator>
+    template <typename OutputIt>
+    OutputIt Requirements<T, Allocator>::transitive_dependents(const T& requirement, OutputIt out) const
+    {
+        auto req = id_of(requirement);
+        if (req == npos)
+            return out;
+        return _closure(req, false, out);
+    }
+
+    /*! \brief Lists the objects that depend on the object, nearest first, within a depth and a number of objects.
+    *   \param requirement the object that changes
+    *   \param max_depth the maximum number of relations between the object and a dependent listed, 1 for its direct dependents only
+    *   \param max_objects the maximum number of dependents listed
+    *   \return the dependents found, by increasing distance, the object itself excluded
+    *   \sa Requirements< T >::impacted_dependents(const T&, size_t, size_t, Predicate)
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::list_type Requirements<T, Allocator>::impacted_dependents(const T& requirement, size_t max_depth, size_t max_objects) const
+    {
+        return impacted_dependents(requirement, max_depth, max_objects, [](const T&) { return true; });
+    }
+
+    /*! \brief Lists the objects that depend on the object, nearest first, within limits and stopping at the objects rejected by a predicate.
+    *   \param requirement the object that changes
+    *   \param max_depth the maximum number of relations between the object and a dependent listed, 1 for its direct dependents only
+    *   \param max_objects the maximum number of dependents listed
+    *   \param expand the function called with each dependent before the walk goes through it, that returns false to stop there
+    *   \return the dependents found, by increasing distance, the object itself excluded
+    *
+    *   The walk is breadth-first and stops as soon as a limit is reached, so its cost depends on the limits and not on
+    *   the size of the whole closure. A dependent rejected by expand is listed, but its own dependents are only listed
+    *   if they can be reached through other dependents. A result of max_objects objects may be truncated.
+    *   The dependents found at the last depth or after the last object listed are not passed to expand. expand may query
+    *   the instance, and an exception thrown by it leaves the instance unchanged.
+    */
+    template <typename T, typename Allocator>
+    template <typename Predicate>
+    typename Requirements<T, Allocator>::list_type Requirements<T, Allocator>::impacted_dependents(const T& requirement, size_t max_depth, size_t max_objects, Predicate expand) const
+    {
+        REQUIREMENTS_TRACE("impacted_dependents");
+        list_type result{ get_allocator() };
+        auto start = id_of(requirement);
+        if (start == npos || max_depth == 0 || max_objects == 0)
+            return result;
+        [[maybe_unused]] auto visited = detail::bounded_walk(start, max_depth, max_objects, m_nodes.size(), m_trail, m_visited,
+            [this](node_id id) -> const ids_type& { return m_dependents[id]; },
+            [this, &expand](node_id id) { return static_cast<bool>(expand(m_nodes[id])); },
+            [this, &result](node_id id) { result.push_back(m_nodes[id]); });
+        REQUIREMENTS_COUNT(walks, 1);
+        REQUIREMENTS_COUNT(visited, visited);
+        REQUIREMENTS_PEAK(peak_visited, visited);
+        return result;
+    }
+
+    /*! \brief Lists the objects involved in relations so that each object comes after all its requirements.
+    *   \return the objects in topological order, from requirements to dependents
+    *   \warning An assertion occurs if relations form a cycle, which is only possible while reflexivity is allowed.
+    *   \sa Requirements< T >::topological_levels()
+    *
+    *   While reflexivity is not allowed, add() and the bulk loads keep an order of all the objects up to date, so the list is read from it in O(V).
+    *   The order is only rebuilt here in O(V+E) after a compaction that no relation has been added since, or while add() defers its rebuild.
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::list_type Requirements<T, Allocator>::topological_order() const
+    {
+        REQUIREMENTS_TRACE("topological_order");
+        list_type result{ get_allocator() };
+        if (!m_reflexive && (m_order_valid || _rebuild_order()))
+        {
+            for (auto id : m_order)
+                if (!m_requirements[id].empty() || !m_dependents[id].empty())
+                    result.push_back(m_nodes[id]);
+            return result;
+        }
+        for (const auto& level : _topological_levels())
+            for (auto id : level)
+                result.push_back(m_nodes[id]);
+        return result;
+    }
+
+    /*! \brief Groups the objects involved in relations by levels: the requirements of an object all belong to previous levels.
+    *   \return the levels, the first one gathering the objects without requirement
+    *   \warning An assertion occurs if relations form a cycle, which is only possible while reflexivity is allowed.
+    *
+    *   Objects of a level do not depend on each other and can be processed in parallel once the previous levels are done.
+    *   Each object is placed in the earliest possible level, computed in O(V+E).
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type Requirements<T, Allocator>::topological_levels() const
+    {
+        REQUIREMENTS_TRACE("topological_levels");
+        return _to_objects(_topological_levels());
+    }
+
+    /*! \brief Computes the strongly connected components of the relations and the acyclic graph between them.
+    *   \return the condensation of the relations
+    *
+    *   While reflexivity is allowed, transitive queries and scheduling can be run on the condensation in time linear in its size,
+    *   and its branches never go around a cycle, whose simple paths can be exponentially many.
+    *   \sa Requirements< T >::Condensation
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::Condensation Requirements<T, Allocator>::condensation() const
+    {
+        REQUIREMENTS_TRACE("condensation");
+        return Condensation{ *this };
+    }
+
+    /*! \brief Starts a walk that lists the objects on which the object depends, directly or indirectly, a few objects at each step.
+    *   \param dependent the object for which direct or indirect requirements are searched for
+    *   \return the walk, not resumed yet, or already done if the object is unknown
+    *   \sa Requirements< T >::transitive_requirements()
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::ClosureWalk Requirements<T, Allocator>::transitive_requirements_walk(const T& dependent) const
+    {
+        return ClosureWalk{ *this, id_of(dependent), true };
+    }
+
+    /*! \brief Starts a walk that lists the objects that depend on the object, directly or indirectly, a few objects at each step.
+    *   \param requirement the object for which direct or indirect dependents are searched for
+    *   \return the walk, not resumed yet, or already done if the object is unknown
+    *   \sa Requirements< T >::transitive_dependents()
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::ClosureWalk Requirements<T, Allocator>::transitive_dependents_walk(const T& requirement) const
+    {
+        return ClosureWalk{ *this, id_of(requirement), false };
+    }
+
+    /*! \brief List all pairs of objects (dependent, requirement).
+    *   \return the list of requested pairs
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::table_type Requirements<T, Allocator>::get() const
+    {
+        table_type result{ get_allocator() };
+        result.reserve(m_size);
+        for (node_id dep = 0; dep < m_nodes.size(); ++dep)
+            for (auto req : m_requirements[dep])
+                result.insert({ m_nodes[dep], m_nodes[req] });
+        return result;
+    }
+
+    /*! \brief Sets dependencies from the given list. The list of dependencies is first cleared.
+    *   \param requirements the list of pairs (dependent, requirement) to create
+    *   \warning Controls are performed and an assertion occurs if rules are broken.
+    *   \sa Requirements< T >::add()
+        \sa Requirements< T >::merge()
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::set(const table_type& requirements)
+    {
+        clear();
+        merge(requirements);
+    }
+
+    /*! \brief Adds dependencies from the given list.
+    *   \param requirements the list of pairs (dependent, requirement) to add
+    *   \warning Controls are performed and an assertion occurs if rules are broken.
+    *   \sa Requirements< T >::add()
+        \sa Requirements< T >::set()
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::merge(const table_type& requirements)
+    {
+        auto itr = requirements.begin();
+        while (itr != requirements.end())
+        {
+            add((*itr).first, (*itr).second);
+            ++itr;
+        }
+    }
+
+    /*! \brief Sets dependencies from the given list, moving its objects. The list of dependencies is first cleared.
+    *   \param requirements the list of pairs (dependent, requirement) to create, left empty
+    *   \sa Requirements< T >::set(const table_type&)
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::set(table_type&& requirements)
+    {
+        clear();
+        merge(std::move(requirements));
+    }
+
+    /*! \brief Adds dependencies from the given list, moving its objects.
+    *   \param requirements the list of pairs (dependent, requirement) to add, left empty
+    *   \sa Requirements< T >::merge(const table_type&)
+    *
+    *   The pairs are extracted from the list one at a time, so their objects are moved instead of copied.
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::merge(table_type&& requirements)
+    {
+        while (!requirements.empty())
+        {
+            auto relation = requirements.extract(requirements.begin());
+            _add(std::move(relation.key()), std::move(relation.mapped()));
+        }
+    }
+
+    /*! \brief Sets dependencies from the given list, checking all the rules at once. The list of dependencies is first cleared.
+    *   \param requirements the list of pairs (dependent, requirement) to create
+    *   \return the relations that break a rule, empty on success
+    *   \sa Requirements< T >::bulk_merge()
+    *
+    *   If a rule is broken, no relation is created and the previous dependencies are restored.
+    */
+    template <typename T, typename Allocator>
+    std::vector<Violation<T>> Requirements<T, Allocator>::bulk_set(const table_type& requirements)
+    {
+        Requirements<T, Allocator> previous{ std::move(*this) };
+        clear();
+        m_reflexive = previous.m_reflexive;
+        m_reach_cached = previous.m_reach_cached;
+#ifdef REQUIREMENTS_ENABLE_INSTRUMENTATION
+        m_statistics = previous.m_statistics;
+        m_trace_hook = previous.m_trace_hook;
+#endif
+        m_version = previous.m_version;
+        m_journaled = previous.m_journaled;
+        m_journal_origin = previous.m_journal_origin;
+        m_journal = std::move(previous.m_journal);
+        m_change_hook = std::move(previous.m_change_hook);
+        // the previous relations are removed in the same publication as the creation of the new ones
+        if (_recording())
+            for (node_id dep = 0; dep < previous.m_nodes.size(); ++dep)
+                for (auto req : previous.m_requirements[dep])
+                    m_pending.push_back({ 0, ChangeKind::Removed, previous.m_nodes[dep], previous.m_nodes[req] });
+        m_unpublished = previous.m_size;
+        auto result = bulk_merge(requirements);
+        if (!result.empty())
+        {
+            previous.m_journal = std::move(m_journal);
+            previous.m_change_hook = std::move(m_change_hook);
+            *this = std::move(previous);
+        }
+        return result;
+    }
+
+    /*! \brief Adds dependencies from the given list, checking all the rules at once.
+    *   \param requirements the list of pairs (dependent, requirement) to add
+    *   \return the relations that break a rule, empty on success
+    *   \sa Requirements< T >::bulk_merge(InputIt, InputIt)
+    */
+    template <typename T, typename Allocator>
+    std::vector<Violation<T>> Requirements<T, Allocator>::bulk_merge(const table_type& requirements)
+    {
+        return bulk_merge(requirements.begin(), requirements.end());
+    }
+
+    /*! \brief Adds dependencies from a range of pairs, checking all the rules at once.
+    *   \param first,last the range of pairs (dependent, requirement) to add
+    *   \return the relations that break a rule, empty on success
+    *   \sa Requirements< T >::merge()
+    *
+    *   Unlike merge(), relations are first inserted without any check, then the rules of add() are verified in one pass
+    *   over the whole batch: strongly connected components give the cycles, and pruned walks on the condensed graph
+    *   give the relations implied by other relations. All broken rules are reported instead of asserting on the first one.
+    *   A relation of the batch is an implicit duplicate if its requirement can be reached from its dependent
+    *   without using it, whatever the order of the batch.
+    *   If a rule is broken, none of the relations of the batch is kept.
+    */
+    template <typename T, typename Allocator>
+    template <typename InputIt>
+    std::vector<Violation<T>> Requirements<T, Allocator>::bulk_merge(InputIt first, InputIt last)
+    {
+        REQUIREMENTS_TRACE("bulk_merge");
+        Bulk bulk{};
+        _bulk_begin(bulk);
+        for (; first != last; ++first)
+            _bulk_insert(bulk, (*first).first, (*first).second);
+        _bulk_end(bulk);
+        return std::move(bulk.violations);
+    }
+
+    /*! \brief Adds dependencies read from a stream, one relation per line, checking all the rules at once.
+    *   \param input the stream to read
+    *   \param parse the function that converts a line, without its end of line, to an optional pair (dependent, requirement),
+    *   empty to skip the line; it can throw to reject the stream
+    *   \param chunk the number of bytes read from the stream at once
+    *   \return the relations that break a rule, empty on success
+    *   \sa Requirements< T >::bulk_merge(InputIt, InputIt)
+    *
+    *   The stream is read in chunks and each relation is inserted as soon as its line is complete, so the memory used
+    *   by the load does not depend on the size of the stream, apart from the relations themselves.
+    *   If parse throws, none of the relations read is kept and the exception is rethrown.
+    */
+    template <typename T, typename Allocator>
+    template <typename Parse>
+    std::vector<Violation<T>> Requirements<T, Allocator>::bulk_merge(std::istream& input, Parse parse, size_t chunk)
+    {
+        REQUIREMENTS_TRACE("bulk_merge");
+        Bulk bulk{};
+        _bulk_begin(bulk);
+        std::vector<char> buffer(std::max<size_t>(chunk, 1));
+        std::string carry{};                                            // beginning of a line split between 2 chunks
+        auto process = [&](std::string_view line)
+        {
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            auto relation = parse(line);
+            if (relation)
+                _bulk_insert(bulk, std::move((*relation).first), std::move((*relation).second));
+        };
+        try
+        {
+            while (input)
+            {
+                input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                std::string_view data{ buffer.data(), static_cast<size_t>(input.gcount()) };
+                size_t start{ 0 };
+                for (auto end = data.find('\n'); end != std::string_view::npos; end = data.find('\n', start))
+                {
+                    if (carry.empty())
+                        process(data.substr(start, end - start));
+                    else
+                    {
+                        carry.append(data.substr(start, end - start));
+                        process(carry);
+                        carry.clear();
+                    }
+                    start = end + 1;
+                }
+                carry.append(data.substr(start));
+            }
+            if (!carry.empty())
+                process(carry);
+        }
+        catch (...)
+        {
+            _bulk_rollback(bulk);
+            throw;
+        }
+        _bulk_end(bulk);
+        return std::move(bulk.violations);
+    }
+
+    /*! \brief Adds dependencies read from a text stream, checking all the rules at once.
+    *   \param input the stream to read, with one relation "dependent,requirement" per line
+    *   \param separator the character between the 2 objects of a relation
+    *   \param chunk the number of bytes read from the stream at once
+    *   \return the relations that break a rule, empty on success
+    *   \exception std::invalid_argument if a line can not be read, in which case none of the relations read is kept
+    *   \sa Requirements< T >::bulk_merge(std::istream&, Parse, size_t)
+    *
+    *   Spaces around the objects are ignored, as well as empty lines and lines starting with '#'.
+    *   Objects are read as is for std::string, with std::from_chars for integers and with operator>> otherwise.
+    */
+    template <typename T, typename Allocator>
+    std::vector<Violation<T>> Requirements<T, Allocator>::bulk_merge(std::istream& input, char separator, size_t chunk)
+    {
+        size_t number{ 0 };
+        return bulk_merge(input, [separator, &number](std::string_view line) { return _parse(line, separator, ++number); }, chunk);
+    }
+
+    /*! \brief Copies the relations to an immutable instance optimized for queries.
+    *   \return the frozen copy
+    *   \sa FrozenRequirements
+    */
+    template <typename T, typename Allocator>
+    FrozenRequirements<T> Requirements<T, Allocator>::freeze() const
+    {
+        return FrozenRequirements<T>{ *this };
+    }
+
+    /*! \brief Gets the node id of an interned object.
+    *   \param object the object to look for
+    *   \return its node id, or npos if the object has never been involved in a relation
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::node_id Requirements<T, Allocator>::id_of(const T& object) const noexcept
+    {
+        REQUIREMENTS_COUNT(lookups, 1);
+        auto itr = m_ids.find(object);
+        return itr == m_ids.end() ? npos : (*itr).second;
+    }
+
+    /*! \brief Checks if a relationship between the given node ids exists.
+    *   \param dependent,requirement the ids of the 2 objects to check
+    *   \param recurse also checks indirect dependencies when set to true, false by default
+    *   \return true if a relationship exists with the given direction
+    *   \sa Requirements< T >::exists()
+    */
+    template <typename T, typename Allocator>
+    bool Requirements<T, Allocator>::exists_ids(node_id dependent, node_id requirement, bool recurse) const
+    {
+        if (recurse)
+            return _reaches(dependent, requirement);
+        const auto& reqs = m_requirements[dependent];
+        return std::find(reqs.begin(), reqs.end(), requirement) != reqs.end();
+    }
+
+    /*! \brief Lists the ids of the direct requirements of a node.
+    *   \param dependent the id of the object for which direct requirements are searched for
+    *   \return the ids of its direct requirements
+    */
+    template <typename T, typename Allocator>
+    const typename Requirements<T, Allocator>::ids_type& Requirements<T, Allocator>::requirement_ids(node_id dependent) const noexcept
+    {
+        return m_requirements[dependent];
+    }
+
+    /*! \brief Lists the ids of the direct dependents of a node.
+    *   \param requirement the id of the object for which direct dependents are searched for
+    *   \return the ids of its direct dependents
+    */
+    template <typename T, typename Allocator>
+    const typename Requirements<T, Allocator>::ids_type& Requirements<T, Allocator>::dependent_ids(node_id requirement) const noexcept
+    {
+        return m_dependents[requirement];
+    }
+
+    /*! \brief Activates or deactivates the reachability cache.
+    *   \param enable true to activate the cache, false to release it
+    *
+    *   When activated, the set of objects reachable from each object is kept in a bitset, so recursive checks
+    *   (including the ones performed by add()) are answered by a single bit test.
+    *   The cache is updated incrementally by add(), invalidated by the remove functions and rebuilt on the next recursive check.
+    *   \warning The cache needs node_count() squared bits of memory.
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::cache_reachability(bool enable)
+    {
+        m_reach_cached = enable;
+        m_reach_valid = false;
+        if (!enable)
+            vector_type<bitset_type>{ get_allocator() }.swap(m_reach);
+    }
+
+    /*! \brief Activates or deactivates the journal of the modifications of the relations.
+    *   \param enable true to record the modifications from the current version, false to stop and drop the journal
+    *   \sa Requirements< T >::changes_since()
+    *
+    *   The journal lets downstream consumers update what they derived from the relations with only the relations
+    *   created or removed since the version they last processed, instead of comparing copies of the whole table.
+    *   \warning The journal grows with each modification until forget_changes() is called.
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::journal_changes(bool enable)
+    {
+        m_journaled = enable;
+        m_journal_origin = m_version;
+        vector_type<Change<T>>{ get_allocator() }.swap(m_journal);
+    }
+
+    /*! \brief Views the modifications of the relations made after a version, oldest first.
+    *   \param version a version between journal_origin() and version()
+    *   \return the view on the modifications, invalidated by the next modification
+    *   \warning An assertion occurs if the version is not covered by the journal.
+    *
+    *   The changes of a version are consecutive in the journal, so the view is found in constant time.
+    */
+    template <typename T, typename Allocator>
+    Span<Change<T>> Requirements<T, Allocator>::changes_since(size_t version) const noexcept
+    {
+        bool covered = m_journaled && version >= m_journal_origin && version <= m_version;
+        assert(covered && "Changes since this version are not journaled.");
+        if (!covered)
+            return {};
+        auto first = version - m_journal_origin;
+        return { m_journal.data() + first, m_journal.size() - first };
+    }
+
+    /*! \brief Drops the modifications up to a version from the journal, once all the consumers have processed them.
+    *   \param version a version between journal_origin() and version(), the new origin of the journal
+    *   \warning An assertion occurs if the version is not covered by the journal.
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::forget_changes(size_t version)
+    {
+        bool covered = m_journaled && version >= m_journal_origin && version <= m_version;
+        assert(covered && "Changes since this version are not journaled.");
+        if (!covered)
+            return;
+        m_journal.erase(m_journal.begin(), m_journal.begin() + static_cast<std::ptrdiff_t>(version - m_journal_origin));
+        m_journal_origin = version;
+    }
+
+    /*! \brief Records a modification made by the current member.
+    *   \param kind the modification
+    *   \param dependent,requirement the ids of the 2 objects of the relation
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::_record(ChangeKind kind, node_id dependent, node_id requirement)
+    {
+        ++m_unpublished;
+        if (_recording())
+            m_pending.push_back({ 0, kind, m_nodes[dependent], m_nodes[requirement] });
+    }
+
+    /*! \brief Gives their versions to the modifications made by the current member, then appends them to the journal and calls the hook.
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::_publish()
+    {
+        if (m_pending.empty())
+        {
+            m_version += m_unpublished;
+            m_unpublished = 0;
+            return;
+        }
+        for (auto& change : m_pending)
+            change.version = ++m_version;
+        m_unpublished = 0;
+        if (m_journaled)
+        {
+            auto first = m_journal.size();
+            m_journal.insert(m_journal.end(), std::make_move_iterator(m_pending.begin()), std::make_move_iterator(m_pending.end()));
+            m_pending.clear();
+            if (m_change_hook)
+                m_change_hook({ m_journal.data() + first, m_journal.size() - first });
+        }
+        else
+        {
+            m_change_hook({ m_pending.data(), m_pending.size() });
+            m_pending.clear();
+        }
+    }
+
+    /*! \brief Gets the node id of an object, interning it if needed.
+    *   \param object the object to intern
+    *   \return its node id
+    */
+    template <typename T, typename Allocator>
+    template <typename U>
+    typename Requirements<T, Allocator>::node_id Requirements<T, Allocator>::_intern(U&& object)
+    {
+        REQUIREMENTS_COUNT(lookups, 1);
+        auto itr = m_ids.find(object);
+        if (itr != m_ids.end())
+            return (*itr).second;
+        assert(m_nodes.size() < npos && "Too many objects.");
+        auto id = static_cast<node_id>(m_nodes.size());
+        REQUIREMENTS_GROWTH(m_nodes);
+        m_nodes.push_back(std::forward<U>(object));
+        m_ids.insert({ m_nodes.back(), id });
+        m_requirements.emplace_back();
+        m_dependents.emplace_back();
+        if (m_reach_valid)
+            m_reach.emplace_back();
+        return id;
+    }
+
+    /*! \brief Erases an id from an adjacency list.
+    *   \param ids the adjacency list to update
+    *   \param id the id to erase
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::_erase(ids_type& ids, node_id id) noexcept
+    {
+        auto itr = std::find(ids.begin(), ids.end(), id);
+        if (itr != ids.end())
+            ids.erase(itr);
+    }
+
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type Requirements<T, Allocator>::_to_objects(const vector_type<ids_type>& chains) const
+    {
+        chains_type result{ get_allocator() };
+        result.reserve(chains.size());
+        for (const auto& chain : chains)
+        {
+            list_type row{ get_allocator() };
+            row.reserve(chain.size());
+            for (auto id : chain)
+                row.push_back(m_nodes[id]);
+            result.push_back(std::move(row));
+        }
+        return result;
+    }
+
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type Requirements<T, Allocator>::_collect(Chains chains) const
+    {
+        chains_type result{ get_allocator() };
+        size_t objects{ 0 };
+        for (const auto& chain : chains)
+        {
+            result.push_back(chain.to_vector());
+            objects += result.back().size();
+        }
+        REQUIREMENTS_COUNT(chains, result.size());
+        REQUIREMENTS_PEAK(peak_chains, result.size());
+        REQUIREMENTS_PEAK(peak_chain_objects, objects);
+        (void)objects;
+        return result;
+    }
+
+    /*! \brief Starts the walk.
+    *   \return an iterator on the first branch, or end() if there is none
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::Chains::iterator Requirements<T, Allocator>::Chains::begin()
+    {
+        m_path.clear();
+        m_next.clear();
+        m_extended.clear();
+        m_on_path.resize(m_owner->m_nodes.size());
+        m_on_path.reset();
+        m_cursor = m_all ? m_first : 0;
+        m_emitted = false;
+        return _advance() ? iterator{ this } : iterator{};
+    }
+
+    template <typename T, typename Allocator>
+    const typename Requirements<T, Allocator>::ids_type& Requirements<T, Allocator>::Chains::_neighbours(node_id id) const noexcept
+    {
+        return m_forward ? m_owner->m_requirements[id] : m_owner->m_dependents[id];
+    }
+
+    template <typename T, typename Allocator>
+    bool Requirements<T, Allocator>::Chains::_is_root(node_id id) const noexcept
+    {
+        const auto& backward = m_forward ? m_owner->m_dependents[id] : m_owner->m_requirements[id];
+        return !_neighbours(id).empty() && (!m_without_duplicates || backward.empty());
+    }
+
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::Chains::_push(node_id id)
+    {
+        m_path.push_back(id);
+        m_next.push_back(0);
+        m_extended.push_back(false);
+        m_on_path.set(id);
+    }
+
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::Chains::_pop() noexcept
+    {
+        m_on_path.reset(m_path.back());
+        m_path.pop_back();
+        m_next.pop_back();
+        m_extended.pop_back();
+    }
+
+    /*! \brief Walks to the next branch.
+    *   \return false if there is no more branch
+    *
+    *   The path is extended with the first neighbour not yet walked that is not already in the path.
+    *   When the last object of the path has never been extended, the path is a branch.
+    */
+    template <typename T, typename Allocator>
+    bool Requirements<T, Allocator>::Chains::_advance()
+    {
+        if (m_emitted)
+        {
+            _pop();
+            m_emitted = false;
+        }
+        for (;;)
+        {
+            if (m_path.empty())
+            {
+                if (!m_all)
+                {
+                    if (m_cursor != 0 || m_root >= m_owner->m_nodes.size())
+                        return false;
+                    m_cursor = 1;
+                    _push(m_root);
+                }
+                else
+                {
+                    auto last = std::min<size_t>(m_last, m_owner->m_nodes.size());
+                    while (m_cursor < last && !_is_root(m_cursor))
+                        ++m_cursor;
+                    if (m_cursor >= last)
+                        return false;
+                    _push(m_cursor++);
+                }
+            }
+            const auto& neighbours = _neighbours(m_path.back());
+            auto& pos = m_next.back();
+            while (pos < neighbours.size() && m_on_path.test(neighbours[pos]))
+                ++pos;
+            if (pos < neighbours.size())
+            {
+                auto next = neighbours[pos++];
+                m_extended.back() = true;
+                _push(next);
+                continue;
+            }
+            if (!m_extended.back() && m_path.size() > 1)
+            {
+                m_emitted = true;
+                return true;
+            }
+            _pop();
+        }
+    }
+
+    /*! \brief Checks if the walk can take another step, and records why it cannot.
+    *   \return true if the walk is running, the relations unchanged and the deadline not passed
+    */
+    template <typename T, typename Allocator>
+    bool Requirements<T, Allocator>::Walk::_proceed() noexcept
+    {
+        if (m_status != WalkStatus::Running)
+            return false;
+        if (m_owner->m_version != m_version || m_owner->m_nodes.size() != m_nodes)
+            m_status = WalkStatus::Invalidated;
+        else if (m_deadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= m_deadline)
+            m_status = WalkStatus::Expired;
+        return m_status == WalkStatus::Running;
+    }
+
+    template <typename T, typename Allocator>
+    Requirements<T, Allocator>::ClosureWalk::ClosureWalk(const Requirements<T, Allocator>& owner, node_id start, bool forward)
+        : Walk(owner), m_start(start), m_forward(forward), m_trail(owner.get_allocator()), m_objects(owner.get_allocator())
+    {
+        if (start == npos)
+        {
+            this->m_status = WalkStatus::Done;
+            return;
+        }
+        m_marks.resize(owner.m_nodes.size());
+        m_marks.set(start);
+        m_trail.push_back(start);
+    }
+
+    /*! \brief Visits the next objects of the walk.
+    *   \param budget the maximum number of objects visited by the step
+    *   \return the state of the walk after the step
+    *
+    *   The buffers of the walk are released once it is done.
+    */
+    template <typename T, typename Allocator>
+    WalkStatus Requirements<T, Allocator>::ClosureWalk::resume(size_t budget)
+    {
+        if (!this->_proceed())
+            return this->m_status;
+        const auto& owner = *this->m_owner;
+        const auto& adjacency = m_forward ? owner.m_requirements : owner.m_dependents;
+        for (; budget != 0 && m_head < m_trail.size(); --budget, ++m_head, ++this->m_visited)
+            for (auto id : adjacency[m_trail[m_head]])
+            {
+                if (id == m_start)
+                    m_cycle = true;
+                if (!m_marks.test(id))
+                {
+                    m_marks.set(id);
+                    m_trail.push_back(id);
+                    m_objects.push_back(owner.m_nodes[id]);
+                }
+            }
+        if (m_head == m_trail.size())
+        {
+            if (m_cycle)
+                m_objects.insert(m_objects.begin(), owner.m_nodes[m_start]);
+            m_trail = ids_type{ owner.get_allocator() };
+            m_marks = Bitset{};
+            this->m_status = WalkStatus::Done;
+        }
+        return this->m_status;
+    }
+
+    /*! \brief Constructor.
+    *   \param chains the range of branches to collect, that must not have been iterated
+    */
+    template <typename T, typename Allocator>
+    Requirements<T, Allocator>::ChainsWalk::ChainsWalk(Chains chains)
+        : Walk(*chains.m_owner), m_chains(std::make_unique<Chains>(std::move(chains))), m_result(this->m_owner->get_allocator())
+    {
+    }
+
+    /*! \brief Collects the next branches of the range.
+    *   \param budget the maximum number of objects of the branches collected by the step, at least one branch being collected
+    *   \return the state of the walk after the step
+    */
+    template <typename T, typename Allocator>
+    WalkStatus Requirements<T, Allocator>::ChainsWalk::resume(size_t budget)
+    {
+        if (!this->_proceed())
+            return this->m_status;
+        if (!m_started)
+        {
+            m_iterator = m_chains->begin();
+            m_started = true;
+        }
+        while (budget != 0 && m_iterator != m_chains->end())
+        {
+            auto chain = *m_iterator;
+            m_result.push_back(chain.to_vector());
+            this->m_visited += chain.size();
+            budget -= std::min(budget, chain.size());
+            ++m_iterator;
+        }
+        if (m_iterator == m_chains->end())
+            this->m_status = WalkStatus::Done;
+        return this->m_status;
+    }
+
+    /*! \brief Constructor. Computes the components of the relations of owner and the relations between them.
+    *   \param owner the instance whose relations are condensed
+    *
+    *   The relations between 2 components are merged, so each list of components holds distinct components.
+    */
+    template <typename T, typename Allocator>
+    Requirements<T, Allocator>::Condensation::Condensation(const Requirements<T, Allocator>& owner)
+        : m_owner(&owner), m_component(owner.get_allocator()), m_member_offsets(owner.get_allocator()), m_members(owner.get_allocator()),
+        m_requirement_offsets(owner.get_allocator()), m_requirement_targets(owner.get_allocator()),
+        m_dependent_offsets(owner.get_allocator()), m_dependent_targets(owner.get_allocator())
+    {
+        const auto nodes = static_cast<node_id>(owner.m_nodes.size());
+        node_id count{ 0 };
+        m_component = owner._components(count);
+        // members, grouped by component
+        m_member_offsets.assign(count + 1, 0);
+        for (node_id id = 0; id < nodes; ++id)
+            ++m_member_offsets[m_component[id] + 1];
+        for (node_id comp = 0; comp < count; ++comp)
+            m_member_offsets[comp + 1] += m_member_offsets[comp];
+        m_members.resize(nodes);
+        vector_type<size_t> next(m_member_offsets.begin(), m_member_offsets.end() - 1, owner.get_allocator());
+        for (node_id id = 0; id < nodes; ++id)
+            m_members[next[m_component[id]]++] = id;
+        // requirements, in the order of the components
+        ids_type seen(count, npos, owner.get_allocator());             // component -> last component that listed it as a requirement
+        m_requirement_offsets.reserve(count + 1);
+        m_requirement_offsets.push_back(0);
+        for (node_id comp = 0; comp < count; ++comp)
+        {
+            for (auto id : members(comp))
+                for (auto req : owner.m_requirements[id])
+                {
+                    auto target = m_component[req];
+                    if (target != comp && seen[target] != comp)
+                    {
+                        seen[target] = comp;
+                        m_requirement_targets.push_back(target);
+                    }
+                }
+            m_requirement_offsets.push_back(m_requirement_targets.size());
+        }
+        // dependents, reversing the requirements
+        m_dependent_offsets.assign(count + 1, 0);
+        for (auto target : m_requirement_targets)
+            ++m_dependent_offsets[target + 1];
+        for (node_id comp = 0; comp < count; ++comp)
+            m_dependent_offsets[comp + 1] += m_dependent_offsets[comp];
+        m_dependent_targets.resize(m_requirement_targets.size());
+        next.assign(m_dependent_offsets.begin(), m_dependent_offsets.end() - 1);
+        for (node_id comp = 0; comp < count; ++comp)
+            for (auto target : requirements(comp))
+                m_dependent_targets[next[target]++] = comp;
+    }
+
+    /*! \brief Gets the component of an object.
+    *   \param object the object to look for
+    *   \return its component, or npos if the object is unknown
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::node_id Requirements<T, Allocator>::Condensation::component_of(const T& object) const noexcept
+    {
+        auto id = m_owner->id_of(object);
+        return id == npos ? npos : m_component[id];
+    }
+
+    /*! \brief Groups the components involved in relations by levels: the requirements of a component all belong to previous levels.
+    *   \return the levels, the first one gathering the components without requirement
+    *
+    *   Unlike Requirements< T >::topological_levels(), relations may form cycles: the objects of a cycle share a level.
+    *   Components are processed in index order, so each one is placed in the earliest possible level in O(V+E).
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::template vector_type<typename Requirements<T, Allocator>::ids_type> Requirements<T, Allocator>::Condensation::levels() const
+    {
+        const auto count = static_cast<node_id>(size());
+        vector_type<ids_type> result{ m_owner->get_allocator() };
+        ids_type level(count, 0, m_owner->get_allocator());
+        for (node_id comp = 0; comp < count; ++comp)
+        {
+            if (!cyclic(comp) && requirements(comp).empty() && dependents(comp).empty())
+                continue;                                               // object without relation
+            for (auto req : requirements(comp))
+                level[comp] = std::max(level[comp], static_cast<node_id>(level[req] + 1));
+            if (level[comp] >= result.size())
+                result.resize(level[comp] + 1, ids_type{ m_owner->get_allocator() });
+            result[level[comp]].push_back(comp);
+        }
+        return result;
+    }
+
+    /*! \brief Lists the components reachable from a component.
+    *   \param component the component to start from
+    *   \param forward walks requirements if true, dependents otherwise
+    *   \return the components found, the starting component excluded, in no particular order
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::ids_type Requirements<T, Allocator>::Condensation::_closure(node_id component, bool forward) const
+    {
+        ids_type result{ m_owner->get_allocator() };
+        ids_type stack{ { component }, m_owner->get_allocator() };
+        bitset_type visited{ m_owner->get_allocator() };
+        visited.resize(size());
+        visited.set(component);
+        while (!stack.empty())
+        {
+            auto comp = stack.back();
+            stack.pop_back();
+            for (auto next : forward ? requirements(comp) : dependents(comp))
+                if (!visited.test(next))
+                {
+                    visited.set(next);
+                    result.push_back(next);
+                    stack.push_back(next);
+                }
+        }
+        return result;
+    }
+
+    /*! \brief Lists the branches of components starting with a component.
+    *   \param component the first component of the branches
+    *   \param forward walks requirements if true, dependents otherwise
+    *   \return the branches, a component without neighbour giving a single branch made of itself
+    *
+    *   The condensation has no cycle, so the number of branches only depends on the relations between distinct components:
+    *   objects that form a cycle never multiply them.
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::template vector_type<typename Requirements<T, Allocator>::ids_type> Requirements<T, Allocator>::Condensation::_chains(node_id component, bool forward) const
+    {
+        vector_type<ids_type> result{ m_owner->get_allocator() };
+        ids_type path{ { component }, m_owner->get_allocator() };
+        std::vector<size_t> next{ 0 };                                  // position of the next neighbour to walk for each component of the path
+        while (!path.empty())
+        {
+            auto neighbours = forward ? requirements(path.back()) : dependents(path.back());
+            if (neighbours.empty())
+                result.push_back(path);
+            if (next.back() < neighbours.size())
+            {
+                path.push_back(neighbours[next.back()++]);
+                next.push_back(0);
+            }
+            else
+            {
+                path.pop_back();
+                next.pop_back();
+            }
+        }
+        return result;
+    }
+
+    /*! \brief Checks if requirement can be reached from dependent by walking the relations.
+    *   \param dependent,requirement the ids of the 2 objects to check
+    *   \return true if dependent depends directly or indirectly on requirement
+    *
+    *   The walk uses an explicit stack and marks visited objects, so it supports long chains and cycles of any length.
+    *   Once the scratch buffers have grown to the size of the graph, no allocation occurs.
+    */
+    template <typename T, typename Allocator>
+    bool Requirements<T, Allocator>::_requires(node_id dependent, node_id requirement) const
+    {
+        // a requirement always comes before its dependents in the topological order, so objects placed before requirement can't lead to it
+        const bool ordered{ !m_reflexive && m_order_valid };
+        if (ordered && m_position[requirement] > m_position[dependent])
+            return false;
+        const std::int64_t bound{ ordered ? m_position[requirement] : 0 };
+        if (m_visited.size() < m_nodes.size())
+            m_visited.resize(m_nodes.size());
+        bool result{ false };
+        m_stack.push_back(dependent);
+        m_trail.push_back(dependent);
+        m_visited.set(dependent);
+        while (!result && !m_stack.empty())
+        {
+            auto id = m_stack.back();
+            m_stack.pop_back();
+            for (auto req : m_requirements[id])
+            {
+                if (req == requirement)
+                {
+                    result = true;
+                    break;
+                }
+                if (!m_visited.test(req) && (!ordered || m_position[req] > bound))
+                {
+                    m_visited.set(req);
+                    m_trail.push_back(req);
+                    m_stack.push_back(req);
+                }
+            }
+        }
+        REQUIREMENTS_COUNT(walks, 1);
+        REQUIREMENTS_COUNT(visited, m_trail.size());
+        REQUIREMENTS_PEAK(peak_visited, m_trail.size());
+        for (auto id : m_trail)
+            m_visited.reset(id);
+        m_trail.clear();
+        m_stack.clear();
+        return result;
+    }
+
+    /*! \brief Answers recursive queries sharing the same dependent with a single depth-first walk.
+    *   \param first,last the queries, all with the same dependent
+    *   \param targets a cleared set of at least node_count() bits, left cleared after use
+    *   \param results receives the answers at the positions of the queries
+    *
+    *   The walk stops as soon as all the requirements of the queries have been reached.
+    */
+    template <typename T, typename Allocator>
+    template <typename BitsetAllocator>
+    void Requirements<T, Allocator>::_requires_many(const Query* first, const Query* last, bitset_type& targets, BasicBitset<BitsetAllocator>& results) const
+    {
+        auto dependent = first->dependent;
+        size_t remaining{ 0 };
+        for (auto query = first; query != last; ++query)
+            if (!targets.test(query->requirement))
+            {
+                targets.set(query->requirement);
+                ++remaining;
+            }
+        if (m_visited.size() < m_nodes.size())
+            m_visited.resize(m_nodes.size());
+        bool cycle{ false };                                            // dependent is reached again
+        m_stack.push_back(dependent);
+        m_trail.push_back(dependent);
+        m_visited.set(dependent);
+        while (remaining != 0 && !m_stack.empty())
+        {
+            auto id = m_stack.back();
+            m_stack.pop_back();
+            for (auto req : m_requirements[id])
+            {
+                if (req == dependent && !cycle)
+                {
+                    cycle = true;
+                    if (targets.test(req))
+                        --remaining;
+                }
+                if (!m_visited.test(req))
+                {
+                    m_visited.set(req);
+                    m_trail.push_back(req);
+                    m_stack.push_back(req);
+                    if (targets.test(req))
+                        --remaining;
+                }
+            }
+        }
+        for (auto query = first; query != last; ++query)
+        {
+            if (query->requirement == dependent ? cycle : m_visited.test(query->requirement))
+                results.set(query->index);
+            targets.reset(query->requirement);
+        }
+        REQUIREMENTS_COUNT(walks, 1);
+        REQUIREMENTS_COUNT(visited, m_trail.size());
+        REQUIREMENTS_PEAK(peak_visited, m_trail.size());
+        for (auto id : m_trail)
+            m_visited.reset(id);
+        m_trail.clear();
+        m_stack.clear();
+    }
+
+    /*! \brief Writes the objects reachable from a node through at least one relation (breadth-first walk).
+    *   \param start the id of the object to start from
+    *   \param forward walks requirements if true, dependents otherwise
+    *   \param out the output iterator that receives the objects
+    *   \return the output iterator past the last object written
+    */
+    template <typename T, typename Allocator>
+    template <typename OutputIt>
+    OutputIt Requirements<T, Allocator>::_closure(node_id start, bool forward, OutputIt out) const
+    {
+        const auto& adjacency = forward ? m_requirements : m_dependents;
+        if (m_visited.size() < m_nodes.size())
+            m_visited.resize(m_nodes.size());
+        bool cycle{ false };
+        m_trail.push_back(start);
+        m_visited.set(start);
+        for (size_t head = 0; head < m_trail.size(); ++head)
+            for (auto id : adjacency[m_trail[head]])
+            {
+                if (id == start)
+                    cycle = true;
+                if (!m_visited.test(id))
+                {
+                    m_visited.set(id);
+                    m_trail.push_back(id);
+                }
+            }
+        if (cycle)
+            *out++ = m_nodes[start];
+        for (size_t i = 1; i < m_trail.size(); ++i)
+            *out++ = m_nodes[m_trail[i]];
+        REQUIREMENTS_COUNT(walks, 1);
+        REQUIREMENTS_COUNT(visited, m_trail.size());
+        REQUIREMENTS_PEAK(peak_visited, m_trail.size());
+        for (auto id : m_trail)
+            m_visited.reset(id);
+        m_trail.clear();
+        return out;
+    }
+
+    /*! \brief Checks if requirement can be reached from dependent, using the reachability cache when activated.
+    *   \param dependent,requirement the ids of the 2 objects to check
+    *   \return true if dependent depends directly or indirectly on requirement
+    */
+    template <typename T, typename Allocator>
+    bool Requirements<T, Allocator>::_reaches(node_id dependent, node_id requirement) const
+    {
+        if (!m_reach_cached)
+            return _requires(dependent, requirement);
+        if (!m_reach_valid)
+            _build_reachability();
+        return m_reach[dependent].test(requirement);
+    }
+
+    /*! \brief Updates the reachability cache after the relation (dependent, requirement) has been added.
+    *   \param dependent,requirement the ids of the 2 objects of the new relation
+    *
+    *   Every object that reaches dependent now reaches requirement and everything requirement reaches.
+    *   Objects that already reached requirement are complete, as well as the objects that depend on them, so the walk stops there.
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::_update_reachability(node_id dependent, node_id requirement)
+    {
+        bitset_type gained{ m_reach[requirement] };
+        gained.set(requirement);
+        ids_type pending{ { dependent }, get_allocator() };
+        while (!pending.empty())
+        {
+            auto id = pending.back();
+            pending.pop_back();
+            if (m_reach[id].test(requirement) && id != dependent)
+                continue;
+            m_reach[id] |= gained;
+            for (auto dep : m_dependents[id])
+                if (!m_reach[dep].test(requirement))
+                    pending.push_back(dep);
+        }
+    }
+
+    /*! \brief Rebuilds the whole reachability cache.
+    *
+    *   Strongly connected components are processed from requirements to dependents, so the sets of the components a component
+    *   depends on are complete when it is processed. All objects of a component share the same set.
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::_build_reachability() const
+    {
+        REQUIREMENTS_TRACE("build_reachability");
+        node_id count{ 0 };
+        auto component = _components(count);
+        vector_type<ids_type> members(count, get_allocator());
+        for (node_id id = 0; id < m_nodes.size(); ++id)
+            members[component[id]].push_back(id);
+        vector_type<bitset_type> reach(count, get_allocator());
+        for (node_id comp = 0; comp < count; ++comp)
+        {
+            auto& result = reach[comp];
+            for (auto id : members[comp])
+                for (auto req : m_requirements[id])
+                    if (component[req] != comp)
+                    {
+                        result.set(req);
+                        result |= reach[component[req]];
+                    }
+            if (members[comp].size() > 1)
+                for (auto id : members[comp])
+                    result.set(id);
+        }
+        m_reach.assign(m_nodes.size(), bitset_type{ get_allocator() });
+        for (node_id id = 0; id < m_nodes.size(); ++id)
+            m_reach[id] = reach[component[id]];
+        m_reach_valid = true;
+    }
+
+    /*! \brief Computes the strongly connected components of the relations (iterative Tarjan algorithm).
+    *   \param count receives the number of components
+    *   \return the component index of each node id
+    *
+    *   Components are numbered from requirements to dependents: a relation never goes from a component to a component with a greater index.
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::ids_type Requirements<T, Allocator>::_components(node_id& count) const
+    {
+        const auto nodes = static_cast<node_id>(m_nodes.size());
+        ids_type component(nodes, npos, get_allocator());
+        ids_type index(nodes, npos, get_allocator());
+        ids_type low(nodes, 0, get_allocator());
+        ids_type stack{ get_allocator() };
+        std::vector<std::pair<node_id, size_t>> calls{};
+        node_id next{ 0 };
+        count = 0;
+        for (node_id root = 0; root < nodes; ++root)
+        {
+            if (index[root] != npos)
+                continue;
+            index[root] = low[root] = next++;
+            stack.push_back(root);
+            calls.push_back({ root, 0 });
+            while (!calls.empty())
+            {
+                auto id = calls.back().first;
+                auto& pos = calls.back().second;
+                const auto& reqs = m_requirements[id];
+                if (pos < reqs.size())
+                {
+                    auto req = reqs[pos++];
+                    if (index[req] == npos)
+                    {
+                        index[req] = low[req] = next++;
+                        stack.push_back(req);
+                        calls.push_back({ req, 0 });
+                    }
+                    else if (component[req] == npos)            // still on the stack
+                        low[id] = std::min(low[id], index[req]);
+                    continue;
+                }
+                calls.pop_back();
+                if (low[id] == index[id])
+                {
+                    node_id member{ npos };
+                    do
+                    {
+                        member = stack.back();
+                        stack.pop_back();
+                        component[member] = count;
+                    } while (member != id);
+                    ++count;
+                }
+                if (!calls.empty())
+                {
+                    auto parent = calls.back().first;
+                    low[parent] = std::min(low[parent], low[id]);
+                }
+            }
+        }
+        return component;
+    }
+
+    /*! \brief Rebuilds the topological order of all the interned objects (Kahn algorithm).
+    *   \return true if the order is valid, false if relations form a cycle
+    */
+    template <typename T, typename Allocator>
+    bool Requirements<T, Allocator>::_rebuild_order() const
+    {
+        const auto nodes = static_cast<node_id>(m_nodes.size());
+        ids_type pending(nodes, 0, get_allocator());                   // node id -> number of requirements not yet placed
+        m_order.clear();
+        m_first = 0;
+        for (node_id id = 0; id < nodes; ++id)
+        {
+            pending[id] = static_cast<node_id>(m_requirements[id].size());
+            if (pending[id] == 0)
+                m_order.push_back(id);
+        }
+        for (size_t pos = 0; pos < m_order.size(); ++pos)
+            for (auto dep : m_dependents[m_order[pos]])
+                if (--pending[dep] == 0)
+                    m_order.push_back(dep);
+        m_order_valid = m_order.size() == nodes;
+        m_since_rebuild = 0;
+        m_position.assign(nodes, 0);
+        if (m_order_valid)
+            for (node_id pos = 0; pos < nodes; ++pos)
+                m_position[m_order[pos]] = pos;
+        return m_order_valid;
+    }
+
+    /*! \brief Places a new object at one end of the topological order.
+    *   \param id the id of the object, the last interned one
+    *   \param first places the object before all the other ones if true, after them otherwise
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::_place(node_id id, bool first)
+    {
+        assert(m_position.size() == id && "Objects are placed in interning order.");
+        if (first)
+        {
+            m_position.push_back(--m_first);
+            m_order.push_front(id);
+        }
+        else
+        {
+            m_position.push_back(m_first + static_cast<std::int64_t>(m_order.size()));
+            m_order.push_back(id);
+        }
+    }
+
+    /*! \brief Updates the topological order for a new relation (Pearce-Kelly algorithm).
+    *   \param dependent,requirement the ids of the 2 objects of the new relation
+    *   \return false if the relation would close a cycle, the order being left unchanged
+    *
+    *   Nothing is done if requirement is already placed before dependent. Otherwise only the objects placed between them are visited:
+    *   the dependents of dependent and the requirements of requirement found there are moved, keeping their relative order,
+    *   so that the latter come first, in the positions that the 2 groups occupied.
+    *   If too many objects would move, the order is given up instead, and add() rebuilds it in O(V+E) with the new relation.
+    *   To keep the cost of the rebuilds amortized, add() defers them until (V+E)/4 relations have been added since the previous one.
+    */
+    template <typename T, typename Allocator>
+    bool Requirements<T, Allocator>::_reorder(node_id dependent, node_id requirement)
+    {
+        const auto lower = m_position[dependent];
+        const auto upper = m_position[requirement];
+        if (upper < lower)
+            return true;
+        if (m_visited.size() < m_nodes.size())
+            m_visited.resize(m_nodes.size());
+        const size_t budget{ _reorder_budget() };
+        // objects between the 2 positions that depend on dependent
+        bool cycle{ false };
+        m_stack.push_back(dependent);
+        m_trail.push_back(dependent);
+        m_visited.set(dependent);
+        while (!cycle && m_order_valid && !m_stack.empty())
+        {
+            auto id = m_stack.back();
+            m_stack.pop_back();
+            if (m_trail.size() > budget)
+                m_order_valid = false;
+            for (auto dep : m_dependents[id])
+            {
+                if (dep == requirement)
+                {
+                    cycle = true;
+                    break;
+                }
+                if (!m_visited.test(dep) && m_position[dep] < upper)
+                {
+                    m_visited.set(dep);
+                    m_trail.push_back(dep);
+                    m_stack.push_back(dep);
+                }
+            }
+        }
+        // objects between the 2 positions that requirement depends on
+        if (!cycle && m_order_valid)
+        {
+            m_stack.clear();
+            m_stack.push_back(requirement);
+            m_region.push_back(requirement);
+            m_visited.set(requirement);
+            while (m_order_valid && !m_stack.empty())
+            {
+                auto id = m_stack.back();
+                m_stack.pop_back();
+                if (m_trail.size() + m_region.size() > budget)
+                    m_order_valid = false;
+                for (auto req : m_requirements[id])
+                    if (!m_visited.test(req) && m_position[req] > lower)
+                    {
+                        m_visited.set(req);
+                        m_region.push_back(req);
+                        m_stack.push_back(req);
+                    }
+            }
+        }
+        if (!cycle && m_order_valid)
+        {
+            auto by_position = [this](node_id first, node_id second) { return m_position[first] < m_position[second]; };
+            std::sort(m_region.begin(), m_region.end(), by_position);
+            std::sort(m_trail.begin(), m_trail.end(), by_position);
+            for (auto id : m_region)
+                m_labels.push_back(m_position[id]);
+            for (auto id : m_trail)
+                m_labels.push_back(m_position[id]);
+            std::inplace_merge(m_labels.begin(), m_labels.begin() + static_cast<std::ptrdiff_t>(m_region.size()), m_labels.end());
+            size_t pos{ 0 };
+            for (auto id : m_region)
+            {
+                m_position[id] = m_labels[pos];
+                m_order[static_cast<size_t>(m_labels[pos++] - m_first)] = id;
+            }
+            for (auto id : m_trail)
+            {
+                m_position[id] = m_labels[pos];
+                m_order[static_cast<size_t>(m_labels[pos++] - m_first)] = id;
+            }
+            m_labels.clear();
+        }
+        REQUIREMENTS_COUNT(walks, 1);
+        REQUIREMENTS_COUNT(visited, m_trail.size() + m_region.size());
+        for (auto id : m_trail)
+            m_visited.reset(id);
+        for (auto id : m_region)
+            m_visited.reset(id);
+        m_trail.clear();
+        m_region.clear();
+        m_stack.clear();
+        return !cycle;
+    }
 
-        bool _requires(const T& dependent, const T& requirement, const T* prev) const;
-        //bool _depends(const T& resuirement, const T& dependent, const T* prev) const;
-    };
+    /*! \brief Starts a bulk load.
+    *   \param bulk the state of the load
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::_bulk_begin(Bulk& bulk)
+    {
+        bulk.nodes = m_nodes.size();
+    }
 
-    // Implementation of templates classes and functions
+    /*! \brief Inserts a relation without checking the rules, except the ones that only involve the relation itself.
+    *   \param bulk the state of the load
+    *   \param dependent,requirement the 2 objects of the relation
+    */
+    template <typename T, typename Allocator>
+    template <typename D, typename R>
+    void Requirements<T, Allocator>::_bulk_insert(Bulk& bulk, D&& dependent, R&& requirement)
+    {
+        if (dependent == requirement)
+        {
+            bulk.violations.push_back({ dependent, requirement, ViolationKind::SelfRequirement });
+            return;
+        }
+        auto dep = _intern(std::forward<D>(dependent));
+        auto req = _intern(std::forward<R>(requirement));
+        m_requirements[dep].push_back(req);
+        m_dependents[req].push_back(dep);
+        ++m_size;
+        bulk.relations.push_back({ dep, req });
+    }
 
-    /*! \brief Add a relation where dependent depends on requirement.
-    *   \param dependent the object that depends on the other object
-    *   \param requirement the object on which the first object depends
-    *   \warning An assertion occurs if:
-    *   \li dependent and requirements are the same object,
-    *   \li the relation already exists,
-    *   \li the opposite relation already exists while reflexivity is not allowed.
+    /*! \brief Ends a bulk load, checking the inserted relations and rolling them back if a rule is broken.
+    *   \param bulk the state of the load
     */
-    template <typename T>
-    void Requirements<T>::add(const T& dependent, const T& requirement)
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::_bulk_end(Bulk& bulk)
     {
-        assert(!(dependent == requirement) && "A requirement can't be requested for object itself.");
-        // we must ensure the implicit requirement does not already exist
-        assert(!exists(dependent, requirement, true) && "(Implicit) requirement is already defined.");
+        std::vector<bool> rejected(bulk.relations.size(), false);
+        _bulk_duplicates(bulk, rejected);
+        _bulk_implicits(bulk, rejected);
+        if (!bulk.violations.empty())
+        {
+            _bulk_rollback(bulk);
+            return;
+        }
+        // the order and the cache are only updated once the batch is kept, the order being rebuilt in O(V+E) like the checks
+        _invalidate_reachability();
         if (!m_reflexive)
-            // opposite requirement is only allowed if reflexivity is activated, directly or indirectly
-            assert(!exists(requirement, dependent, true) && "Opposite requirement cannot be set while reflexivity is not allowed.");
-        m_requirements.insert({ dependent, requirement });
+            _rebuild_order();
+        if (_recording())
+        {
+            for (const auto& relation : bulk.relations)
+                _record(ChangeKind::Added, relation.first, relation.second);
+        }
+        else
+            m_unpublished += bulk.relations.size();
+        _publish();
     }
 
-    /*! \brief Removes an existing relation where dependent depends on requirement.
-    *   \param dependent,requirement the 2 objects involved in the dependency to remove
-    *   \warning An assertion occurs if the relation does not exist.
-    *   \warning This function does not remove the opposite relation.
+    /*! \brief Finds the inserted relations that already existed and removes them.
+    *   \param bulk the state of the load
+    *   \param rejected flags of the relations of the batch that break a rule
+    *
+    *   The relations of the batch are the last ones of the adjacency lists, in insertion order,
+    *   so for each dependent the later occurrences of a requirement are the duplicates to report.
+    *   The duplicates are removed so that the relations of the batch remain at the end of the lists.
     */
-    template <typename T>
-    void Requirements<T>::remove(const T& dependent, const T& requirement)
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::_bulk_duplicates(Bulk& bulk, std::vector<bool>& rejected)
     {
-        auto range = m_requirements.equal_range(dependent);
-        auto itr = range.first;
-        bool found{ false };
-        while (itr != range.second)
+        auto& relations = bulk.relations;
+        std::vector<std::vector<size_t>> batch(m_nodes.size());          // dependent -> indexes of its relations in the batch
+        for (size_t i = 0; i < relations.size(); ++i)
+            batch[relations[i].first].push_back(i);
+        std::vector<size_t> hits(m_nodes.size(), 0);
+        for (node_id dep = 0; dep < m_nodes.size(); ++dep)
         {
-            if ((*itr).second == requirement)
+            if (batch[dep].empty())
+                continue;
+            auto& reqs = m_requirements[dep];
+            for (auto req : reqs)
+                ++hits[req];
+            bool found{ false };
+            for (auto i = batch[dep].rbegin(); i != batch[dep].rend(); ++i)
             {
-                itr = m_requirements.erase(itr);
-                found = true;
+                auto req = relations[*i].second;
+                if (hits[req] > 1)
+                {
+                    --hits[req];
+                    rejected[*i] = true;
+                    found = true;
+                    bulk.violations.push_back({ m_nodes[dep], m_nodes[req], ViolationKind::Duplicate });
+                }
             }
-            else
-                ++itr;
+            for (auto req : reqs)
+                hits[req] = 0;
+            if (!found)
+                continue;
+            // remove the rejected relations of the batch from the tail of the lists
+            auto kept = reqs.size() - batch[dep].size();
+            for (auto i : batch[dep])
+            {
+                auto req = relations[i].second;
+                if (rejected[i])
+                {
+                    auto& deps = m_dependents[req];
+                    deps.erase(std::find(deps.rbegin(), deps.rend(), dep).base() - 1);
+                    --m_size;
+                }
+                else
+                    reqs[kept++] = req;
+            }
+            reqs.resize(kept);
         }
-        assert(found && "Requirement does not exist.");
+        size_t kept{ 0 };
+        for (size_t i = 0; i < relations.size(); ++i)
+            if (!rejected[i])
+                relations[kept++] = relations[i];
+        relations.resize(kept);
+        rejected.assign(kept, false);
     }
 
-    /*! \brief Removes all relations involving the object as a dependent.
-    *   \param dependent the object that is declared as a dependent in the relations to remove
-    *   \warning An assertion occurs if no requirement has been set for this object.
-    * 
-    *   Relations involving the object as a requirement are left.
+    /*! \brief Finds the relations of the batch that close a cycle or are implied by other relations.
+    *   \param bulk the state of the load
+    *   \param rejected flags of the relations of the batch that break a rule
+    *
+    *   A relation between 2 objects of the same strongly connected component closes a cycle. While reflexivity is allowed,
+    *   it is implied by other relations if another path leads from its dependent to its requirement, which is checked by
+    *   one walk of the component per relation.
+    *   A relation (dependent, requirement) between 2 components C and D is implied by other relations if another relation
+    *   leaves C towards D, or if D can be reached from a component reached by a relation leaving C.
+    *   The second case is checked by one walk per component left by the batch, pruned to the components that can still reach
+    *   one of its targets.
     */
-    template <typename T>
-    void Requirements<T>::remove_dependent(const T& dependent)
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::_bulk_implicits(Bulk& bulk, std::vector<bool>& rejected) const
+    {
+        const auto& relations = bulk.relations;
+        if (relations.empty())
+            return;
+        node_id count{ 0 };
+        auto component = _components(count);
+        std::vector<std::vector<node_id>> members(count);
+        for (node_id id = 0; id < m_nodes.size(); ++id)
+            members[component[id]].push_back(id);
+        std::vector<std::vector<size_t>> batch(count);                   // component -> indexes of the relations of the batch leaving it
+        std::vector<size_t> cyclic{};                                    // indexes of the relations of the batch inside a component, while reflexivity is allowed
+        for (size_t i = 0; i < relations.size(); ++i)
+        {
+            auto comp = component[relations[i].first];
+            auto target = component[relations[i].second];
+            if (comp == target)
+            {
+                if (!m_reflexive)
+                {
+                    rejected[i] = true;
+                    bulk.violations.push_back({ m_nodes[relations[i].first], m_nodes[relations[i].second], ViolationKind::Cycle });
+                }
+                else
+                    cyclic.push_back(i);
+                continue;
+            }
+            batch[comp].push_back(i);
+        }
+        // relations inside a cycle: another path from the dependent to the requirement stays in their component
+        std::vector<size_t> seen(cyclic.empty() ? 0 : m_nodes.size(), relations.size());     // node id -> last relation whose walk reached it
+        std::vector<node_id> stack{};
+        for (auto i : cyclic)
+        {
+            auto dep = relations[i].first;
+            auto req = relations[i].second;
+            auto comp = component[dep];
+            seen[dep] = i;
+            for (auto next : m_requirements[dep])
+                if (next != req && component[next] == comp)
+                {
+                    seen[next] = i;
+                    stack.push_back(next);
+                }
+            bool implied{ false };
+            while (!stack.empty() && !implied)
+            {
+                auto id = stack.back();
+                stack.pop_back();
+                for (auto next : m_requirements[id])
+                    if (seen[next] != i && component[next] == comp)
+                    {
+                        if (next == req)
+                        {
+                            implied = true;
+                            break;
+                        }
+                        seen[next] = i;
+                        stack.push_back(next);
+                    }
+            }
+            stack.clear();
+            if (implied)
+            {
+                rejected[i] = true;
+                bulk.violations.push_back({ m_nodes[dep], m_nodes[req], ViolationKind::ImplicitDuplicate });
+            }
+        }
+        // several relations from a component to the same component
+        std::vector<size_t> hits(count, 0);
+        for (node_id comp = 0; comp < count; ++comp)
+        {
+            if (batch[comp].empty())
+                continue;
+            for (auto id : members[comp])
+                for (auto req : m_requirements[id])
+                    ++hits[component[req]];
+            for (auto i : batch[comp])
+                if (hits[component[relations[i].second]] > 1)
+                {
+                    rejected[i] = true;
+                    bulk.violations.push_back({ m_nodes[relations[i].first], m_nodes[relations[i].second], ViolationKind::ImplicitDuplicate });
+                }
+            for (auto id : members[comp])
+                for (auto req : m_requirements[id])
+                    hits[component[req]] = 0;
+        }
+        // components reached through another component: relations only go to components with lower indexes,
+        // so the walk from the components required by C never goes below the lowest component entered by the batch
+        std::vector<node_id> reached(count, npos);
+        std::vector<node_id> expanded(count, npos);
+        for (node_id comp = 0; comp < count; ++comp)
+        {
+            node_id bound{ npos };
+            for (auto i : batch[comp])
+                if (!rejected[i])
+                    bound = std::min(bound, component[relations[i].second]);
+            if (bound == npos)
+                continue;
+            for (auto id : members[comp])
+                for (auto req : m_requirements[id])
+                    if (component[req] != comp && component[req] >= bound)
+                        stack.push_back(component[req]);
+            while (!stack.empty())
+            {
+                auto sub = stack.back();
+                stack.pop_back();
+                if (expanded[sub] == comp)
+                    continue;
+                expanded[sub] = comp;
+                for (auto id : members[sub])
+                    for (auto req : m_requirements[id])
+                    {
+                        auto target = component[req];
+                        if (target != sub && target >= bound && reached[target] != comp)
+                        {
+                            reached[target] = comp;
+                            stack.push_back(target);
+                        }
+                    }
+            }
+            for (auto i : batch[comp])
+                if (!rejected[i] && reached[component[relations[i].second]] == comp)
+                {
+                    rejected[i] = true;
+                    bulk.violations.push_back({ m_nodes[relations[i].first], m_nodes[relations[i].second], ViolationKind::ImplicitDuplicate });
+                }
+        }
+    }
+
+    /*! \brief Removes the relations inserted by a bulk load, as well as the objects interned by it.
+    *   \param bulk the state of the load
+    */
+    template <typename T, typename Allocator>
+    void Requirements<T, Allocator>::_bulk_rollback(Bulk& bulk)
     {
-        auto range = m_requirements.equal_range(dependent);
-        assert(range.first != range.second && "No requirement exists for this argument.");
-        m_requirements.erase(range.first, range.second);
+        for (auto itr = bulk.relations.rbegin(); itr != bulk.relations.rend(); ++itr)
+        {
+            assert(m_requirements[(*itr).first].back() == (*itr).second && m_dependents[(*itr).second].back() == (*itr).first);
+            m_requirements[(*itr).first].pop_back();
+            m_dependents[(*itr).second].pop_back();
+            --m_size;
+        }
+        bulk.relations.clear();
+        m_pending.clear();
+        m_unpublished = 0;
+        while (m_nodes.size() > bulk.nodes)
+        {
+            m_ids.erase(m_nodes.back());
+            m_nodes.pop_back();
+            m_requirements.pop_back();
+            m_dependents.pop_back();
+        }
+        if (m_reach_valid)
+            m_reach.erase(m_reach.begin() + bulk.nodes, m_reach.end());
     }
 
-    /*! \brief Removes all relations involving the object as a requirement.
-    *   \param requirement the object that is declared as a requirement in the relations to remove
-    *   \warning An assertion occurs if no dependent has been set for this object.
-    * 
-    *   Relations involving the object as a dependent are left.
+    /*! \brief Converts a line of text to a relation.
+    *   \param line the line, without its end of line
+    *   \param separator the character between the 2 objects of the relation
+    *   \param number the number of the line, for error messages
+    *   \return the relation (dependent, requirement), empty for blank lines and comments
+    */
+    template <typename T, typename Allocator>
+    std::optional<std::pair<T, T>> Requirements<T, Allocator>::_parse(std::string_view line, char separator, size_t number)
+    {
+        auto first = line.find_first_not_of(" \t");
+        if (first == std::string_view::npos || line[first] == '#')
+            return std::nullopt;
+        auto pos = line.find(separator);
+        if (pos == std::string_view::npos)
+            throw std::invalid_argument("Missing separator at line " + std::to_string(number) + ".");
+        return std::make_pair(_field(line.substr(0, pos), number), _field(line.substr(pos + 1), number));
+    }
+
+    /*! \brief Converts a field of a line of text to an object.
+    *   \param text the field, spaces around it are ignored
+    *   \param number the number of the line, for error messages
+    *   \return the object
+    */
+    template <typename T, typename Allocator>
+    T Requirements<T, Allocator>::_field(std::string_view text, size_t number)
+    {
+        auto first = text.find_first_not_of(" \t");
+        auto last = text.find_last_not_of(" \t");
+        if (first == std::string_view::npos)
+            throw std::invalid_argument("Missing object at line " + std::to_string(number) + ".");
+        text = text.substr(first, last - first + 1);
+        auto invalid = [&text, number] { return std::invalid_argument("Invalid object '" + std::string{ text } + "' at line " + std::to_string(number) + "."); };
+        if constexpr (std::is_same<T, std::string>::value)
+            return T{ text };
+        else if constexpr (std::is_integral<T>::value)
+        {
+            T result{};
+            auto end = text.data() + text.size();
+            auto parsed = std::from_chars(text.data(), end, result);
+            if (parsed.ec != std::errc{} || parsed.ptr != end)
+                throw invalid();
+            return result;
+        }
+        else
+        {
+            T result{};
+            std::istringstream stream{ std::string{ text } };
+            if (!(stream >> result) || !(stream >> std::ws).eof())
+                throw invalid();
+            return result;
+        }
+    }
+
+    /*! \brief Computes the topological levels of the node ids (Kahn algorithm).
+    *   \return the levels of node ids, isolated objects excluded
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::template vector_type<typename Requirements<T, Allocator>::ids_type> Requirements<T, Allocator>::_topological_levels() const
+    {
+        vector_type<ids_type> result{ get_allocator() };
+        std::vector<size_t> pending(m_nodes.size(), 0);                 // node id -> number of requirements not yet placed
+        ids_type level{ get_allocator() };
+        size_t placed{ 0 }, involved{ 0 };
+        for (node_id id = 0; id < m_nodes.size(); ++id)
+        {
+            pending[id] = m_requirements[id].size();
+            if (pending[id] == 0 && !m_dependents[id].empty())
+                level.push_back(id);
+            if (pending[id] != 0 || !m_dependents[id].empty())
+                ++involved;
+        }
+        while (!level.empty())
+        {
+            placed += level.size();
+            ids_type next{ get_allocator() };
+            for (auto id : level)
+                for (auto dep : m_dependents[id])
+                    if (--pending[dep] == 0)
+                        next.push_back(dep);
+            result.push_back(std::move(level));
+            level = std::move(next);
+        }
+        assert(placed == involved && "Topological order is not defined while relations form a cycle.");
+        return result;
+    }
+
+    /*! \brief Constructor. Copies the relations of a Requirements object.
+    *   \param requirements the relations to copy, in the same order and with the same node ids
     */
     template <typename T>
-    void Requirements<T>::remove_requirement(const T& requirement)
+    template <typename Allocator>
+    FrozenRequirements<T>::FrozenRequirements(const Requirements<T, Allocator>& requirements)
+        : m_reflexive(requirements.reflexive())
     {
-        auto itr = m_requirements.begin();
-        bool found{ false };
-        while (itr != m_requirements.end())
+        auto count = requirements.node_count();
+        m_ids.reserve(count);
+        m_nodes.reserve(count);
+        m_requirement_offsets.reserve(count + 1);
+        m_dependent_offsets.reserve(count + 1);
+        m_requirement_targets.reserve(requirements.size());
+        m_dependent_targets.reserve(requirements.size());
+        for (node_id id = 0; id < count; ++id)
         {
-            if ((*itr).second == requirement)
-            {
-                itr = m_requirements.erase(itr);
-                found = true;
-            }
-            else
-                ++itr;
+            m_nodes.push_back(requirements.node(id));
+            m_ids.insert({ m_nodes.back(), id });
+            const auto& reqs = requirements.requirement_ids(id);
+            m_requirement_targets.insert(m_requirement_targets.end(), reqs.begin(), reqs.end());
+            m_requirement_offsets.push_back(m_requirement_targets.size());
+            const auto& deps = requirements.dependent_ids(id);
+            m_dependent_targets.insert(m_dependent_targets.end(), deps.begin(), deps.end());
+            m_dependent_offsets.push_back(m_dependent_targets.size());
         }
-        assert(found && "No requirement exists for this argument.");
     }
 
-    /*! \brief Removes all existing relations involving the object as a dependent or a requirement.
-    *   \param object the object involved as a dependent or a requirement in the relations to remove
+    /*! \brief Gets the node id of an interned object.
+    *   \param object the object to look for
+    *   \return its node id, or npos if the object is unknown
     */
     template <typename T>
-    void Requirements<T>::remove_all(const T& object)
+    typename FrozenRequirements<T>::node_id FrozenRequirements<T>::id_of(const T& object) const noexcept
     {
-        if (has_requirements(object))
-            remove_dependent(object);
-        if (has_dependents(object))
-            remove_requirement(object);
+        auto itr = m_ids.find(object);
+        return itr == m_ids.end() ? npos : (*itr).second;
     }
 
-    /*! \brief Checks if a direct relationship between the given objects exists.
+    /*! \brief Checks if a relationship between the given objects exists.
     *   \param dependent,requirement the 2 objects to check
     *   \param recurse also checks indirect dependencies when set to true, false by default
-    *   \return true if a direct relationship exists with the given direction
-    *   \sa Requirements< T >::requires()
+    *   \return true if a relationship exists with the given direction
     */
     template <typename T>
-    bool Requirements<T>::exists(const T& dependent, const T& requirement, bool recurse) const
+    bool FrozenRequirements<T>::exists(const T& dependent, const T& requirement, bool recurse) const
     {
-        if (recurse)
-            return _requires(dependent, requirement, nullptr);
-        bool found{ false };
-        auto range = m_requirements.equal_range(dependent);
-        auto itr = range.first;
-        while (!found && itr != range.second)
-        {
-            if ((*itr).second == requirement)
-                found = true;
-            ++itr;
+        auto dep = id_of(dependent);
+        auto req = id_of(requirement);
+        if (dep == npos || req == npos)
+            return false;
+        return exists_ids(dep, req, recurse);
+    }
+
+    /*! \brief Checks if a relationship between the given node ids exists.
+    *   \param dependent,requirement the ids of the 2 objects to check
+    *   \param recurse also checks indirect dependencies when set to true, false by default
+    *   \return true if a relationship exists with the given direction
+    */
+    template <typename T>
+    bool FrozenRequirements<T>::exists_ids(node_id dependent, node_id requirement, bool recurse) const
+    {
+        if (!recurse)
+        {
+            auto reqs = requirement_ids(dependent);
+            return std::find(reqs.begin(), reqs.end(), requirement) != reqs.end();
+        }
+        auto& scratch = _scratch();
+        if (scratch.visited.size() < m_nodes.size())
+            scratch.visited.resize(m_nodes.size());
+        bool result{ false };
+        scratch.stack.push_back(dependent);
+        scratch.trail.push_back(dependent);
+        scratch.visited.set(dependent);
+        while (!result && !scratch.stack.empty())
+        {
+            auto id = scratch.stack.back();
+            scratch.stack.pop_back();
+            for (auto req : requirement_ids(id))
+            {
+                if (req == requirement)
+                {
+                    result = true;
+                    break;
+                }
+                if (!scratch.visited.test(req))
+                {
+                    scratch.visited.set(req);
+                    scratch.trail.push_back(req);
+                    scratch.stack.push_back(req);
+                }
+            }
         }
-        return found;
+        for (auto id : scratch.trail)
+            scratch.visited.reset(id);
+        scratch.trail.clear();
+        scratch.stack.clear();
+        return result;
     }
 
     /*! \brief Checks if an object has at least one requirement.
@@ -207,273 +3766,184 @@ namespace Requirements
     *   \return true if at least one requirement has been found for the given object
     */
     template <typename T>
-    bool Requirements<T>::has_requirements(const T& dependent) const noexcept
+    bool FrozenRequirements<T>::has_requirements(const T& dependent) const noexcept
     {
-        auto itr = m_requirements.find(dependent);
-        return itr != m_requirements.end();
+        auto dep = id_of(dependent);
+        return dep != npos && !requirement_ids(dep).empty();
     }
 
-    /*! \brief Checks if an object as at least one dependent.
+    /*! \brief Checks if an object has at least one dependent.
     *   \param requirement the object to check
     *   \return true if at least one dependent has been found for the given object
     */
     template <typename T>
-    bool Requirements<T>::has_dependents(const T& requirement) const noexcept
+    bool FrozenRequirements<T>::has_dependents(const T& requirement) const noexcept
     {
-        bool found{ false };
-        auto itr = m_requirements.begin();
-        while (!found && itr != m_requirements.end())
-        {
-            if ((*itr).second == requirement)
-                found = true;
-            ++itr;
-        }
-        return found;
+        auto req = id_of(requirement);
+        return req != npos && !dependent_ids(req).empty();
     }
 
-    /*! \brief Lists the direct requirements of an object.
+    /*! \brief Views the direct requirements of an object.
     *   \param dependent the object for which direct requirements are searched for
-    *   \return the list of its direct requirements
+    *   \return the view on its direct requirements, empty if the object is unknown
     */
     template <typename T>
-    std::vector<T> Requirements<T>::requirements(const T& dependent) const
+    typename FrozenRequirements<T>::Objects FrozenRequirements<T>::requirements(const T& dependent) const noexcept
     {
-        std::vector<T> result{};
-        auto range = m_requirements.equal_range(dependent);
-        auto itr = range.first;
-        while (itr != range.second)
-        {
-            result.push_back((*itr).second);
-            ++itr;
-        }
-        return result;
+        auto dep = id_of(dependent);
+        return { this, dep == npos ? Span<node_id>{} : requirement_ids(dep) };
     }
 
-    /*! \brief Lists the direct dependents of an object.
+    /*! \brief Views the direct dependents of an object.
     *   \param requirement the object for which direct dependents are searched for
-    *   \return the list of its direct dependents
+    *   \return the view on its direct dependents, empty if the object is unknown
     */
     template <typename T>
-    std::vector<T> Requirements<T>::dependents(const T& requirement) const
+    typename FrozenRequirements<T>::Objects FrozenRequirements<T>::dependents(const T& requirement) const noexcept
     {
-        std::vector<T> result{};
-        auto itr = m_requirements.begin();
-        while (itr != m_requirements.end())
-        {
-            if ((*itr).second == requirement)
-                result.push_back((*itr).first);
-            ++itr;
-        }
-        return result;
+        auto req = id_of(requirement);
+        return { this, req == npos ? Span<node_id>{} : dependent_ids(req) };
     }
 
-    /*! \brief Lists the branches of objects on which the object depends, directly or indirectly.
-    *   \param dependent the object for which direct or indirect requirements are searched for
-    *   \return the list of requirement branches starting with the given object
-    *   \warning An assertion occurs if the object has no direct requirement.
+    /*! \brief Views the ids of the direct requirements of a node.
+    *   \param dependent the id of the object for which direct requirements are searched for
+    *   \return the ids of its direct requirements
     */
     template <typename T>
-    std::vector<std::vector<T>> Requirements<T>::all_requirements(const T& dependent) const
+    Span<typename FrozenRequirements<T>::node_id> FrozenRequirements<T>::requirement_ids(node_id dependent) const noexcept
     {
-        assert(has_requirements(dependent) && "No requirement exists for this argument.");
-        std::vector<std::vector<T>> result{};
-        auto reqs = requirements(dependent);
-        for (auto req : reqs)
-        {
-            std::vector<T> row{ dependent };
-            size_t count{ 0 };
-            if (has_requirements(req))
-            {
-                auto subreqs = all_requirements(req);
-                for (auto sub : subreqs)
-                {
-                    if (sub[1] != dependent)         // avoid infinite loop while reflexivity is active
-                    {
-                        for (auto itr : sub)
-                            row.push_back(itr);
-                        result.push_back(row);
-                        row.clear();
-                        row.push_back(dependent);
-                        ++count;
-                    }
-                }
-            }
-            if (count == 0)
-            {
-                row.push_back(req);
-                result.push_back(row);
-            }
-        }
-        return result;
+        auto first = m_requirement_offsets[dependent];
+        return { m_requirement_targets.data() + first, m_requirement_offsets[dependent + 1] - first };
     }
 
-    /*! \brief Lists the branches of objects that requires the object, directly or indirectly.
-    *   \param requirement the object for which direct or indirect dependents are searched for
-    *   \return the list of dependent branches starting with the given object
-    *   \warning An assertion occurs if the objects has no direct dependent.
+    /*! \brief Views the ids of the direct dependents of a node.
+    *   \param requirement the id of the object for which direct dependents are searched for
+    *   \return the ids of its direct dependents
     */
     template <typename T>
-    std::vector<std::vector<T>> Requirements<T>::all_dependencies(const T& requirement) const
+    Span<typename FrozenRequirements<T>::node_id> FrozenRequirements<T>::dependent_ids(node_id requirement) const noexcept
     {
-        assert(has_dependents(requirement) && "No dependent exists for this argument.");
-        std::vector<std::vector<T>> result{};
-        auto deps = dependents(requirement);
-        for (auto dep : deps)
-        {
-            std::vector<T> row{ requirement };
-            size_t count{ 0 };
-            if (has_dependents(dep))
-            {
-                auto subdeps = all_dependencies(dep);
-                for (auto sub : subdeps)
-                {
-                    if (sub[1] != requirement)       // avoid infinite loops while reflexivity is active
-                    {
-                        for (auto itr : sub)
-                            row.push_back(itr);
-                        result.push_back(row);
-                        row.clear();
-                        row.push_back(requirement);
-                        ++count;
-                    }
-                }
-            }
-            if (count == 0)
-            {
-                row.push_back(dep);
-                result.push_back(row);
-            }
-        }
-        return result;
+        auto first = m_dependent_offsets[requirement];
+        return { m_dependent_targets.data() + first, m_dependent_offsets[requirement + 1] - first };
     }
 
-    /*! \brief Lists all branches of dependencies, from dependents to requirements.
-    *   \param without_duplicates if true only objects that have no dependents are considered as first element of a branch
-    *   \return the list of all branches, from dependents to requirements
+    /*! \brief Lists the objects on which the object depends, directly or indirectly, each object once.
+    *   \param dependent the object for which direct or indirect requirements are searched for
+    *   \return the list of its direct and indirect requirements, in no particular order
+    *   \sa Requirements< T >::transitive_requirements()
     */
     template <typename T>
-    std::vector<std::vector<T>> Requirements<T>::all_requirements(bool without_duplicates) const
+    std::vector<T> FrozenRequirements<T>::transitive_requirements(const T& dependent) const
     {
-        std::vector<std::vector<T>> result{};
-        auto itr = m_requirements.begin();
-        while (itr != m_requirements.end())
-        {
-            if (!without_duplicates || without_duplicates && !has_dependents((*itr).first))
-            {
-                bool exists{ false };
-                auto res = result.begin();
-                while (!exists && res != result.end())
-                {
-                    if ((*res)[0] == (*itr).first)
-                        exists = true;
-                    ++res;
-                }
-                if (!exists)
-                {
-                    auto deps = all_requirements((*itr).first);
-                    for (auto dep : deps)
-                        result.push_back(dep);
-                }
-            }
-            ++itr;
-        }
-        return result;
+        auto dep = id_of(dependent);
+        return dep == npos ? std::vector<T>{} : _closure(dep, true);
     }
 
-    /*! \brief Lists all branches of dependencies, from requirements to dependents.
-    *   \param without_duplicates if true only objects that not depends on another object are considered as first element of a branch
-    *   \return the list of all branches, from requirements to dependents
+    /*! \brief Lists the objects that depend on the object, directly or indirectly, each object once.
+    *   \param requirement the object for which direct or indirect dependents are searched for
+    *   \return the list of its direct and indirect dependents, in no particular order
+    *   \sa Requirements< T >::transitive_dependents()
     */
     template <typename T>
-    std::vector<std::vector<T>> Requirements<T>::all_dependencies(bool without_duplicates) const
+    std::vector<T> FrozenRequirements<T>::transitive_dependents(const T& requirement) const
     {
-        std::vector<std::vector<T>> result{};
-        auto itr = m_requirements.begin();
-        while (itr != m_requirements.end())
-        {
-            if (!without_duplicates || without_duplicates && !has_requirements((*itr).second))
-            {
-                bool exists{ false };
-                auto res = result.begin();
-                while (!exists && res != result.end())
-                {
-                    if ((*res)[0] == (*itr).second)
-                        exists = true;
-                    ++res;
-                }
-                if (!exists)                                // Each requirement must be processed one time to avoid duplicates
-                {
-                    auto reqs = all_dependencies((*itr).second);
-                    for (auto req : reqs)
-                        result.push_back(req);
-                }
-            }
-            ++itr;
-        }
-        return result;
+        auto req = id_of(requirement);
+        return req == npos ? std::vector<T>{} : _closure(req, false);
     }
 
-    /*! \brief List all pairs of objects (dependent, requirement).
-    *   \return the list of requested pairs
+    /*! \brief Lists the objects that depend on the object, nearest first, within a depth and a number of objects.
+    *   \param requirement the object that changes
+    *   \param max_depth the maximum number of relations between the object and a dependent listed, 1 for its direct dependents only
+    *   \param max_objects the maximum number of dependents listed
+    *   \return the dependents found, by increasing distance, the object itself excluded
+    *   \sa Requirements< T >::impacted_dependents()
     */
     template <typename T>
-    std::unordered_multimap<T, T> Requirements<T>::get() const
+    std::vector<T> FrozenRequirements<T>::impacted_dependents(const T& requirement, size_t max_depth, size_t max_objects) const
     {
-        std::unordered_multimap<T, T> result{};
-        auto itr = m_requirements.begin();
-        while (itr != m_requirements.end())
-        {
-            result.insert({ (*itr).first, (*itr).second });
-            ++itr;
-        }
-        return result;
+        return impacted_dependents(requirement, max_depth, max_objects, [](const T&) { return true; });
     }
 
-    /*! \brief Sets dependencies from the given list. The list of dependencies is first cleared.
-    *   \param requirements the list of pairs (dependent, requirement) to create
-    *   \warning Controls are performed and an assertion occurs if rules are broken.
-    *   \sa Requirements< T >::add()
-        \sa Requirements< T >::merge()
+    /*! \brief Lists the objects that depend on the object, nearest first, within limits and stopping at the objects rejected by a predicate.
+    *   \param requirement the object that changes
+    *   \param max_depth the maximum number of relations between the object and a dependent listed, 1 for its direct dependents only
+    *   \param max_objects the maximum number of dependents listed
+    *   \param expand the function called with each dependent before the walk goes through it, that returns false to stop there
+    *   \return the dependents found, by increasing distance, the object itself excluded
+    *   \sa Requirements< T >::impacted_dependents(const T&, size_t, size_t, Predicate)
     */
     template <typename T>
-    void Requirements<T>::set(const std::unordered_multimap<T, T>& requirements)
+    template <typename Predicate>
+    std::vector<T> FrozenRequirements<T>::impacted_dependents(const T& requirement, size_t max_depth, size_t max_objects, Predicate expand) const
     {
-        clear();
-        merge(requirements);
+        std::vector<T> result{};
+        auto start = id_of(requirement);
+        if (start == npos || max_depth == 0 || max_objects == 0)
+            return result;
+        auto& scratch = _scratch();
+        detail::bounded_walk(start, max_depth, max_objects, m_nodes.size(), scratch.trail, scratch.visited,
+            [this](node_id id) { return dependent_ids(id); },
+            [this, &expand](node_id id) { return static_cast<bool>(expand(m_nodes[id])); },
+            [this, &result](node_id id) { result.push_back(m_nodes[id]); });
+        return result;
     }
 
-    /*! \brief Adds dependencies from the given list.
-    *   \param requirements the list of pairs (dependent, requirement) to add
-    *   \warning Controls are performed and an assertion occurs if rules are broken.
-    *   \sa Requirements< T >::add()
-        \sa Requirements< T >::set()
+    /*! \brief Reports the bytes allocated by the instance, by part.
+    *   \return the bytes of the objects and their table and of the lists, the scratch buffers of the threads not being counted
+    *   \sa MemoryUsage
     */
     template <typename T>
-    void Requirements<T>::merge(const std::unordered_multimap<T, T>& requirements)
+    MemoryUsage FrozenRequirements<T>::memory_usage() const noexcept
     {
-        auto itr = requirements.begin();
-        while (itr != requirements.end())
-        {
-            add((*itr).first, (*itr).second);
-            ++itr;
-        }
+        MemoryUsage result{};
+        result.index = m_ids.bucket_count() * sizeof(void*) + m_ids.size() * (sizeof(typename decltype(m_ids)::value_type) + sizeof(void*) + sizeof(size_t))
+            + m_nodes.capacity() * sizeof(T);
+        result.adjacency = (m_requirement_offsets.capacity() + m_dependent_offsets.capacity()) * sizeof(size_t)
+            + (m_requirement_targets.capacity() + m_dependent_targets.capacity()) * sizeof(node_id);
+        return result;
     }
 
     template <typename T>
-    bool Requirements<T>::_requires(const T& dependent, const T& requirement, const T* prev) const
+    typename FrozenRequirements<T>::Scratch& FrozenRequirements<T>::_scratch() noexcept
     {
-        bool result = exists(dependent, requirement);
-        if (!result && has_requirements(dependent))
-        {
-            auto reqs = requirements(dependent);
-            auto req = reqs.begin();
-            while (!result && req != reqs.end())
+        static thread_local Scratch scratch{};
+        return scratch;
+    }
+
+    /*! \brief Lists the objects reachable from a node through at least one relation (breadth-first walk).
+    *   \param start the id of the object to start from
+    *   \param forward walks requirements if true, dependents otherwise
+    *   \return the objects reached
+    */
+    template <typename T>
+    std::vector<T> FrozenRequirements<T>::_closure(node_id start, bool forward) const
+    {
+        auto& scratch = _scratch();
+        if (scratch.visited.size() < m_nodes.size())
+            scratch.visited.resize(m_nodes.size());
+        bool cycle{ false };
+        scratch.trail.push_back(start);
+        scratch.visited.set(start);
+        for (size_t head = 0; head < scratch.trail.size(); ++head)
+            for (auto id : forward ? requirement_ids(scratch.trail[head]) : dependent_ids(scratch.trail[head]))
             {
-                if (prev == nullptr || !(*req == *prev))
-                    result = _requires(*req, requirement, &dependent);
-                ++req;
+                if (id == start)
+                    cycle = true;
+                if (!scratch.visited.test(id))
+                {
+                    scratch.visited.set(id);
+                    scratch.trail.push_back(id);
+                }
             }
-        }
+        std::vector<T> result{};
+        result.reserve(scratch.trail.size() - (cycle ? 0 : 1));
+        if (cycle)
+            result.push_back(m_nodes[start]);
+        for (size_t i = 1; i < scratch.trail.size(); ++i)
+            result.push_back(m_nodes[scratch.trail[i]]);
+        for (auto id : scratch.trail)
+            scratch.visited.reset(id);
+        scratch.trail.clear();
         return result;
     }
 
@@ -0,0 +1,872 @@
+#pragma once
+
+/*! \file requirements_concurrent.hpp
+*	\brief Implements the template class ConcurrentRequirements.
+*   \author Christophe COUAILLET
+*
+*   Programs including this header must link with the threads library of the platform.
+*/
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "requirements.hpp"
+
+namespace Requirements
+{
+
+    /*! \brief ConcurrentRequirements shares relations between writers and any number of readers that never lock.
+
+        Writers are serialized and apply each change to a private Requirements object, which checks the rules as usual.
+        The result is published as a new immutable version in which only the adjacency lists changed by the update are copied:
+        lists are stored in pages of page_size entries and the pages left untouched are shared with the previous version.
+        Readers work on a Snapshot, a consistent view on the last published version, taken without lock nor reference counting.
+        A replaced version is released by the writers once all the snapshots that may see it are gone (epoch-based reclamation).
+
+        Objects keep the node ids of the private Requirements object, so ids are stable until clear(), set() or bulk_set().
+        \warning Interned objects and relations are stored twice, once for the writers and once for the readers.
+    */
+    template <typename T>
+    class ConcurrentRequirements
+    {
+        struct State;
+        struct Slot;
+
+    public:
+
+        using node_id = typename Requirements<T>::node_id;                                      //!< dense identifier of an interned object
+        static constexpr node_id npos = Requirements<T>::npos;                                  //!< id returned for unknown objects
+        static constexpr size_t page_size = 256;                                                //!< number of objects or lists per page of a version
+
+        /*! \brief Snapshot is a read-only view on a published version of the relations.
+
+            A snapshot holds a reader slot of its instance and delays the release of the versions published after it was taken,
+            so it should be kept for the duration of a query only. It must not outlive its instance.
+            The members of a snapshot must not be called concurrently, distinct snapshots can be used from distinct threads.
+        */
+        class Snapshot
+        {
+        public:
+            Snapshot(Snapshot&& other) noexcept : m_state(other.m_state), m_slot(other.m_slot) { other.m_slot = nullptr; };
+            Snapshot(const Snapshot&) = delete;
+            Snapshot& operator=(const Snapshot&) = delete;
+            Snapshot& operator=(Snapshot&&) = delete;
+            ~Snapshot();
+
+            /*! \brief Gets the version of the relations seen by the snapshot, incremented by each update.
+            *   \return the version number
+            */
+            std::uint64_t version() const noexcept { return m_state->version; }
+
+            /*! \brief Checks if the version contains dependencies.
+            *   \return true if no dependency exists
+            */
+            bool empty() const noexcept { return m_state->size == 0; }
+
+            /*! \brief Gets the number of dependencies of the version.
+            *   \return the number of dependencies
+            */
+            size_t size() const noexcept { return m_state->size; }
+
+            /*! \brief Gets the number of interned objects, i.e. the upper bound of node ids.
+            *   \return the number of interned objects
+            */
+            size_t node_count() const noexcept { return m_state->count; }
+
+            /*! \brief Gets the object interned with the given id.
+            *   \param id a node id lower than node_count()
+            *   \return the interned object
+            */
+            const T& node(node_id id) const noexcept { return m_state->node(id); }
+
+            /*! \brief Gets the node id of an interned object.
+            *   \param object the object to look for
+            *   \return its node id, or npos if the object is unknown
+            */
+            node_id id_of(const T& object) const noexcept { return m_state->find(object); }
+
+            /*! \brief Lists the ids of the direct requirements of a node.
+            *   \param dependent the id of the object for which direct requirements are searched for
+            *   \return the ids of its direct requirements
+            */
+            const std::vector<node_id>& requirement_ids(node_id dependent) const noexcept { return m_state->list(m_state->requirements, dependent); }
+
+            /*! \brief Lists the ids of the direct dependents of a node.
+            *   \param requirement the id of the object for which direct dependents are searched for
+            *   \return the ids of its direct dependents
+            */
+            const std::vector<node_id>& dependent_ids(node_id requirement) const noexcept { return m_state->list(m_state->dependents, requirement); }
+
+            bool exists(const T& dependent, const T& requirement, bool recurse = false) const;         // checks direct or indirect dependency
+            bool exists_ids(node_id dependent, node_id requirement, bool recurse = false) const;    // id-based overload of exists()
+            bool has_requirements(const T& dependent) const noexcept;
+            bool has_dependents(const T& requirement) const noexcept;
+            std::vector<T> requirements(const T& dependent) const;                              // lists direct requirements of dependent
+            std::vector<T> dependents(const T& requirement) const;                              // lists direct dependents of requirement
+
+        private:
+            friend class ConcurrentRequirements<T>;
+            Snapshot(const State* state, Slot* slot) noexcept : m_state(state), m_slot(slot) {};
+            const State* m_state;
+            Slot* m_slot;
+        };
+
+        /*! \brief Constructor.
+        *   \param reflexive sets the reflexive mode
+        *   \param readers the number of snapshots that can exist at the same time, 4 times the number of hardware threads if 0
+        *
+        *   Taking a snapshot while all reader slots are used waits until one is released.
+        */
+        explicit ConcurrentRequirements(bool reflexive = false, size_t readers = 0);
+
+        /*! \brief Destructor.
+        *   \warning No snapshot must remain.
+        */
+        ~ConcurrentRequirements();
+
+        ConcurrentRequirements(const ConcurrentRequirements&) = delete;
+        ConcurrentRequirements& operator=(const ConcurrentRequirements&) = delete;
+
+        /*! \brief Informs on the reflexive status of the instance.
+        *   \return true if reflexive mode is activated
+        */
+        bool reflexive() const noexcept { return m_reflexive; }
+
+        Snapshot snapshot() const;                                                              // views the last published version
+
+        // updates, serialized and published as a new version each
+
+        void clear();
+        void add(const T& dependent, const T& requirement);
+        void remove(const T& dependent, const T& requirement);
+        void remove_dependent(const T& dependent);
+        void remove_requirement(const T& requirement);
+        void remove_all(const T& object);
+        void set(const std::unordered_multimap<T, T>& requirements);
+        void merge(const std::unordered_multimap<T, T>& requirements);
+        std::vector<Violation<T>> bulk_set(const std::unordered_multimap<T, T>& requirements);
+        std::vector<Violation<T>> bulk_merge(const std::unordered_multimap<T, T>& requirements);
+        size_t compact(size_t limit = std::numeric_limits<size_t>::max());                     // reclaims the slots of the objects retired by remove_all()
+        void cache_reachability(bool enable);                                                   // activates the reachability cache used by the checks of the updates
+
+        // queries, each one on a snapshot of its own
+
+        bool empty() const { return snapshot().empty(); }                                       //!< \sa Snapshot::empty()
+        size_t size() const { return snapshot().size(); }                                       //!< \sa Snapshot::size()
+        bool exists(const T& dependent, const T& requirement, bool recurse = false) const { return snapshot().exists(dependent, requirement, recurse); }   //!< \sa Snapshot::exists()
+        bool has_requirements(const T& dependent) const { return snapshot().has_requirements(dependent); }     //!< \sa Snapshot::has_requirements()
+        bool has_dependents(const T& requirement) const { return snapshot().has_dependents(requirement); }     //!< \sa Snapshot::has_dependents()
+        std::vector<T> requirements(const T& dependent) const { return snapshot().requirements(dependent); }   //!< \sa Snapshot::requirements()
+        std::vector<T> dependents(const T& requirement) const { return snapshot().dependents(requirement); }   //!< \sa Snapshot::dependents()
+
+    private:
+        using List = std::vector<node_id>;
+
+        struct ListPage
+        {
+            std::array<List*, page_size> lists{};                      // nullptr for empty lists
+        };
+
+        struct NodePage
+        {
+            alignas(T) unsigned char storage[page_size * sizeof(T)];    // objects are constructed in place and never moved
+
+            void* raw(size_t pos) noexcept { return storage + pos * sizeof(T); }
+            T* at(size_t pos) noexcept { return std::launder(reinterpret_cast<T*>(raw(pos))); }
+            const T* at(size_t pos) const noexcept { return std::launder(reinterpret_cast<const T*>(storage + pos * sizeof(T))); }
+        };
+
+        struct IndexPage
+        {
+            std::array<node_id, page_size> slots;
+
+            IndexPage() noexcept { slots.fill(npos); }
+        };
+
+        // a published version, never modified once published except for objects appended after its count
+        struct State
+        {
+            std::uint64_t version{ 0 };
+            size_t size{ 0 };                                           // number of relations
+            size_t count{ 0 };                                          // number of interned objects
+            unsigned index_bits{ 0 };                                   // log2 of the number of slots of the index, 0 if no index
+            std::vector<NodePage*> nodes{};                             // node id -> object, pages shared by all the versions between two clear()
+            std::vector<ListPage*> requirements{};                      // node id -> ids of its requirements
+            std::vector<ListPage*> dependents{};                        // node id -> ids of its dependents
+            std::vector<IndexPage*> index{};                            // object -> node id, open addressing table with linear probing
+
+            const T& node(node_id id) const noexcept { return *nodes[id / page_size]->at(id % page_size); }
+            const List& list(const std::vector<ListPage*>& table, node_id id) const noexcept;
+            node_id find(const T& object) const noexcept;
+        };
+
+        struct alignas(64) Slot
+        {
+            std::atomic<std::uint64_t> epoch{ 0 };                      // epoch at which the snapshot was taken, 0 if the slot is free
+        };
+
+        struct Retired
+        {
+            std::uint64_t epoch;                                        // epoch of the version that replaced the object
+            void* object;
+            void (*release)(void*);
+        };
+
+        const bool m_reflexive;
+        Requirements<T> m_master;                                       // relations of the writers
+        std::mutex m_writer{};
+        std::atomic<State*> m_state{ nullptr };                         // last published version
+        std::atomic<std::uint64_t> m_epoch{ 1 };
+        const size_t m_readers;
+        std::unique_ptr<Slot[]> m_slots;
+        std::vector<Retired> m_retiring{};                              // objects replaced by the version being built
+        std::vector<Retired> m_retired{};                               // objects waiting for the end of older snapshots
+
+        static size_t _hash(const T& object, unsigned bits) noexcept;
+        template <typename X>
+        static void _delete(void* object) { delete static_cast<X*>(object); }
+        static void _destroy(void* state);
+
+        Slot& _pin() const;
+        void _retire(void* object, void (*release)(void*)) { m_retiring.push_back({ 0, object, release }); }
+        template <typename Page>
+        Page* _own(std::vector<Page*>& pages, const std::vector<Page*>& published, size_t page);
+        void _grow(State& draft, const State& base);
+        void _index(State& draft, const State& base, node_id id);
+        void _rehash(State& draft, const State& base, unsigned bits);
+        void _sync(State& draft, const State& base, std::vector<node_id>& ids, bool forward);
+        void _update(std::vector<node_id> forward, std::vector<node_id> backward);
+        void _rebuild();
+        void _publish(State* draft, bool replace);
+        void _reclaim();
+    };
+
+    // Implementation of classes and functions
+
+    template <typename T>
+    ConcurrentRequirements<T>::Snapshot::~Snapshot()
+    {
+        if (m_slot != nullptr)
+            m_slot->epoch.store(0);
+    }
+
+    /*! \brief Checks if a relationship between the given objects exists in the version.
+    *   \param dependent,requirement the 2 objects to check
+    *   \param recurse also checks indirect dependencies when set to true, false by default
+    *   \return true if a relationship exists with the given direction
+    */
+    template <typename T>
+    bool ConcurrentRequirements<T>::Snapshot::exists(const T& dependent, const T& requirement, bool recurse) const
+    {
+        auto dep = id_of(dependent);
+        auto req = id_of(requirement);
+        if (dep == npos || req == npos)
+            return false;
+        return exists_ids(dep, req, recurse);
+    }
+
+    /*! \brief Checks if a relationship between the given node ids exists in the version.
+    *   \param dependent,requirement the ids of the 2 objects to check
+    *   \param recurse also checks indirect dependencies when set to true, false by default
+    *   \return true if a relationship exists with the given direction
+    *
+    *   The recursive walk uses scratch buffers owned by the calling thread, so no allocation occurs once they have grown.
+    */
+    template <typename T>
+    bool ConcurrentRequirements<T>::Snapshot::exists_ids(node_id dependent, node_id requirement, bool recurse) const
+    {
+        if (!recurse)
+        {
+            const auto& reqs = requirement_ids(dependent);
+            return std::find(reqs.begin(), reqs.end(), requirement) != reqs.end();
+        }
+        static thread_local Bitset visited{};
+        static thread_local std::vector<node_id> stack{};
+        static thread_local std::vector<node_id> trail{};
+        if (visited.size() < node_count())
+            visited.resize(node_count());
+        bool result{ false };
+        stack.push_back(dependent);
+        trail.push_back(dependent);
+        visited.set(dependent);
+        while (!result && !stack.empty())
+        {
+            auto id = stack.back();
+            stack.pop_back();
+            for (auto req : requirement_ids(id))
+            {
+                if (req == requirement)
+                {
+                    result = true;
+                    break;
+                }
+                if (!visited.test(req))
+                {
+                    visited.set(req);
+                    trail.push_back(req);
+                    stack.push_back(req);
+                }
+            }
+        }
+        for (auto id : trail)
+            visited.reset(id);
+        trail.clear();
+        stack.clear();
+        return result;
+    }
+
+    /*! \brief Checks if an object has at least one requirement in the version.
+    *   \param dependent the object to check
+    *   \return true if at least one requirement has been found for the given object
+    */
+    template <typename T>
+    bool ConcurrentRequirements<T>::Snapshot::has_requirements(const T& dependent) const noexcept
+    {
+        auto dep = id_of(dependent);
+        return dep != npos && !requirement_ids(dep).empty();
+    }
+
+    /*! \brief Checks if an object has at least one dependent in the version.
+    *   \param requirement the object to check
+    *   \return true if at least one dependent has been found for the given object
+    */
+    template <typename T>
+    bool ConcurrentRequirements<T>::Snapshot::has_dependents(const T& requirement) const noexcept
+    {
+        auto req = id_of(requirement);
+        return req != npos && !dependent_ids(req).empty();
+    }
+
+    /*! \brief Lists the direct requirements of an object in the version.
+    *   \param dependent the object for which direct requirements are searched for
+    *   \return the list of its direct requirements
+    */
+    template <typename T>
+    std::vector<T> ConcurrentRequirements<T>::Snapshot::requirements(const T& dependent) const
+    {
+        std::vector<T> result{};
+        auto dep = id_of(dependent);
+        if (dep == npos)
+            return result;
+        result.reserve(requirement_ids(dep).size());
+        for (auto req : requirement_ids(dep))
+            result.push_back(node(req));
+        return result;
+    }
+
+    /*! \brief Lists the direct dependents of an object in the version.
+    *   \param requirement the object for which direct dependents are searched for
+    *   \return the list of its direct dependents
+    */
+    template <typename T>
+    std::vector<T> ConcurrentRequirements<T>::Snapshot::dependents(const T& requirement) const
+    {
+        std::vector<T> result{};
+        auto req = id_of(requirement);
+        if (req == npos)
+            return result;
+        result.reserve(dependent_ids(req).size());
+        for (auto dep : dependent_ids(req))
+            result.push_back(node(dep));
+        return result;
+    }
+
+    template <typename T>
+    const typename ConcurrentRequirements<T>::List& ConcurrentRequirements<T>::State::list(const std::vector<ListPage*>& table, node_id id) const noexcept
+    {
+        static const List none{};
+        auto list = table[id / page_size]->lists[id % page_size];
+        return list != nullptr ? *list : none;
+    }
+
+    template <typename T>
+    typename ConcurrentRequirements<T>::node_id ConcurrentRequirements<T>::State::find(const T& object) const noexcept
+    {
+        if (index_bits == 0)
+            return npos;
+        auto mask = (size_t{ 1 } << index_bits) - 1;
+        for (auto slot = _hash(object, index_bits);; slot = (slot + 1) & mask)
+        {
+            auto id = index[slot / page_size]->slots[slot % page_size];
+            if (id == npos || node(id) == object)
+                return id;
+        }
+    }
+
+    template <typename T>
+    ConcurrentRequirements<T>::ConcurrentRequirements(bool reflexive, size_t readers)
+        : m_reflexive(reflexive), m_master(reflexive),
+        m_readers(readers != 0 ? readers : std::max<size_t>(1, std::thread::hardware_concurrency()) * 4),
+        m_slots(new Slot[m_readers])
+    {
+        m_state.store(new State{});
+    }
+
+    template <typename T>
+    ConcurrentRequirements<T>::~ConcurrentRequirements()
+    {
+        for (size_t i = 0; i < m_readers; ++i)
+            assert(m_slots[i].epoch == 0 && "A snapshot outlives its instance.");
+        for (auto& retired : m_retired)
+            retired.release(retired.object);
+        _destroy(m_state.load());
+    }
+
+    /*! \brief Takes a snapshot of the last published version.
+    *   \return the snapshot
+    *
+    *   The reader announces the current epoch in a free slot before reading the version, so that the writers keep
+    *   every version it may see. No lock is taken, the call only waits if all the reader slots are used.
+    */
+    template <typename T>
+    typename ConcurrentRequirements<T>::Snapshot ConcurrentRequirements<T>::snapshot() const
+    {
+        auto& slot = _pin();
+        return { m_state.load(), &slot };
+    }
+
+    /*! \brief Clears all dependencies and interned objects.
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::clear()
+    {
+        std::lock_guard<std::mutex> lock{ m_writer };
+        m_master.clear();
+        _rebuild();
+    }
+
+    /*! \brief Add a relation where dependent depends on requirement.
+    *   \param dependent the object that depends on the other object
+    *   \param requirement the object on which the first object depends
+    *   \sa Requirements< T >::add()
+    *
+    *   The requirements of dependent and the dependents of requirement are the only lists copied in the new version.
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::add(const T& dependent, const T& requirement)
+    {
+        std::lock_guard<std::mutex> lock{ m_writer };
+        m_master.add(dependent, requirement);
+        _update({ m_master.id_of(dependent) }, { m_master.id_of(requirement) });
+    }
+
+    /*! \brief Removes an existing relation where dependent depends on requirement.
+    *   \param dependent,requirement the 2 objects involved in the dependency to remove
+    *   \sa Requirements< T >::remove()
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::remove(const T& dependent, const T& requirement)
+    {
+        std::lock_guard<std::mutex> lock{ m_writer };
+        m_master.remove(dependent, requirement);
+        auto dep = m_master.id_of(dependent);
+        auto req = m_master.id_of(requirement);
+        if (dep != npos && req != npos)
+            _update({ dep }, { req });
+    }
+
+    /*! \brief Removes all relations involving the object as a dependent.
+    *   \param dependent the object that is declared as a dependent in the relations to remove
+    *   \sa Requirements< T >::remove_dependent()
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::remove_dependent(const T& dependent)
+    {
+        std::lock_guard<std::mutex> lock{ m_writer };
+        auto dep = m_master.id_of(dependent);
+        std::vector<node_id> reqs{};
+        if (dep != npos)
+            reqs = m_master.requirement_ids(dep);
+        m_master.remove_dependent(dependent);
+        if (dep != npos)
+            _update({ dep }, std::move(reqs));
+    }
+
+    /*! \brief Removes all relations involving the object as a requirement.
+    *   \param requirement the object that is declared as a requirement in the relations to remove
+    *   \sa Requirements< T >::remove_requirement()
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::remove_requirement(const T& requirement)
+    {
+        std::lock_guard<std::mutex> lock{ m_writer };
+        auto req = m_master.id_of(requirement);
+        std::vector<node_id> deps{};
+        if (req != npos)
+            deps = m_master.dependent_ids(req);
+        m_master.remove_requirement(requirement);
+        if (req != npos)
+            _update(std::move(deps), { req });
+    }
+
+    /*! \brief Removes all existing relations involving the object as a dependent or a requirement.
+    *   \param object the object involved as a dependent or a requirement in the relations to remove
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::remove_all(const T& object)
+    {
+        std::lock_guard<std::mutex> lock{ m_writer };
+        auto id = m_master.id_of(object);
+        if (id == npos)
+            return;
+        std::vector<node_id> forward{ m_master.dependent_ids(id) };
+        std::vector<node_id> backward{ m_master.requirement_ids(id) };
+        forward.push_back(id);
+        backward.push_back(id);
+        m_master.remove_all(object);
+        _update(std::move(forward), std::move(backward));
+    }
+
+    /*! \brief Sets dependencies from the given list. The list of dependencies is first cleared.
+    *   \param requirements the list of pairs (dependent, requirement) to create
+    *   \sa Requirements< T >::set()
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::set(const std::unordered_multimap<T, T>& requirements)
+    {
+        std::lock_guard<std::mutex> lock{ m_writer };
+        m_master.set(requirements);
+        _rebuild();
+    }
+
+    /*! \brief Adds dependencies from the given list, published as a single version.
+    *   \param requirements the list of pairs (dependent, requirement) to add
+    *   \sa Requirements< T >::merge()
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::merge(const std::unordered_multimap<T, T>& requirements)
+    {
+        std::lock_guard<std::mutex> lock{ m_writer };
+        m_master.merge(requirements);
+        std::vector<node_id> forward{};
+        std::vector<node_id> backward{};
+        for (const auto& pair : requirements)
+        {
+            forward.push_back(m_master.id_of(pair.first));
+            backward.push_back(m_master.id_of(pair.second));
+        }
+        _update(std::move(forward), std::move(backward));
+    }
+
+    /*! \brief Sets dependencies from the given list, checking all the rules at once. The list of dependencies is first cleared.
+    *   \param requirements the list of pairs (dependent, requirement) to create
+    *   \return the relations that break a rule, empty on success
+    *   \sa Requirements< T >::bulk_set()
+    *
+    *   Nothing is published if a rule is broken.
+    */
+    template <typename T>
+    std::vector<Violation<T>> ConcurrentRequirements<T>::bulk_set(const std::unordered_multimap<T, T>& requirements)
+    {
+        std::lock_guard<std::mutex> lock{ m_writer };
+        auto result = m_master.bulk_set(requirements);
+        if (result.empty())
+            _rebuild();
+        return result;
+    }
+
+    /*! \brief Adds dependencies from the given list, checking all the rules at once.
+    *   \param requirements the list of pairs (dependent, requirement) to add
+    *   \return the relations that break a rule, empty on success
+    *   \sa Requirements< T >::bulk_merge()
+    *
+    *   Nothing is published if a rule is broken.
+    */
+    template <typename T>
+    std::vector<Violation<T>> ConcurrentRequirements<T>::bulk_merge(const std::unordered_multimap<T, T>& requirements)
+    {
+        std::lock_guard<std::mutex> lock{ m_writer };
+        auto result = m_master.bulk_merge(requirements);
+        if (!result.empty())
+            return result;
+        std::vector<node_id> forward{};
+        std::vector<node_id> backward{};
+        for (const auto& pair : requirements)
+        {
+            forward.push_back(m_master.id_of(pair.first));
+            backward.push_back(m_master.id_of(pair.second));
+        }
+        _update(std::move(forward), std::move(backward));
+        return result;
+    }
+
+    /*! \brief Reclaims the slots of the objects retired by remove_all().
+    *   \param limit the maximum number of slots to reclaim
+    *   \return the number of slots reclaimed
+    *   \sa Requirements< T >::compact()
+    *
+    *   Node ids change, so a new version is rebuilt and published if a slot is reclaimed. Existing snapshots keep their ids.
+    */
+    template <typename T>
+    size_t ConcurrentRequirements<T>::compact(size_t limit)
+    {
+        std::lock_guard<std::mutex> lock{ m_writer };
+        auto result = m_master.compact(limit);
+        if (result != 0)
+            _rebuild();
+        return result;
+    }
+
+    /*! \brief Activates or deactivates the reachability cache of the writers.
+    *   \param enable true to activate the cache, false to release it
+    *   \sa Requirements< T >::cache_reachability()
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::cache_reachability(bool enable)
+    {
+        std::lock_guard<std::mutex> lock{ m_writer };
+        m_master.cache_reachability(enable);
+    }
+
+    template <typename T>
+    size_t ConcurrentRequirements<T>::_hash(const T& object, unsigned bits) noexcept
+    {
+        std::uint64_t hash = std::hash<T>{}(object);
+        return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+    }
+
+    /*! \brief Releases a version with all its pages, lists and objects.
+    *   \param state the version to release, the last one published before a clear()
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::_destroy(void* state)
+    {
+        auto version = static_cast<State*>(state);
+        for (auto table : { &version->requirements, &version->dependents })
+            for (auto page : *table)
+            {
+                for (auto list : page->lists)
+                    delete list;
+                delete page;
+            }
+        for (auto page : version->index)
+            delete page;
+        for (size_t id = 0; id < version->count; ++id)
+            version->nodes[id / page_size]->at(id % page_size)->~T();
+        for (auto page : version->nodes)
+            delete page;
+        delete version;
+    }
+
+    /*! \brief Reserves a reader slot and announces the current epoch in it.
+    *   \return the reserved slot
+    */
+    template <typename T>
+    typename ConcurrentRequirements<T>::Slot& ConcurrentRequirements<T>::_pin() const
+    {
+        static thread_local size_t hint{ std::hash<std::thread::id>{}(std::this_thread::get_id()) };
+        for (size_t attempt = 0;; ++attempt)
+        {
+            auto& slot = m_slots[(hint + attempt) % m_readers];
+            std::uint64_t expected{ 0 };
+            if (slot.epoch.load(std::memory_order_relaxed) == 0 && slot.epoch.compare_exchange_strong(expected, m_epoch.load()))
+            {
+                hint += attempt;
+                return slot;
+            }
+            if (attempt % m_readers == m_readers - 1)
+                std::this_thread::yield();
+        }
+    }
+
+    /*! \brief Gets a page of the version being built that can be modified, copying it if it is shared with the published version.
+    *   \param pages the pages of the version being built
+    *   \param published the pages of the published version
+    *   \param page the index of the page
+    *   \return the page to modify
+    */
+    template <typename T>
+    template <typename Page>
+    Page* ConcurrentRequirements<T>::_own(std::vector<Page*>& pages, const std::vector<Page*>& published, size_t page)
+    {
+        if (page < published.size() && pages[page] == published[page])
+        {
+            auto copy = new Page(*pages[page]);
+            _retire(pages[page], &_delete<Page>);
+            pages[page] = copy;
+        }
+        return pages[page];
+    }
+
+    /*! \brief Appends the objects interned by the writers since the published version.
+    *   \param draft the version being built
+    *   \param base the published version
+    *
+    *   Objects are constructed after the count of the published version, in pages that the readers do not access there.
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::_grow(State& draft, const State& base)
+    {
+        auto first = draft.count;
+        auto count = m_master.node_count();
+        if (count == first)
+            return;
+        for (auto id = first; id < count; ++id)
+        {
+            if (id % page_size == 0)
+            {
+                draft.nodes.push_back(new NodePage);
+                draft.requirements.push_back(new ListPage{});
+                draft.dependents.push_back(new ListPage{});
+            }
+            new (draft.nodes[id / page_size]->raw(id % page_size)) T(m_master.node(static_cast<node_id>(id)));
+        }
+        draft.count = count;
+        unsigned bits{ 8 };
+        while ((size_t{ 1 } << bits) < count * 2)
+            ++bits;
+        if (bits > draft.index_bits)
+            _rehash(draft, base, bits);
+        else
+            for (auto id = first; id < count; ++id)
+                _index(draft, base, static_cast<node_id>(id));
+    }
+
+    /*! \brief Inserts an object in the index of the version being built.
+    *   \param draft the version being built
+    *   \param base the published version
+    *   \param id the id of the object
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::_index(State& draft, const State& base, node_id id)
+    {
+        auto mask = (size_t{ 1 } << draft.index_bits) - 1;
+        auto slot = _hash(draft.node(id), draft.index_bits);
+        while (draft.index[slot / page_size]->slots[slot % page_size] != npos)
+            slot = (slot + 1) & mask;
+        _own(draft.index, base.index, slot / page_size)->slots[slot % page_size] = id;
+    }
+
+    /*! \brief Rebuilds the index of the version being built with a new size.
+    *   \param draft the version being built
+    *   \param base the published version
+    *   \param bits log2 of the new number of slots
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::_rehash(State& draft, const State& base, unsigned bits)
+    {
+        for (size_t page = 0; page < draft.index.size(); ++page)
+            if (page < base.index.size() && draft.index[page] == base.index[page])
+                _retire(draft.index[page], &_delete<IndexPage>);
+            else
+                delete draft.index[page];
+        draft.index.resize((size_t{ 1 } << bits) / page_size);
+        for (auto& page : draft.index)
+            page = new IndexPage;
+        draft.index_bits = bits;
+        for (size_t id = 0; id < draft.count; ++id)
+            _index(draft, base, static_cast<node_id>(id));
+    }
+
+    /*! \brief Copies adjacency lists of the writers to the version being built.
+    *   \param draft the version being built
+    *   \param base the published version
+    *   \param ids the ids of the objects whose lists changed, duplicates allowed
+    *   \param forward copies the lists of requirements if true, the lists of dependents otherwise
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::_sync(State& draft, const State& base, std::vector<node_id>& ids, bool forward)
+    {
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        auto& pages = forward ? draft.requirements : draft.dependents;
+        const auto& published = forward ? base.requirements : base.dependents;
+        for (auto id : ids)
+        {
+            const auto& source = forward ? m_master.requirement_ids(id) : m_master.dependent_ids(id);
+            auto& list = _own(pages, published, id / page_size)->lists[id % page_size];
+            if (list != nullptr)
+                _retire(list, &_delete<List>);
+            list = source.empty() ? nullptr : new List(source);
+        }
+    }
+
+    /*! \brief Publishes a new version in which the given lists are copied from the writers.
+    *   \param forward the ids of the objects whose requirements changed
+    *   \param backward the ids of the objects whose dependents changed
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::_update(std::vector<node_id> forward, std::vector<node_id> backward)
+    {
+        const auto& base = *m_state.load();
+        auto draft = new State(base);
+        ++draft->version;
+        _grow(*draft, base);
+        _sync(*draft, base, forward, true);
+        _sync(*draft, base, backward, false);
+        _publish(draft, false);
+    }
+
+    /*! \brief Publishes a new version built from scratch, after the writers have cleared their relations.
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::_rebuild()
+    {
+        static const State none{};
+        auto draft = new State{};
+        draft->version = m_state.load()->version + 1;
+        _grow(*draft, none);
+        std::vector<node_id> forward(draft->count);
+        std::iota(forward.begin(), forward.end(), node_id{ 0 });
+        auto backward = forward;
+        _sync(*draft, none, forward, true);
+        _sync(*draft, none, backward, false);
+        _publish(draft, true);
+    }
+
+    /*! \brief Replaces the published version and releases the objects no snapshot can see anymore.
+    *   \param draft the new version
+    *   \param replace true if the new version shares nothing with the previous one, which is then released entirely
+    *
+    *   The objects replaced by the new version are tagged with the epoch before the replacement: snapshots taken
+    *   afterwards announce a greater epoch and can only see the new version.
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::_publish(State* draft, bool replace)
+    {
+        draft->size = m_master.size();
+        auto previous = m_state.exchange(draft);
+        auto epoch = m_epoch.fetch_add(1);
+        for (auto& retired : m_retiring)
+        {
+            retired.epoch = epoch;
+            m_retired.push_back(retired);
+        }
+        m_retiring.clear();
+        m_retired.push_back({ epoch, previous, replace ? &_destroy : &_delete<State> });
+        _reclaim();
+    }
+
+    /*! \brief Releases the retired objects older than the oldest snapshot.
+    */
+    template <typename T>
+    void ConcurrentRequirements<T>::_reclaim()
+    {
+        auto oldest = std::numeric_limits<std::uint64_t>::max();
+        for (size_t i = 0; i < m_readers; ++i)
+        {
+            auto epoch = m_slots[i].epoch.load();
+            if (epoch != 0)
+                oldest = std::min(oldest, epoch);
+        }
+        size_t released{ 0 };
+        for (; released < m_retired.size() && m_retired[released].epoch < oldest; ++released)
+            m_retired[released].release(m_retired[released].object);
+        m_retired.erase(m_retired.begin(), m_retired.begin() + static_cast<std::ptrdiff_t>(released));
+    }
+
+}
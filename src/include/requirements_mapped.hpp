@@ -0,0 +1,621 @@
+#pragma once
+
+/*! \file requirements_mapped.hpp
+*	\brief Implements the binary file format of frozen relations and the template class MappedRequirements.
+*   \author Christophe COUAILLET
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "requirements.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Requirements
+{
+
+    /*! \brief Header of a file of frozen relations.
+
+        A file starts with this header, followed by sections aligned on 8 bytes and placed at the given offsets:
+        \li nodes: the objects by node id, as raw values, or as node_count + 1 uint64 offsets in the strings section for std::string,
+        \li strings: the characters of the objects, for std::string only,
+        \li lookup: node_count MappedEntry sorted by hash then id, used to find the id of an object,
+        \li requirement_offsets, dependent_offsets: node_count + 1 uint64 positions of the first id of each list,
+        \li requirement_targets, dependent_targets: relation_count node ids, the lists of all the objects one after the other.
+        Values are stored with the byte order of the machine that wrote the file, and files from other byte orders are rejected.
+    */
+    struct MappedHeader
+    {
+        char magic[8];                                                  //!< "REQUIREM"
+        std::uint32_t version;                                          //!< version of the format
+        std::uint32_t byte_order;                                       //!< 0x01020304 written with the byte order of the file
+        std::uint32_t flags;                                            //!< 1 if reflexivity is allowed
+        std::uint32_t key_kind;                                         //!< 0 for raw values, 1 for strings
+        std::uint64_t key_size;                                         //!< size of a raw value, 0 for strings
+        std::uint64_t node_count;                                       //!< number of objects
+        std::uint64_t relation_count;                                   //!< number of relations
+        std::uint64_t file_size;                                        //!< size of the whole file
+        std::uint64_t nodes;                                            //!< offset of the objects
+        std::uint64_t strings;                                          //!< offset of the characters of the objects, 0 for raw values
+        std::uint64_t lookup;                                           //!< offset of the lookup table
+        std::uint64_t requirement_offsets;                              //!< offset of the positions of the lists of requirements
+        std::uint64_t requirement_targets;                              //!< offset of the lists of requirements
+        std::uint64_t dependent_offsets;                                //!< offset of the positions of the lists of dependents
+        std::uint64_t dependent_targets;                                //!< offset of the lists of dependents
+
+        static constexpr std::uint32_t current_version = 1;             //!< version written by save()
+    };
+
+    /*! \brief Entry of the lookup table of a file of frozen relations.
+    */
+    struct MappedEntry
+    {
+        std::uint64_t hash;                                             //!< FNV-1a hash of the bytes of the object
+        std::uint32_t id;                                               //!< node id of the object
+        std::uint32_t reserved;                                         //!< always 0
+    };
+
+    /*! \brief MappedRequirements gives read-only access to relations saved by save(), directly in the mapped file.
+
+        Opening a file only maps and validates it: no object is copied and no relation is checked, so queries are available
+        at once and the pages of the file are loaded on demand. The mapping is shared, so processes that map the same file
+        share one copy in the page cache.
+        Objects must be std::string or trivially copyable values that compare equal if and only if their bytes are equal,
+        such as integers and enumerations. Objects are returned as std::string_view for std::string, as references otherwise.
+
+        Traversals use scratch buffers owned by the calling thread, so all members can be called concurrently.
+    */
+    template <typename T>
+    class MappedRequirements
+    {
+        static constexpr bool is_string = std::is_same<T, std::string>::value;
+        static_assert(is_string || (std::is_trivially_copyable<T>::value && std::has_unique_object_representations<T>::value),
+            "Mapped objects must be std::string or trivially copyable values without padding.");
+
+    public:
+
+        using node_id = typename Requirements<T>::node_id;                                      //!< dense identifier of an interned object
+        static constexpr node_id npos = Requirements<T>::npos;                                  //!< id returned for unknown objects
+        using reference = std::conditional_t<is_string, std::string_view, const T&>;            //!< type of the objects returned
+
+        explicit MappedRequirements(const std::string& path);                                   // maps a file written by save()
+        MappedRequirements(MappedRequirements&& other) noexcept;
+        MappedRequirements(const MappedRequirements&) = delete;
+        MappedRequirements& operator=(const MappedRequirements&) = delete;
+        MappedRequirements& operator=(MappedRequirements&&) = delete;
+        ~MappedRequirements();
+
+        /*! \brief Informs on the reflexive status of the saved relations.
+        *   \return true if reflexive mode is activated
+        */
+        bool reflexive() const noexcept { return (m_header->flags & 1) != 0; }
+
+        /*! \brief Checks if the file contains dependencies.
+        *   \return true if no dependency exists
+        */
+        bool empty() const noexcept { return m_header->relation_count == 0; }
+
+        /*! \brief Gets the number of dependencies of the file.
+        *   \return the number of dependencies
+        */
+        size_t size() const noexcept { return static_cast<size_t>(m_header->relation_count); }
+
+        /*! \brief Gets the number of interned objects, i.e. the upper bound of node ids.
+        *   \return the number of interned objects
+        */
+        size_t node_count() const noexcept { return static_cast<size_t>(m_header->node_count); }
+
+        reference node(node_id id) const noexcept;                                              // returns the object interned with the given id
+        node_id id_of(const T& object) const noexcept;                                          // returns the id of an interned object or npos
+        bool exists(const T& dependent, const T& requirement, bool recurse = false) const;         // checks direct or indirect dependency
+        bool exists_ids(node_id dependent, node_id requirement, bool recurse = false) const;    // id-based overload of exists()
+        bool has_requirements(const T& dependent) const noexcept;
+        bool has_dependents(const T& requirement) const noexcept;
+        std::vector<T> requirements(const T& dependent) const;                                  // lists direct requirements of dependent
+        std::vector<T> dependents(const T& requirement) const;                                  // lists direct dependents of requirement
+        Span<node_id> requirement_ids(node_id dependent) const noexcept;                        // direct requirements of dependent as ids
+        Span<node_id> dependent_ids(node_id requirement) const noexcept;                        // direct dependents of requirement as ids
+
+    private:
+        const unsigned char* m_data{ nullptr };
+        size_t m_length{ 0 };
+        const MappedHeader* m_header{ nullptr };
+#ifdef _WIN32
+        HANDLE m_file{ INVALID_HANDLE_VALUE };
+        HANDLE m_mapping{ nullptr };
+#endif
+
+        template <typename V>
+        const V* _section(std::uint64_t offset) const noexcept { return reinterpret_cast<const V*>(m_data + offset); }
+        Span<node_id> _list(std::uint64_t offsets, std::uint64_t targets, node_id id) const noexcept;
+        void _map(const std::string& path);
+        void _unmap() noexcept;
+        void _validate() const;
+    };
+
+    template <typename T>
+    std::uint64_t mapped_hash(const T& object) noexcept;                                        // hash of an object stored in the lookup table
+    template <typename T>
+    void save(const FrozenRequirements<T>& requirements, const std::string& path);              // writes frozen relations in a file for MappedRequirements
+
+    // Implementation of classes and functions
+
+    /*! \brief Computes the hash of an object stored in the lookup table of a file (FNV-1a of its bytes or of its characters).
+    *   \param object the object to hash
+    *   \return the hash, identical on all platforms with the same byte order
+    */
+    template <typename T>
+    std::uint64_t mapped_hash(const T& object) noexcept
+    {
+        const unsigned char* bytes{ nullptr };
+        size_t length{ 0 };
+        if constexpr (std::is_same<T, std::string>::value)
+        {
+            bytes = reinterpret_cast<const unsigned char*>(object.data());
+            length = object.size();
+        }
+        else
+        {
+            bytes = reinterpret_cast<const unsigned char*>(&object);
+            length = sizeof(T);
+        }
+        std::uint64_t hash{ 0xcbf29ce484222325ull };
+        for (size_t i = 0; i < length; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    /*! \brief Writes frozen relations in a file that can be mapped by MappedRequirements.
+    *   \param requirements the relations to write
+    *   \param path the path of the file to create or replace
+    *   \exception std::runtime_error if the file can not be written
+    */
+    template <typename T>
+    void save(const FrozenRequirements<T>& requirements, const std::string& path)
+    {
+        constexpr bool is_string = std::is_same<T, std::string>::value;
+        static_assert(is_string || (std::is_trivially_copyable<T>::value && std::has_unique_object_representations<T>::value),
+            "Mapped objects must be std::string or trivially copyable values without padding.");
+        static_assert(alignof(T) <= 8, "Mapped objects must not need an alignment greater than 8.");
+        using node_id = typename FrozenRequirements<T>::node_id;
+        const auto count = requirements.node_count();
+        std::vector<unsigned char> nodes{};
+        std::string strings{};
+        if constexpr (is_string)
+        {
+            std::vector<std::uint64_t> offsets{ 0 };
+            for (node_id id = 0; id < count; ++id)
+            {
+                strings += requirements.node(id);
+                offsets.push_back(strings.size());
+            }
+            nodes.resize(offsets.size() * sizeof(std::uint64_t));
+            std::memcpy(nodes.data(), offsets.data(), nodes.size());
+        }
+        else
+        {
+            nodes.resize(count * sizeof(T));
+            for (node_id id = 0; id < count; ++id)
+                std::memcpy(nodes.data() + id * sizeof(T), &requirements.node(id), sizeof(T));
+        }
+        std::vector<MappedEntry> lookup{};
+        lookup.reserve(count);
+        for (node_id id = 0; id < count; ++id)
+            lookup.push_back({ mapped_hash(requirements.node(id)), id, 0 });
+        std::sort(lookup.begin(), lookup.end(), [](const MappedEntry& a, const MappedEntry& b)
+            {
+                return a.hash < b.hash || (a.hash == b.hash && a.id < b.id);
+            });
+        std::vector<std::uint64_t> requirement_offsets{ 0 };
+        std::vector<std::uint64_t> dependent_offsets{ 0 };
+        std::vector<node_id> requirement_targets{};
+        std::vector<node_id> dependent_targets{};
+        requirement_targets.reserve(requirements.size());
+        dependent_targets.reserve(requirements.size());
+        for (node_id id = 0; id < count; ++id)
+        {
+            auto reqs = requirements.requirement_ids(id);
+            requirement_targets.insert(requirement_targets.end(), reqs.begin(), reqs.end());
+            requirement_offsets.push_back(requirement_targets.size());
+            auto deps = requirements.dependent_ids(id);
+            dependent_targets.insert(dependent_targets.end(), deps.begin(), deps.end());
+            dependent_offsets.push_back(dependent_targets.size());
+        }
+
+        MappedHeader header{};
+        std::memcpy(header.magic, "REQUIREM", sizeof(header.magic));
+        header.version = MappedHeader::current_version;
+        header.byte_order = 0x01020304;
+        header.flags = requirements.reflexive() ? 1 : 0;
+        header.key_kind = is_string ? 1 : 0;
+        header.key_size = is_string ? 0 : sizeof(T);
+        header.node_count = count;
+        header.relation_count = requirements.size();
+        std::uint64_t position{ sizeof(MappedHeader) };
+        auto place = [&position](size_t bytes)
+        {
+            auto offset = position;
+            position += (bytes + 7) / 8 * 8;
+            return offset;
+        };
+        header.nodes = place(nodes.size());
+        header.strings = is_string ? place(strings.size()) : 0;
+        header.lookup = place(lookup.size() * sizeof(MappedEntry));
+        header.requirement_offsets = place(requirement_offsets.size() * sizeof(std::uint64_t));
+        header.requirement_targets = place(requirement_targets.size() * sizeof(node_id));
+        header.dependent_offsets = place(dependent_offsets.size() * sizeof(std::uint64_t));
+        header.dependent_targets = place(dependent_targets.size() * sizeof(node_id));
+        header.file_size = position;
+
+        std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+        std::uint64_t written{ 0 };
+        auto write = [&file, &written](std::uint64_t offset, const void* data, size_t bytes)
+        {
+            static const char padding[8]{};
+            file.write(padding, static_cast<std::streamsize>(offset - written));
+            file.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+            written = offset + bytes;
+        };
+        write(0, &header, sizeof(header));
+        write(header.nodes, nodes.data(), nodes.size());
+        if (is_string)
+            write(header.strings, strings.data(), strings.size());
+        write(header.lookup, lookup.data(), lookup.size() * sizeof(MappedEntry));
+        write(header.requirement_offsets, requirement_offsets.data(), requirement_offsets.size() * sizeof(std::uint64_t));
+        write(header.requirement_targets, requirement_targets.data(), requirement_targets.size() * sizeof(node_id));
+        write(header.dependent_offsets, dependent_offsets.data(), dependent_offsets.size() * sizeof(std::uint64_t));
+        write(header.dependent_targets, dependent_targets.data(), dependent_targets.size() * sizeof(node_id));
+        write(header.file_size, nullptr, 0);
+        file.close();
+        if (!file)
+            throw std::runtime_error("Unable to write " + path + ".");
+    }
+
+    /*! \brief Constructor. Maps a file written by save() in read-only mode.
+    *   \param path the path of the file
+    *   \exception std::runtime_error if the file can not be mapped or is not a valid file for T
+    */
+    template <typename T>
+    MappedRequirements<T>::MappedRequirements(const std::string& path)
+    {
+        _map(path);
+        try
+        {
+            _validate();
+        }
+        catch (...)
+        {
+            _unmap();
+            throw;
+        }
+        m_header = _section<MappedHeader>(0);
+    }
+
+    template <typename T>
+    MappedRequirements<T>::MappedRequirements(MappedRequirements&& other) noexcept
+        : m_data(other.m_data), m_length(other.m_length), m_header(other.m_header)
+#ifdef _WIN32
+        , m_file(other.m_file), m_mapping(other.m_mapping)
+#endif
+    {
+        other.m_data = nullptr;
+#ifdef _WIN32
+        other.m_file = INVALID_HANDLE_VALUE;
+        other.m_mapping = nullptr;
+#endif
+    }
+
+    template <typename T>
+    MappedRequirements<T>::~MappedRequirements()
+    {
+        _unmap();
+    }
+
+    /*! \brief Gets the object interned with the given id.
+    *   \param id a node id lower than node_count()
+    *   \return the interned object, a view on its characters for std::string
+    */
+    template <typename T>
+    typename MappedRequirements<T>::reference MappedRequirements<T>::node(node_id id) const noexcept
+    {
+        if constexpr (is_string)
+        {
+            auto offsets = _section<std::uint64_t>(m_header->nodes);
+            auto chars = _section<char>(m_header->strings);
+            return { chars + offsets[id], static_cast<size_t>(offsets[id + 1] - offsets[id]) };
+        }
+        else
+            return _section<T>(m_header->nodes)[id];
+    }
+
+    /*! \brief Gets the node id of an interned object, by a binary search on the hashes of the lookup table.
+    *   \param object the object to look for
+    *   \return its node id, or npos if the object is unknown
+    */
+    template <typename T>
+    typename MappedRequirements<T>::node_id MappedRequirements<T>::id_of(const T& object) const noexcept
+    {
+        auto hash = mapped_hash(object);
+        auto first = _section<MappedEntry>(m_header->lookup);
+        auto last = first + m_header->node_count;
+        auto itr = std::lower_bound(first, last, hash, [](const MappedEntry& entry, std::uint64_t value) { return entry.hash < value; });
+        for (; itr != last && itr->hash == hash; ++itr)
+            if (node(itr->id) == object)
+                return itr->id;
+        return npos;
+    }
+
+    /*! \brief Checks if a relationship between the given objects exists.
+    *   \param dependent,requirement the 2 objects to check
+    *   \param recurse also checks indirect dependencies when set to true, false by default
+    *   \return true if a relationship exists with the given direction
+    */
+    template <typename T>
+    bool MappedRequirements<T>::exists(const T& dependent, const T& requirement, bool recurse) const
+    {
+        auto dep = id_of(dependent);
+        auto req = id_of(requirement);
+        if (dep == npos || req == npos)
+            return false;
+        return exists_ids(dep, req, recurse);
+    }
+
+    /*! \brief Checks if a relationship between the given node ids exists.
+    *   \param dependent,requirement the ids of the 2 objects to check
+    *   \param recurse also checks indirect dependencies when set to true, false by default
+    *   \return true if a relationship exists with the given direction
+    */
+    template <typename T>
+    bool MappedRequirements<T>::exists_ids(node_id dependent, node_id requirement, bool recurse) const
+    {
+        if (!recurse)
+        {
+            auto reqs = requirement_ids(dependent);
+            return std::find(reqs.begin(), reqs.end(), requirement) != reqs.end();
+        }
+        static thread_local Bitset visited{};
+        static thread_local std::vector<node_id> stack{};
+        static thread_local std::vector<node_id> trail{};
+        if (visited.size() < node_count())
+            visited.resize(node_count());
+        bool result{ false };
+        stack.push_back(dependent);
+        trail.push_back(dependent);
+        visited.set(dependent);
+        while (!result && !stack.empty())
+        {
+            auto id = stack.back();
+            stack.pop_back();
+            for (auto req : requirement_ids(id))
+            {
+                if (req == requirement)
+                {
+                    result = true;
+                    break;
+                }
+                if (!visited.test(req))
+                {
+                    visited.set(req);
+                    trail.push_back(req);
+                    stack.push_back(req);
+                }
+            }
+        }
+        for (auto id : trail)
+            visited.reset(id);
+        trail.clear();
+        stack.clear();
+        return result;
+    }
+
+    /*! \brief Checks if an object has at least one requirement.
+    *   \param dependent the object to check
+    *   \return true if at least one requirement has been found for the given object
+    */
+    template <typename T>
+    bool MappedRequirements<T>::has_requirements(const T& dependent) const noexcept
+    {
+        auto dep = id_of(dependent);
+        return dep != npos && !requirement_ids(dep).empty();
+    }
+
+    /*! \brief Checks if an object has at least one dependent.
+    *   \param requirement the object to check
+    *   \return true if at least one dependent has been found for the given object
+    */
+    template <typename T>
+    bool MappedRequirements<T>::has_dependents(const T& requirement) const noexcept
+    {
+        auto req = id_of(requirement);
+        return req != npos && !dependent_ids(req).empty();
+    }
+
+    /*! \brief Lists the direct requirements of an object.
+    *   \param dependent the object for which direct requirements are searched for
+    *   \return the list of its direct requirements
+    */
+    template <typename T>
+    std::vector<T> MappedRequirements<T>::requirements(const T& dependent) const
+    {
+        std::vector<T> result{};
+        auto dep = id_of(dependent);
+        if (dep == npos)
+            return result;
+        result.reserve(requirement_ids(dep).size());
+        for (auto req : requirement_ids(dep))
+            result.push_back(T(node(req)));
+        return result;
+    }
+
+    /*! \brief Lists the direct dependents of an object.
+    *   \param requirement the object for which direct dependents are searched for
+    *   \return the list of its direct dependents
+    */
+    template <typename T>
+    std::vector<T> MappedRequirements<T>::dependents(const T& requirement) const
+    {
+        std::vector<T> result{};
+        auto req = id_of(requirement);
+        if (req == npos)
+            return result;
+        result.reserve(dependent_ids(req).size());
+        for (auto dep : dependent_ids(req))
+            result.push_back(T(node(dep)));
+        return result;
+    }
+
+    /*! \brief Views the ids of the direct requirements of a node.
+    *   \param dependent the id of the object for which direct requirements are searched for
+    *   \return the ids of its direct requirements, in the mapped file
+    */
+    template <typename T>
+    Span<typename MappedRequirements<T>::node_id> MappedRequirements<T>::requirement_ids(node_id dependent) const noexcept
+    {
+        return _list(m_header->requirement_offsets, m_header->requirement_targets, dependent);
+    }
+
+    /*! \brief Views the ids of the direct dependents of a node.
+    *   \param requirement the id of the object for which direct dependents are searched for
+    *   \return the ids of its direct dependents, in the mapped file
+    */
+    template <typename T>
+    Span<typename MappedRequirements<T>::node_id> MappedRequirements<T>::dependent_ids(node_id requirement) const noexcept
+    {
+        return _list(m_header->dependent_offsets, m_header->dependent_targets, requirement);
+    }
+
+    template <typename T>
+    Span<typename MappedRequirements<T>::node_id> MappedRequirements<T>::_list(std::uint64_t offsets, std::uint64_t targets, node_id id) const noexcept
+    {
+        auto positions = _section<std::uint64_t>(offsets);
+        return { _section<node_id>(targets) + positions[id], static_cast<size_t>(positions[id + 1] - positions[id]) };
+    }
+
+    template <typename T>
+    void MappedRequirements<T>::_map(const std::string& path)
+    {
+#ifdef _WIN32
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        LARGE_INTEGER length{};
+        if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &length))
+        {
+            _unmap();
+            throw std::runtime_error("Unable to open " + path + ".");
+        }
+        m_length = static_cast<size_t>(length.QuadPart);
+        if (m_length != 0)
+            m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping != nullptr)
+            m_data = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        if (m_data == nullptr)
+        {
+            _unmap();
+            throw std::runtime_error("Unable to map " + path + ".");
+        }
+#else
+        auto file = ::open(path.c_str(), O_RDONLY);
+        struct stat status{};
+        if (file < 0 || ::fstat(file, &status) != 0)
+        {
+            if (file >= 0)
+                ::close(file);
+            throw std::runtime_error("Unable to open " + path + ".");
+        }
+        m_length = static_cast<size_t>(status.st_size);
+        void* data = m_length == 0 ? MAP_FAILED : ::mmap(nullptr, m_length, PROT_READ, MAP_SHARED, file, 0);
+        ::close(file);
+        if (data == MAP_FAILED)
+            throw std::runtime_error("Unable to map " + path + ".");
+        m_data = static_cast<const unsigned char*>(data);
+#endif
+    }
+
+    template <typename T>
+    void MappedRequirements<T>::_unmap() noexcept
+    {
+#ifdef _WIN32
+        if (m_data != nullptr)
+            UnmapViewOfFile(m_data);
+        if (m_mapping != nullptr)
+            CloseHandle(m_mapping);
+        if (m_file != INVALID_HANDLE_VALUE)
+            CloseHandle(m_file);
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+#else
+        if (m_data != nullptr)
+            ::munmap(const_cast<unsigned char*>(m_data), m_length);
+#endif
+        m_data = nullptr;
+    }
+
+    /*! \brief Checks that the mapped file has been written by save() for the type of objects, on a machine with the same byte order.
+    *   \exception std::runtime_error if the file is not valid
+    *
+    *   The sections are checked to lie within the file, the content of the lists is trusted.
+    */
+    template <typename T>
+    void MappedRequirements<T>::_validate() const
+    {
+        auto fail = [](const char* reason) { throw std::runtime_error(std::string{ "Invalid requirements file: " } + reason + "."); };
+        if (m_length < sizeof(MappedHeader))
+            fail("truncated header");
+        const auto& header = *_section<MappedHeader>(0);
+        if (std::memcmp(header.magic, "REQUIREM", sizeof(header.magic)) != 0)
+            fail("bad magic number");
+        if (header.version != MappedHeader::current_version)
+            fail("unsupported version");
+        if (header.byte_order != 0x01020304)
+            fail("foreign byte order");
+        if (header.key_kind != (is_string ? 1u : 0u) || header.key_size != (is_string ? 0 : sizeof(T)))
+            fail("objects of another type");
+        if (header.file_size != m_length)
+            fail("bad file size");
+        if (header.node_count >= npos)
+            fail("too many objects");
+        auto fits = [&header](std::uint64_t offset, std::uint64_t count, std::uint64_t size)
+        {
+            return offset % 8 == 0 && offset >= sizeof(MappedHeader) && offset <= header.file_size
+                && count <= (header.file_size - offset) / size;
+        };
+        auto nodes = header.node_count;
+        auto relations = header.relation_count;
+        if (!(is_string ? fits(header.nodes, nodes + 1, sizeof(std::uint64_t)) : fits(header.nodes, nodes, sizeof(T)))
+            || !fits(header.lookup, nodes, sizeof(MappedEntry))
+            || !fits(header.requirement_offsets, nodes + 1, sizeof(std::uint64_t))
+            || !fits(header.requirement_targets, relations, sizeof(node_id))
+            || !fits(header.dependent_offsets, nodes + 1, sizeof(std::uint64_t))
+            || !fits(header.dependent_targets, relations, sizeof(node_id)))
+            fail("section out of bounds");
+        if (_section<std::uint64_t>(header.requirement_offsets)[nodes] != relations
+            || _section<std::uint64_t>(header.dependent_offsets)[nodes] != relations)
+            fail("bad relation count");
+        if (is_string && (header.strings == 0 || !fits(header.strings, _section<std::uint64_t>(header.nodes)[nodes], 1)))
+            fail("section out of bounds");
+    }
+
+}
@@ -0,0 +1,527 @@
+#pragma once
+
+/*! \file requirements_packed.hpp
+*	\brief Implements the template class PackedRequirements.
+*   \author Christophe COUAILLET
+*/
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include "requirements.hpp"
+
+namespace Requirements
+{
+
+    /*! \brief PackedRequirements is an immutable copy of a Requirements object that stores its relations in as few bytes as possible.
+
+        Each object is stored once, and found by an open addressing table of node ids. The lists of node ids are sorted and
+        encoded as variable-length integers, 7 bits per byte: the number of ids, the first id relative to the id of the object
+        and the gaps between the following ones. Lists of neighbours with close ids thus take about 1 byte per relation and direction.
+        The lists of all the objects follow each other in a single array per direction, delimited by 32-bit offsets from the start
+        of pages of 2^page_bits objects.
+        Lists are decoded while they are iterated, so queries cost a few more instructions per relation than with FrozenRequirements.
+        Objects keep the node ids of the Requirements object they were packed from.
+
+        Traversals use scratch buffers owned by the calling thread, so all members can be called concurrently.
+    */
+    template <typename T>
+    class PackedRequirements
+    {
+    public:
+
+        using node_id = typename Requirements<T>::node_id;                                      //!< dense identifier of an interned object
+        static constexpr node_id npos = Requirements<T>::npos;                                  //!< id returned for unknown objects
+        static constexpr unsigned page_bits = 16;                                               //!< log2 of the number of objects per page of offsets
+
+        /*! \brief Ids is a view on an encoded list of node ids, decoded while it is iterated.
+        */
+        class Ids
+        {
+        public:
+
+            /*! \brief Iterator on the node ids of a list, in increasing order.
+            */
+            class const_iterator
+            {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = node_id;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const node_id*;
+                using reference = node_id;
+
+                const_iterator() = default;
+                node_id operator*() const noexcept { return m_value; }
+                const_iterator& operator++() noexcept
+                {
+                    if (--m_left != 0)
+                        m_value += static_cast<node_id>(_decode(m_data)) + 1;
+                    return *this;
+                }
+                const_iterator operator++(int) noexcept { auto result = *this; ++*this; return result; }
+                bool operator==(const const_iterator& other) const noexcept { return m_left == other.m_left; }
+                bool operator!=(const const_iterator& other) const noexcept { return m_left != other.m_left; }
+
+            private:
+                friend class Ids;
+                const_iterator(const std::uint8_t* data, size_t left, node_id base) noexcept : m_data(data), m_left(left)
+                {
+                    if (m_left != 0)
+                        m_value = static_cast<node_id>(base + _unzigzag(_decode(m_data)));
+                }
+                const std::uint8_t* m_data{ nullptr };                  // next gap to decode
+                size_t m_left{ 0 };                                     // ids left, the current one included
+                node_id m_value{ 0 };
+            };
+
+            size_t size() const noexcept { return m_size; }                                         //!< number of ids of the list
+            bool empty() const noexcept { return m_size == 0; }                                     //!< true if the list has no id
+            const_iterator begin() const noexcept { return { m_data, m_size, m_base }; }            //!< iterator on the first id
+            const_iterator end() const noexcept { return {}; }                                      //!< iterator past the last id
+            std::vector<node_id> to_vector() const { return { begin(), end() }; }                   //!< decoded copy of the list
+
+        private:
+            friend class PackedRequirements<T>;
+            Ids(const std::uint8_t* data, size_t size, node_id base) noexcept : m_data(data), m_size(size), m_base(base) {};
+            const std::uint8_t* m_data;                                 // first id, after the number of ids
+            size_t m_size;
+            node_id m_base;                                             // id of the object of the list
+        };
+
+        /*! \brief Default constructor. Creates an empty non reflexive instance.
+        */
+        PackedRequirements() = default;
+
+        template <typename Allocator>
+        explicit PackedRequirements(const Requirements<T, Allocator>& requirements);            // copies the relations of a Requirements object
+
+        /*! \brief Informs on the reflexive status of the instance.
+        *   \return true if reflexive mode is activated
+        */
+        bool reflexive() const noexcept { return m_reflexive; }
+
+        /*! \brief Checks if the instance contains dependencies.
+        *   \return true if no dependency exists
+        */
+        bool empty() const noexcept { return m_size == 0; }
+
+        /*! \brief Gets the number of dependencies of the instance.
+        *   \return the number of dependencies
+        */
+        size_t size() const noexcept { return m_size; }
+
+        /*! \brief Gets the number of interned objects, i.e. the upper bound of node ids.
+        *   \return the number of interned objects
+        */
+        size_t node_count() const noexcept { return m_nodes.size(); }
+
+        /*! \brief Gets the object interned with the given id.
+        *   \param id a node id lower than node_count()
+        *   \return the interned object
+        */
+        const T& node(node_id id) const noexcept { return m_nodes[id]; }
+
+        /*! \brief Lists the ids of the direct requirements of a node.
+        *   \param dependent the id of the object for which direct requirements are searched for
+        *   \return the ids of its direct requirements, in increasing order
+        */
+        Ids requirement_ids(node_id dependent) const noexcept { return _ids(m_requirements, dependent); }
+
+        /*! \brief Lists the ids of the direct dependents of a node.
+        *   \param requirement the id of the object for which direct dependents are searched for
+        *   \return the ids of its direct dependents, in increasing order
+        */
+        Ids dependent_ids(node_id requirement) const noexcept { return _ids(m_dependents, requirement); }
+
+        node_id id_of(const T& object) const noexcept;                                          // returns the id of an interned object or npos
+        bool exists(const T& dependent, const T& requirement, bool recurse = false) const;         // checks direct or indirect dependency
+        bool exists_ids(node_id dependent, node_id requirement, bool recurse = false) const;    // id-based overload of exists()
+        bool has_requirements(const T& dependent) const noexcept;
+        bool has_dependents(const T& requirement) const noexcept;
+        std::vector<T> requirements(const T& dependent) const;                                  // lists direct requirements of dependent
+        std::vector<T> dependents(const T& requirement) const;                                  // lists direct dependents of requirement
+        std::vector<T> transitive_requirements(const T& dependent) const;                        // lists direct and indirect requirements of dependent, once each
+        std::vector<T> transitive_dependents(const T& requirement) const;                       // lists direct and indirect dependents of requirement, once each
+        MemoryUsage memory_usage() const noexcept;                                              // reports the bytes allocated by the instance, by part
+
+    private:
+        // encoded lists of one direction
+        struct Lists
+        {
+            std::vector<std::uint8_t> bytes{};                          // the lists of all the objects, by node id
+            std::vector<std::uint64_t> pages{ 0 };                      // page -> position of the list of its first object
+            std::vector<std::uint32_t> offsets{ 0 };                    // node id -> position of its list from the start of its page, node_count() + 1 values
+
+            size_t start(node_id id) const noexcept { return static_cast<size_t>(pages[id >> page_bits] + offsets[id]); }
+        };
+
+        std::vector<T> m_nodes{};                                       // node id -> object
+        std::vector<node_id> m_index{};                                 // object -> node id, open addressing table with linear probing
+        unsigned m_index_bits{ 0 };                                     // log2 of the number of slots of the index, 0 if no index
+        Lists m_requirements{};
+        Lists m_dependents{};
+        size_t m_size{ 0 };
+        bool m_reflexive{ false };
+
+        // scratch buffers of the traversals of the calling thread, left cleared after use
+        struct Scratch
+        {
+            Bitset visited{};
+            std::vector<node_id> stack{};
+            std::vector<node_id> trail{};
+        };
+
+        static Scratch& _scratch() noexcept;
+        static size_t _hash(const T& object, unsigned bits) noexcept;
+        static void _encode(std::vector<std::uint8_t>& bytes, std::uint64_t value);
+        static std::uint64_t _decode(const std::uint8_t*& data) noexcept;
+        static std::uint64_t _zigzag(std::int64_t value) noexcept { return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63); }
+        static std::int64_t _unzigzag(std::uint64_t value) noexcept { return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1); }
+        static void _append(Lists& lists, node_id id, const std::vector<node_id>& sorted);
+        static Ids _ids(const Lists& lists, node_id id) noexcept;
+        std::vector<T> _objects(const Lists& lists, const T& object) const;
+        std::vector<T> _closure(node_id start, bool forward) const;
+    };
+
+    // Implementation of the class
+
+    /*! \brief Constructor. Copies the relations of a Requirements object.
+    *   \param requirements the relations to copy, with the same node ids
+    */
+    template <typename T>
+    template <typename Allocator>
+    PackedRequirements<T>::PackedRequirements(const Requirements<T, Allocator>& requirements)
+        : m_size(requirements.size()), m_reflexive(requirements.reflexive())
+    {
+        const auto count = static_cast<node_id>(requirements.node_count());
+        m_nodes.reserve(count);
+        m_requirements.offsets.reserve(count + 1);
+        m_dependents.offsets.reserve(count + 1);
+        std::vector<node_id> sorted{};
+        for (node_id id = 0; id < count; ++id)
+        {
+            m_nodes.push_back(requirements.node(id));
+            const auto& reqs = requirements.requirement_ids(id);
+            sorted.assign(reqs.begin(), reqs.end());
+            std::sort(sorted.begin(), sorted.end());
+            _append(m_requirements, id, sorted);
+            const auto& deps = requirements.dependent_ids(id);
+            sorted.assign(deps.begin(), deps.end());
+            std::sort(sorted.begin(), sorted.end());
+            _append(m_dependents, id, sorted);
+        }
+        for (auto* lists : { &m_requirements, &m_dependents })
+        {
+            lists->bytes.shrink_to_fit();
+            lists->pages.shrink_to_fit();
+        }
+        if (count == 0)
+            return;
+        while ((size_t{ 1 } << m_index_bits) < size_t{ 2 } * count)
+            ++m_index_bits;
+        m_index.assign(size_t{ 1 } << m_index_bits, npos);
+        auto mask = m_index.size() - 1;
+        for (node_id id = 0; id < count; ++id)
+        {
+            auto slot = _hash(m_nodes[id], m_index_bits);
+            while (m_index[slot] != npos)
+                slot = (slot + 1) & mask;
+            m_index[slot] = id;
+        }
+    }
+
+    /*! \brief Gets the node id of an interned object.
+    *   \param object the object to look for
+    *   \return its node id, or npos if the object is unknown
+    */
+    template <typename T>
+    typename PackedRequirements<T>::node_id PackedRequirements<T>::id_of(const T& object) const noexcept
+    {
+        if (m_index_bits == 0)
+            return npos;
+        auto mask = m_index.size() - 1;
+        for (auto slot = _hash(object, m_index_bits);; slot = (slot + 1) & mask)
+        {
+            auto id = m_index[slot];
+            if (id == npos || m_nodes[id] == object)
+                return id;
+        }
+    }
+
+    /*! \brief Checks if a relationship between the given objects exists.
+    *   \param dependent,requirement the 2 objects to check
+    *   \param recurse also checks indirect dependencies when set to true, false by default
+    *   \return true if a relationship exists with the given direction
+    */
+    template <typename T>
+    bool PackedRequirements<T>::exists(const T& dependent, const T& requirement, bool recurse) const
+    {
+        auto dep = id_of(dependent);
+        auto req = id_of(requirement);
+        if (dep == npos || req == npos)
+            return false;
+        return exists_ids(dep, req, recurse);
+    }
+
+    /*! \brief Checks if a relationship between the given node ids exists.
+    *   \param dependent,requirement the ids of the 2 objects to check
+    *   \param recurse also checks indirect dependencies when set to true, false by default
+    *   \return true if a relationship exists with the given direction
+    *
+    *   The direct check stops decoding at the first id not lower than the requirement.
+    */
+    template <typename T>
+    bool PackedRequirements<T>::exists_ids(node_id dependent, node_id requirement, bool recurse) const
+    {
+        if (!recurse)
+        {
+            for (auto req : requirement_ids(dependent))
+                if (req >= requirement)
+                    return req == requirement;
+            return false;
+        }
+        auto& scratch = _scratch();
+        if (scratch.visited.size() < m_nodes.size())
+            scratch.visited.resize(m_nodes.size());
+        bool result{ false };
+        scratch.stack.push_back(dependent);
+        scratch.trail.push_back(dependent);
+        scratch.visited.set(dependent);
+        while (!result && !scratch.stack.empty())
+        {
+            auto id = scratch.stack.back();
+            scratch.stack.pop_back();
+            for (auto req : requirement_ids(id))
+            {
+                if (req == requirement)
+                {
+                    result = true;
+                    break;
+                }
+                if (!scratch.visited.test(req))
+                {
+                    scratch.visited.set(req);
+                    scratch.trail.push_back(req);
+                    scratch.stack.push_back(req);
+                }
+            }
+        }
+        for (auto id : scratch.trail)
+            scratch.visited.reset(id);
+        scratch.trail.clear();
+        scratch.stack.clear();
+        return result;
+    }
+
+    /*! \brief Checks if an object has at least one requirement.
+    *   \param dependent the object to check
+    *   \return true if at least one requirement has been found for the given object
+    */
+    template <typename T>
+    bool PackedRequirements<T>::has_requirements(const T& dependent) const noexcept
+    {
+        auto dep = id_of(dependent);
+        return dep != npos && m_requirements.start(dep) != m_requirements.start(dep + 1);
+    }
+
+    /*! \brief Checks if an object has at least one dependent.
+    *   \param requirement the object to check
+    *   \return true if at least one dependent has been found for the given object
+    */
+    template <typename T>
+    bool PackedRequirements<T>::has_dependents(const T& requirement) const noexcept
+    {
+        auto req = id_of(requirement);
+        return req != npos && m_dependents.start(req) != m_dependents.start(req + 1);
+    }
+
+    /*! \brief Lists the direct requirements of an object.
+    *   \param dependent the object for which direct requirements are searched for
+    *   \return the list of its direct requirements, by increasing node id
+    */
+    template <typename T>
+    std::vector<T> PackedRequirements<T>::requirements(const T& dependent) const
+    {
+        return _objects(m_requirements, dependent);
+    }
+
+    /*! \brief Lists the direct dependents of an object.
+    *   \param requirement the object for which direct dependents are searched for
+    *   \return the list of its direct dependents, by increasing node id
+    */
+    template <typename T>
+    std::vector<T> PackedRequirements<T>::dependents(const T& requirement) const
+    {
+        return _objects(m_dependents, requirement);
+    }
+
+    /*! \brief Lists the objects on which the object depends, directly or indirectly, each object once.
+    *   \param dependent the object for which direct or indirect requirements are searched for
+    *   \return the list of its direct and indirect requirements, in no particular order
+    */
+    template <typename T>
+    std::vector<T> PackedRequirements<T>::transitive_requirements(const T& dependent) const
+    {
+        auto dep = id_of(dependent);
+        return dep == npos ? std::vector<T>{} : _closure(dep, true);
+    }
+
+    /*! \brief Lists the objects that depend on the object, directly or indirectly, each object once.
+    *   \param requirement the object for which direct or indirect dependents are searched for
+    *   \return the list of its direct and indirect dependents, in no particular order
+    */
+    template <typename T>
+    std::vector<T> PackedRequirements<T>::transitive_dependents(const T& requirement) const
+    {
+        auto req = id_of(requirement);
+        return req == npos ? std::vector<T>{} : _closure(req, false);
+    }
+
+    /*! \brief Reports the bytes allocated by the instance, by part.
+    *   \return the bytes of the objects and their table and of the lists, the scratch buffers of the threads not being counted
+    *   \sa MemoryUsage
+    */
+    template <typename T>
+    MemoryUsage PackedRequirements<T>::memory_usage() const noexcept
+    {
+        MemoryUsage result{};
+        result.index = m_nodes.capacity() * sizeof(T) + m_index.capacity() * sizeof(node_id);
+        for (const auto* lists : { &m_requirements, &m_dependents })
+            result.adjacency += lists->bytes.capacity() + lists->pages.capacity() * sizeof(std::uint64_t) + lists->offsets.capacity() * sizeof(std::uint32_t);
+        return result;
+    }
+
+    template <typename T>
+    typename PackedRequirements<T>::Scratch& PackedRequirements<T>::_scratch() noexcept
+    {
+        static thread_local Scratch scratch{};
+        return scratch;
+    }
+
+    template <typename T>
+    size_t PackedRequirements<T>::_hash(const T& object, unsigned bits) noexcept
+    {
+        std::uint64_t hash = std::hash<T>{}(object);
+        return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+    }
+
+    /*! \brief Appends a value to an array of bytes, 7 bits per byte from the lowest ones, the highest bit telling if more bytes follow.
+    *   \param bytes the array that receives the value
+    *   \param value the value to encode
+    */
+    template <typename T>
+    void PackedRequirements<T>::_encode(std::vector<std::uint8_t>& bytes, std::uint64_t value)
+    {
+        for (; value >= 0x80; value >>= 7)
+            bytes.push_back(static_cast<std::uint8_t>(value | 0x80));
+        bytes.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    /*! \brief Decodes a value written by _encode().
+    *   \param data the position of the value, moved past it
+    *   \return the value
+    */
+    template <typename T>
+    std::uint64_t PackedRequirements<T>::_decode(const std::uint8_t*& data) noexcept
+    {
+        std::uint64_t value{ *data & 0x7Fu };
+        for (unsigned shift = 7; (*data++ & 0x80) != 0; shift += 7)
+            value |= static_cast<std::uint64_t>(*data & 0x7F) << shift;
+        return value;
+    }
+
+    /*! \brief Encodes the list of the next object.
+    *   \param lists the lists of the direction, that receive the list
+    *   \param id the id of the object, equal to the number of lists already encoded
+    *   \param sorted the ids of the list, in increasing order
+    *
+    *   An empty list takes no byte. The offset of the following object is recorded, starting a new page when needed.
+    */
+    template <typename T>
+    void PackedRequirements<T>::_append(Lists& lists, node_id id, const std::vector<node_id>& sorted)
+    {
+        if (!sorted.empty())
+        {
+            _encode(lists.bytes, sorted.size());
+            _encode(lists.bytes, _zigzag(static_cast<std::int64_t>(sorted.front()) - static_cast<std::int64_t>(id)));
+            for (size_t i = 1; i < sorted.size(); ++i)
+                _encode(lists.bytes, sorted[i] - sorted[i - 1] - 1);
+        }
+        auto next = static_cast<size_t>(id) + 1;
+        if ((next & ((size_t{ 1 } << page_bits) - 1)) == 0)
+            lists.pages.push_back(lists.bytes.size());
+        auto offset = lists.bytes.size() - lists.pages[next >> page_bits];
+        assert(offset <= std::numeric_limits<std::uint32_t>::max() && "Lists of a page exceed 4 GiB.");
+        lists.offsets.push_back(static_cast<std::uint32_t>(offset));
+    }
+
+    template <typename T>
+    typename PackedRequirements<T>::Ids PackedRequirements<T>::_ids(const Lists& lists, node_id id) noexcept
+    {
+        auto start = lists.start(id);
+        if (start == lists.start(id + 1))
+            return { nullptr, 0, id };
+        const std::uint8_t* data = lists.bytes.data() + start;
+        auto size = static_cast<size_t>(_decode(data));
+        return { data, size, id };
+    }
+
+    template <typename T>
+    std::vector<T> PackedRequirements<T>::_objects(const Lists& lists, const T& object) const
+    {
+        std::vector<T> result{};
+        auto id = id_of(object);
+        if (id == npos)
+            return result;
+        auto ids = _ids(lists, id);
+        result.reserve(ids.size());
+        for (auto next : ids)
+            result.push_back(m_nodes[next]);
+        return result;
+    }
+
+    /*! \brief Lists the objects reachable from a node through at least one relation (breadth-first walk).
+    *   \param start the id of the object to start from
+    *   \param forward walks requirements if true, dependents otherwise
+    *   \return the objects reached, the object itself first if it belongs to a cycle
+    */
+    template <typename T>
+    std::vector<T> PackedRequirements<T>::_closure(node_id start, bool forward) const
+    {
+        auto& scratch = _scratch();
+        if (scratch.visited.size() < m_nodes.size())
+            scratch.visited.resize(m_nodes.size());
+        bool cycle{ false };
+        scratch.trail.push_back(start);
+        scratch.visited.set(start);
+        for (size_t head = 0; head < scratch.trail.size(); ++head)
+            for (auto id : forward ? requirement_ids(scratch.trail[head]) : dependent_ids(scratch.trail[head]))
+            {
+                if (id == start)
+                    cycle = true;
+                if (!scratch.visited.test(id))
+                {
+                    scratch.visited.set(id);
+                    scratch.trail.push_back(id);
+                }
+            }
+        std::vector<T> result{};
+        result.reserve(scratch.trail.size() - (cycle ? 0 : 1));
+        if (cycle)
+            result.push_back(m_nodes[start]);
+        for (size_t i = 1; i < scratch.trail.size(); ++i)
+            result.push_back(m_nodes[scratch.trail[i]]);
+        for (auto id : scratch.trail)
+            scratch.visited.reset(id);
+        scratch.trail.clear();
+        return result;
+    }
+
+}
@@ -0,0 +1,553 @@
+#pragma once
+
+/*! \file requirements_parallel.hpp
+*	\brief Implements a work-stealing thread pool and the parallel processing of Requirements objects.
+*   \author Christophe COUAILLET
+*
+*   Programs including this header must link with the threads library of the platform.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "requirements.hpp"
+
+namespace Requirements
+{
+
+    /*! \brief ThreadPool is a fixed set of worker threads that run submitted tasks.
+
+        Each worker owns a queue of tasks. A task submitted by a worker is pushed to its own queue and
+        workers that run out of tasks steal the oldest tasks of the other queues.
+    */
+    class ThreadPool
+    {
+    public:
+
+        /*! \brief Constructor. Starts the worker threads.
+        *   \param threads the number of worker threads, the number of hardware threads if 0
+        */
+        explicit ThreadPool(size_t threads = 0);
+
+        /*! \brief Destructor. Waits for the running tasks and stops the worker threads.
+        *
+        *   Tasks that have not been started yet are dropped.
+        */
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /*! \brief Gets the number of worker threads.
+        *   \return the number of worker threads
+        */
+        size_t size() const noexcept { return m_threads.size(); }
+
+        void submit(std::function<void()> task);                                                // schedules a task
+        void wait();                                                                            // waits until all submitted tasks are done
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex{};
+            std::deque<std::function<void()>> tasks{};
+        };
+
+        std::vector<std::unique_ptr<Queue>> m_queues{};
+        std::vector<std::thread> m_threads{};
+        std::mutex m_mutex{};
+        std::condition_variable m_wake{};
+        std::condition_variable m_done{};
+        std::atomic<size_t> m_queued{ 0 };                              // tasks waiting in the queues
+        std::atomic<size_t> m_pending{ 0 };                             // tasks submitted and not finished
+        std::atomic<size_t> m_next{ 0 };                                // queue of the next task submitted from outside the pool
+        bool m_stop{ false };
+
+        static size_t& _worker() noexcept;
+        static ThreadPool*& _owner() noexcept;
+        bool _pop(size_t index, std::function<void()>& task);
+        void _run(size_t index);
+    };
+
+    template <typename T, typename Allocator, typename F>
+    void execute(const Requirements<T, Allocator>& requirements, F&& f, ThreadPool& pool);      // runs f on each object once all its requirements are done
+    template <typename T, typename Allocator, typename F>
+    void execute(const Requirements<T, Allocator>& requirements, F&& f, size_t threads = 0);    // same as above with a temporary pool
+    template <typename T, typename Allocator, typename InputIt, typename BitsetAllocator>
+    void exists_many(const Requirements<T, Allocator>& requirements, InputIt first, InputIt last,
+        BasicBitset<BitsetAllocator>& results, bool recurse, ThreadPool& pool);                 // checks a range of pairs (dependent, requirement) on the threads of the pool
+    template <typename T, typename Allocator, typename InputIt, typename BitsetAllocator>
+    void exists_many(const Requirements<T, Allocator>& requirements, InputIt first, InputIt last,
+        BasicBitset<BitsetAllocator>& results, bool recurse = false, size_t threads = 0);       // same as above with a temporary pool
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type all_requirements(const Requirements<T, Allocator>& requirements,
+        bool without_duplicates, ThreadPool& pool);                                             // returns all chains of requirements, walked on the threads of the pool
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type all_requirements(const Requirements<T, Allocator>& requirements,
+        bool without_duplicates = true, size_t threads = 0);                                    // same as above with a temporary pool
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type all_dependencies(const Requirements<T, Allocator>& requirements,
+        bool without_duplicates, ThreadPool& pool);                                             // returns all chains of dependencies, walked on the threads of the pool
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type all_dependencies(const Requirements<T, Allocator>& requirements,
+        bool without_duplicates = true, size_t threads = 0);                                    // same as above with a temporary pool
+
+    // Implementation of classes and functions
+
+    inline ThreadPool::ThreadPool(size_t threads)
+    {
+        if (threads == 0)
+            threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < threads; ++i)
+            m_queues.push_back(std::make_unique<Queue>());
+        for (size_t i = 0; i < threads; ++i)
+            m_threads.emplace_back([this, i] { _run(i); });
+    }
+
+    inline ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& thread : m_threads)
+            thread.join();
+    }
+
+    /*! \brief Schedules a task.
+    *   \param task the task to run
+    *
+    *   Can be called from any thread, including from a task of the pool.
+    */
+    inline void ThreadPool::submit(std::function<void()> task)
+    {
+        auto index = _owner() == this ? _worker() : m_next++ % m_queues.size();
+        ++m_pending;
+        {
+            std::lock_guard<std::mutex> lock{ m_queues[index]->mutex };
+            m_queues[index]->tasks.push_back(std::move(task));
+            ++m_queued;
+        }
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+        }
+        m_wake.notify_one();
+    }
+
+    /*! \brief Waits until all submitted tasks are done, including the tasks they submit.
+    *   \warning Must not be called from a task of the pool.
+    */
+    inline void ThreadPool::wait()
+    {
+        std::unique_lock<std::mutex> lock{ m_mutex };
+        m_done.wait(lock, [this] { return m_pending == 0; });
+    }
+
+    inline size_t& ThreadPool::_worker() noexcept
+    {
+        static thread_local size_t index{ 0 };
+        return index;
+    }
+
+    inline ThreadPool*& ThreadPool::_owner() noexcept
+    {
+        static thread_local ThreadPool* owner{ nullptr };
+        return owner;
+    }
+
+    /*! \brief Takes the next task, from the back of the own queue of the worker or from the front of another queue.
+    *   \param index the index of the worker
+    *   \param task receives the task
+    *   \return true if a task has been found
+    */
+    inline bool ThreadPool::_pop(size_t index, std::function<void()>& task)
+    {
+        for (size_t i = 0; i < m_queues.size(); ++i)
+        {
+            auto& queue = *m_queues[(index + i) % m_queues.size()];
+            std::lock_guard<std::mutex> lock{ queue.mutex };
+            if (queue.tasks.empty())
+                continue;
+            if (i == 0)
+            {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+            else
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            --m_queued;
+            return true;
+        }
+        return false;
+    }
+
+    inline void ThreadPool::_run(size_t index)
+    {
+        _worker() = index;
+        _owner() = this;
+        std::function<void()> task{};
+        for (;;)
+        {
+            if (_pop(index, task))
+            {
+                task();
+                task = nullptr;
+                if (--m_pending == 0)
+                {
+                    std::lock_guard<std::mutex> lock{ m_mutex };
+                    m_done.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_wake.wait(lock, [this] { return m_stop || m_queued != 0; });
+            if (m_stop)
+                return;
+        }
+    }
+
+    /*! \brief Runs a function on each object involved in relations, once all its requirements are done.
+    *   \param requirements the relations that order the calls
+    *   \param f the function called with each object
+    *   \param pool the threads that run the calls
+    *   \warning An assertion occurs if relations form a cycle, the objects of the cycle and their dependents are not processed.
+    *
+    *   Each object holds an atomic counter of its requirements not yet done. When f returns for an object, the counters
+    *   of its dependents are decremented and the ones that reach zero are submitted at once, without waiting for the
+    *   other objects of the same topological level.
+    *   If f throws, no further object is started and the first exception is rethrown once the running calls are done.
+    *   The relations must not be modified during the call.
+    */
+    template <typename T, typename Allocator, typename F>
+    void execute(const Requirements<T, Allocator>& requirements, F&& f, ThreadPool& pool)
+    {
+        using node_id = typename Requirements<T, Allocator>::node_id;
+        const auto nodes = requirements.node_count();
+        std::unique_ptr<std::atomic<size_t>[]> pending{ new std::atomic<size_t>[nodes] };
+        std::vector<node_id> roots{};
+        size_t involved{ 0 };
+        for (node_id id = 0; id < nodes; ++id)
+        {
+            auto count = requirements.requirement_ids(id).size();
+            pending[id].store(count, std::memory_order_relaxed);
+            if (count == 0 && !requirements.dependent_ids(id).empty())
+                roots.push_back(id);
+            if (count != 0 || !requirements.dependent_ids(id).empty())
+                ++involved;
+        }
+        std::atomic<size_t> done{ 0 };
+        std::atomic<bool> failed{ false };
+        std::exception_ptr error{};
+        std::mutex error_mutex{};
+        std::function<void(node_id)> process = [&](node_id id)
+        {
+            if (failed)
+                return;
+            try
+            {
+                f(requirements.node(id));
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock{ error_mutex };
+                if (!failed.exchange(true))
+                    error = std::current_exception();
+                return;
+            }
+            ++done;
+            for (auto dep : requirements.dependent_ids(id))
+                if (pending[dep].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    pool.submit([&process, dep] { process(dep); });
+        };
+        for (auto id : roots)
+            pool.submit([&process, id] { process(id); });
+        pool.wait();
+        if (error)
+            std::rethrow_exception(error);
+        assert(done == involved && "Relations form a cycle.");
+        (void)involved;
+    }
+
+    /*! \brief Runs a function on each object involved in relations, once all its requirements are done.
+    *   \param requirements the relations that order the calls
+    *   \param f the function called with each object
+    *   \param threads the number of threads that run the calls, the number of hardware threads if 0
+    *   \sa execute(const Requirements<T, Allocator>&, F&&, ThreadPool&)
+    */
+    template <typename T, typename Allocator, typename F>
+    void execute(const Requirements<T, Allocator>& requirements, F&& f, size_t threads)
+    {
+        ThreadPool pool{ threads };
+        execute(requirements, std::forward<F>(f), pool);
+    }
+
+    /*! \brief Checks a range of pairs (dependent, requirement) at once, spreading the queries over the threads of a pool.
+    *   \param requirements the relations to check
+    *   \param first,last the range of pairs to check
+    *   \param results receives at the position of each pair in the range true if the relation exists, grown if needed
+    *   \param recurse also checks indirect dependencies when set to true
+    *   \param pool the threads that answer the queries
+    *   \sa Requirements< T >::exists_many()
+    *
+    *   Queries are grouped by dependent as in Requirements::exists_many() and the groups are split in batches of about the
+    *   same number of queries. Each task walks the relations with scratch buffers of its own, so the reachability cache is not used.
+    *   The relations must not be modified during the call.
+    */
+    template <typename T, typename Allocator, typename InputIt, typename BitsetAllocator>
+    void exists_many(const Requirements<T, Allocator>& requirements, InputIt first, InputIt last,
+        BasicBitset<BitsetAllocator>& results, bool recurse, ThreadPool& pool)
+    {
+        using node_id = typename Requirements<T, Allocator>::node_id;
+        struct Query
+        {
+            node_id dependent;
+            node_id requirement;
+            size_t index;
+        };
+        const auto npos = Requirements<T, Allocator>::npos;
+        std::vector<Query> queries{};
+        size_t count{ 0 };
+        for (; first != last; ++first, ++count)
+        {
+            results.reset(count);
+            auto dep = requirements.id_of((*first).first);
+            auto req = requirements.id_of((*first).second);
+            if (dep != npos && req != npos)
+                queries.push_back({ dep, req, count });
+        }
+        std::sort(queries.begin(), queries.end(), [](const Query& a, const Query& b) { return a.dependent < b.dependent; });
+        std::unique_ptr<bool[]> answers{ new bool[count]() };
+        const auto nodes = requirements.node_count();
+        auto process = [&](size_t begin, size_t end)
+        {
+            Bitset visited{ nodes };
+            Bitset targets{ nodes };
+            std::vector<node_id> stack{};
+            std::vector<node_id> trail{};
+            for (auto group = begin; group < end;)
+            {
+                auto dependent = queries[group].dependent;
+                auto last = group;
+                size_t remaining{ 0 };
+                for (; last < end && queries[last].dependent == dependent; ++last)
+                    if (!targets.test(queries[last].requirement))
+                    {
+                        targets.set(queries[last].requirement);
+                        ++remaining;
+                    }
+                bool cycle{ false };
+                visited.set(dependent);
+                trail.push_back(dependent);
+                stack.push_back(dependent);
+                while (remaining != 0 && !stack.empty())
+                {
+                    auto id = stack.back();
+                    stack.pop_back();
+                    for (auto req : requirements.requirement_ids(id))
+                    {
+                        if (req == dependent && !cycle)
+                        {
+                            cycle = true;
+                            if (targets.test(req))
+                                --remaining;
+                        }
+                        if (!visited.test(req))
+                        {
+                            visited.set(req);
+                            trail.push_back(req);
+                            if (recurse)
+                                stack.push_back(req);
+                            if (targets.test(req))
+                                --remaining;
+                        }
+                    }
+                }
+                for (; group < last; ++group)
+                {
+                    const auto& query = queries[group];
+                    answers[query.index] = query.requirement == dependent ? cycle : visited.test(query.requirement);
+                    targets.reset(query.requirement);
+                }
+                for (auto id : trail)
+                    visited.reset(id);
+                trail.clear();
+                stack.clear();
+            }
+        };
+        size_t batch = std::max<size_t>(64, queries.size() / (pool.size() * 4) + 1);
+        for (size_t begin = 0; begin < queries.size();)
+        {
+            auto end = std::min(begin + batch, queries.size());
+            while (end < queries.size() && queries[end].dependent == queries[end - 1].dependent)
+                ++end;
+            pool.submit([&process, begin, end] { process(begin, end); });
+            begin = end;
+        }
+        pool.wait();
+        for (size_t i = 0; i < count; ++i)
+            if (answers[i])
+                results.set(i);
+    }
+
+    /*! \brief Checks a range of pairs (dependent, requirement) at once, spreading the queries over several threads.
+    *   \param requirements the relations to check
+    *   \param first,last the range of pairs to check
+    *   \param results receives at the position of each pair in the range true if the relation exists, grown if needed
+    *   \param recurse also checks indirect dependencies when set to true, false by default
+    *   \param threads the number of threads that answer the queries, the number of hardware threads if 0
+    *   \sa exists_many(const Requirements<T, Allocator>&, InputIt, InputIt, BasicBitset<BitsetAllocator>&, bool, ThreadPool&)
+    */
+    template <typename T, typename Allocator, typename InputIt, typename BitsetAllocator>
+    void exists_many(const Requirements<T, Allocator>& requirements, InputIt first, InputIt last,
+        BasicBitset<BitsetAllocator>& results, bool recurse, size_t threads)
+    {
+        ThreadPool pool{ threads };
+        exists_many(requirements, first, last, results, recurse, pool);
+    }
+
+    /*! \brief Lists the branches that start with the roots of the walk, splitting the roots between the threads of a pool.
+    *   \param requirements the relations to walk
+    *   \param forward walks requirements if true, dependents otherwise
+    *   \param without_duplicates if true only objects that have no neighbour in the other direction are roots
+    *   \param pool the threads that walk the branches
+    *   \return the branches, in the order of the sequential walk
+    *
+    *   The roots are split in consecutive ranges of node ids holding about the same number of roots, several ranges per thread
+    *   so that idle threads take the ranges with the longest walks. Each range is walked by its own Chains, so it has its own
+    *   path buffers, and writes to its own list of branches. The lists are concatenated in the order of the ranges.
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type _chains(const Requirements<T, Allocator>& requirements,
+        bool forward, bool without_duplicates, ThreadPool& pool)
+    {
+        using node_id = typename Requirements<T, Allocator>::node_id;
+        using chains_type = typename Requirements<T, Allocator>::chains_type;
+        const auto nodes = static_cast<node_id>(requirements.node_count());
+        auto is_root = [&](node_id id)
+        {
+            const auto& next = forward ? requirements.requirement_ids(id) : requirements.dependent_ids(id);
+            const auto& previous = forward ? requirements.dependent_ids(id) : requirements.requirement_ids(id);
+            return !next.empty() && (!without_duplicates || previous.empty());
+        };
+        size_t roots{ 0 };
+        for (node_id id = 0; id < nodes; ++id)
+            roots += is_root(id);
+        const size_t batch = std::max<size_t>(1, roots / (pool.size() * 8));
+        std::vector<node_id> bounds{};                                  // first node id of each range
+        size_t seen{ 0 };
+        for (node_id id = 0; id < nodes; ++id)
+            if (is_root(id) && seen++ % batch == 0)
+                bounds.push_back(id);
+        bounds.push_back(nodes);
+        std::vector<chains_type> parts(bounds.size() - 1, chains_type{ requirements.get_allocator() });
+        std::exception_ptr error{};
+        std::mutex error_mutex{};
+        for (size_t part = 0; part + 1 < bounds.size(); ++part)
+            pool.submit([&, part]
+            {
+                try
+                {
+                    auto chains = forward ? requirements.requirement_chains(without_duplicates, bounds[part], bounds[part + 1])
+                        : requirements.dependency_chains(without_duplicates, bounds[part], bounds[part + 1]);
+                    for (const auto& chain : chains)
+                        parts[part].push_back(chain.to_vector());
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock{ error_mutex };
+                    if (!error)
+                        error = std::current_exception();
+                }
+            });
+        pool.wait();
+        if (error)
+            std::rethrow_exception(error);
+        size_t count{ 0 };
+        for (const auto& part : parts)
+            count += part.size();
+        chains_type result{ requirements.get_allocator() };
+        result.reserve(count);
+        for (auto& part : parts)
+            std::move(part.begin(), part.end(), std::back_inserter(result));
+        return result;
+    }
+
+    /*! \brief Lists all branches of dependencies, from dependents to requirements, walking them on the threads of a pool.
+    *   \param requirements the relations to walk
+    *   \param without_duplicates if true only objects that have no dependents are considered as first element of a branch
+    *   \param pool the threads that walk the branches
+    *   \return the list of all branches, from dependents to requirements, in the order of Requirements::all_requirements()
+    *   \sa Requirements< T >::all_requirements(bool)
+    *
+    *   The relations must not be modified during the call.
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type all_requirements(const Requirements<T, Allocator>& requirements,
+        bool without_duplicates, ThreadPool& pool)
+    {
+        return _chains(requirements, true, without_duplicates, pool);
+    }
+
+    /*! \brief Lists all branches of dependencies, from dependents to requirements, walking them on several threads.
+    *   \param requirements the relations to walk
+    *   \param without_duplicates if true only objects that have no dependents are considered as first element of a branch
+    *   \param threads the number of threads that walk the branches, the number of hardware threads if 0
+    *   \return the list of all branches, from dependents to requirements
+    *   \sa all_requirements(const Requirements<T, Allocator>&, bool, ThreadPool&)
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type all_requirements(const Requirements<T, Allocator>& requirements,
+        bool without_duplicates, size_t threads)
+    {
+        ThreadPool pool{ threads };
+        return all_requirements(requirements, without_duplicates, pool);
+    }
+
+    /*! \brief Lists all branches of dependencies, from requirements to dependents, walking them on the threads of a pool.
+    *   \param requirements the relations to walk
+    *   \param without_duplicates if true only objects that not depends on another object are considered as first element of a branch
+    *   \param pool the threads that walk the branches
+    *   \return the list of all branches, from requirements to dependents, in the order of Requirements::all_dependencies()
+    *   \sa Requirements< T >::all_dependencies(bool)
+    *
+    *   The relations must not be modified during the call.
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type all_dependencies(const Requirements<T, Allocator>& requirements,
+        bool without_duplicates, ThreadPool& pool)
+    {
+        return _chains(requirements, false, without_duplicates, pool);
+    }
+
+    /*! \brief Lists all branches of dependencies, from requirements to dependents, walking them on several threads.
+    *   \param requirements the relations to walk
+    *   \param without_duplicates if true only objects that not depends on another object are considered as first element of a branch
+    *   \param threads the number of threads that walk the branches, the number of hardware threads if 0
+    *   \return the list of all branches, from requirements to dependents
+    *   \sa all_dependencies(const Requirements<T, Allocator>&, bool, ThreadPool&)
+    */
+    template <typename T, typename Allocator>
+    typename Requirements<T, Allocator>::chains_type all_dependencies(const Requirements<T, Allocator>& requirements,
+        bool without_duplicates, size_t threads)
+    {
+        ThreadPool pool{ threads };
+        return all_dependencies(requirements, without_duplicates, pool);
+    }
+
+}
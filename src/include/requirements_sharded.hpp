@@ -0,0 +1,433 @@
+#pragma once
+
+/*! \file requirements_sharded.hpp
+*	\brief Implements the template classes ShardedRequirements and LocalTransport.
+*   \author Christophe COUAILLET
+*/
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "requirements.hpp"
+
+namespace Requirements
+{
+
+    /*! \brief LocalTransport holds the shards of a ShardedRequirements object in the local process, one Requirements object each.
+
+        It is the reference implementation of the transport of ShardedRequirements. A transport gives access to the shards
+        with the following members, which a remote transport implements by sending the arguments to the process of the shard:
+        \li size_t size() const: the number of shards,
+        \li void update(size_t shard, const std::vector<Change<T>>& changes): applies in order the additions and removals of relations,
+        \li void expand(size_t shard, const std::vector<T>& objects, bool forward, std::vector<T>& neighbours) const: appends to neighbours
+        the direct requirements, or the direct dependents if forward is false, of each object of the shard given, ignoring unknown objects,
+        \li void clear(size_t shard): removes all the relations of the shard.
+        Calls are never made concurrently by a ShardedRequirements object.
+    */
+    template <typename T>
+    class LocalTransport
+    {
+    public:
+
+        /*! \brief Constructor.
+        *   \param shards the number of shards, at least 1
+        */
+        explicit LocalTransport(size_t shards) : m_shards(shards, Requirements<T>{ true })
+        {
+            assert(shards != 0 && "A transport requires at least one shard.");
+        }
+
+        /*! \brief Gets the number of shards.
+        *   \return the number of shards
+        */
+        size_t size() const noexcept { return m_shards.size(); }
+
+        /*! \brief Gets the relations held by a shard.
+        *   \param shard the index of the shard
+        *   \return the relations whose dependent or requirement belongs to the shard
+        */
+        const Requirements<T>& shard(size_t shard) const noexcept { return m_shards[shard]; }
+
+        /*! \brief Gets the number of calls received by the shards, i.e. the number of messages a remote transport would send.
+        *   \return the number of calls of update(), expand() and clear()
+        */
+        size_t calls() const noexcept { return m_calls; }
+
+        void update(size_t shard, const std::vector<Change<T>>& changes);
+        void expand(size_t shard, const std::vector<T>& objects, bool forward, std::vector<T>& neighbours) const;
+        void clear(size_t shard);
+
+    private:
+        std::vector<Requirements<T>> m_shards;                          // reflexive, the rules are checked on the whole graph by the caller
+        mutable size_t m_calls{ 0 };
+    };
+
+    /*! \brief ShardedRequirements handles relations spread over several shards, with the rules and the queries of Requirements.
+
+        Each object belongs to the shard given by its hash. A shard holds the relations whose dependent or requirement belongs to it,
+        so the direct requirements and the direct dependents of an object are answered by its own shard, and a relation between
+        objects of 2 shards is stored in both. The shards are reached through a Transport, local or remote (see LocalTransport).
+
+        Recursive queries walk the relations breadth-first: each round groups the objects of the frontier by shard and sends
+        one expand() call to each shard involved, so the number of messages depends on the depth of the walk and the number of
+        shards, not on the number of objects. The objects already seen are kept by the caller.
+        Updates are grouped the same way, with one update() call per shard involved.
+        The relations must not be modified by other means than this object, and its members must not be called concurrently.
+    */
+    template <typename T, typename Transport = LocalTransport<T>, typename Hash = std::hash<T>>
+    class ShardedRequirements
+    {
+    public:
+
+        /*! \brief Constructor.
+        *   \param reflexive sets the reflexive mode
+        *   \param args the arguments of the constructor of the transport
+        */
+        template <typename... Args>
+        explicit ShardedRequirements(bool reflexive, Args&&... args) : m_reflexive(reflexive), m_transport(std::forward<Args>(args)...) {};
+
+        /*! \brief Informs on the reflexive status of the instance.
+        *   \return true if reflexive mode is activated
+        */
+        bool reflexive() const noexcept { return m_reflexive; }
+
+        /*! \brief Checks if the instance contains dependencies.
+        *   \return true if no dependency exists
+        */
+        bool empty() const noexcept { return m_size == 0; }
+
+        /*! \brief Gets the number of dependencies of the instance.
+        *   \return the number of dependencies
+        */
+        size_t size() const noexcept { return m_size; }
+
+        /*! \brief Gets the version of the relations, incremented by each relation added or removed.
+        *   \return the version number, also carried by the changes sent to the shards
+        */
+        size_t version() const noexcept { return m_version; }
+
+        /*! \brief Gets the transport that reaches the shards.
+        *   \return the transport
+        */
+        const Transport& transport() const noexcept { return m_transport; }
+
+        /*! \brief Gets the shard of an object.
+        *   \param object the object to place
+        *   \return the index of the shard that holds its relations
+        */
+        size_t shard_of(const T& object) const noexcept
+        {
+            return static_cast<size_t>((static_cast<std::uint64_t>(m_hash(object)) * 0x9E3779B97F4A7C15ull) >> 32) % m_transport.size();
+        }
+
+        void clear();
+        void add(const T& dependent, const T& requirement);
+        void remove(const T& dependent, const T& requirement);
+        void remove_dependent(const T& dependent);
+        void remove_requirement(const T& requirement);
+        void remove_all(const T& object);
+        bool exists(const T& dependent, const T& requirement, bool recurse = false) const;   // checks direct or indirect dependency
+        std::vector<T> requirements(const T& dependent) const;                                  // lists direct requirements of dependent
+        std::vector<T> dependents(const T& requirement) const;                                  // lists direct dependents of requirement
+        std::vector<T> transitive_requirements(const T& dependent) const;                       // lists direct and indirect requirements of dependent, once each
+        std::vector<T> transitive_dependents(const T& requirement) const;                       // lists direct and indirect dependents of requirement, once each
+
+    private:
+        const bool m_reflexive;
+        Transport m_transport;
+        Hash m_hash{};
+        size_t m_size{ 0 };
+        size_t m_version{ 0 };
+
+        std::vector<T> _neighbours(const T& object, bool forward) const;
+        bool _walk(const T& start, bool forward, const T* target, std::vector<T>* found) const;
+        void _apply(std::vector<Change<T>>& changes);
+    };
+
+    // Implementation of the classes
+
+    /*! \brief Applies in order the additions and removals of relations to a shard.
+    *   \param shard the index of the shard
+    *   \param changes the modifications of the relations of the shard
+    */
+    template <typename T>
+    void LocalTransport<T>::update(size_t shard, const std::vector<Change<T>>& changes)
+    {
+        ++m_calls;
+        for (const auto& change : changes)
+            if (change.kind == ChangeKind::Added)
+                m_shards[shard].add(change.dependent, change.requirement);
+            else
+                m_shards[shard].remove(change.dependent, change.requirement);
+    }
+
+    /*! \brief Gets the direct neighbours of objects of a shard.
+    *   \param shard the index of the shard
+    *   \param objects the objects of the shard whose neighbours are searched for
+    *   \param forward lists the requirements of the objects if true, their dependents otherwise
+    *   \param neighbours receives the neighbours of each object, one object after the other
+    */
+    template <typename T>
+    void LocalTransport<T>::expand(size_t shard, const std::vector<T>& objects, bool forward, std::vector<T>& neighbours) const
+    {
+        ++m_calls;
+        const auto& relations = m_shards[shard];
+        for (const auto& object : objects)
+        {
+            auto id = relations.id_of(object);
+            if (id == Requirements<T>::npos)
+                continue;
+            for (auto next : forward ? relations.requirement_ids(id) : relations.dependent_ids(id))
+                neighbours.push_back(relations.node(next));
+        }
+    }
+
+    /*! \brief Removes all the relations of a shard.
+    *   \param shard the index of the shard
+    */
+    template <typename T>
+    void LocalTransport<T>::clear(size_t shard)
+    {
+        ++m_calls;
+        m_shards[shard].clear();
+    }
+
+    /*! \brief Removes all the relations of all the shards.
+    */
+    template <typename T, typename Transport, typename Hash>
+    void ShardedRequirements<T, Transport, Hash>::clear()
+    {
+        for (size_t shard = 0; shard < m_transport.size(); ++shard)
+            m_transport.clear(shard);
+        m_version += m_size;
+        m_size = 0;
+    }
+
+    /*! \brief Add a relation where dependent depends on requirement.
+    *   \param dependent the object that depends on the other object
+    *   \param requirement the object on which the first object depends
+    *   \warning An assertion occurs if the relation breaks a rule of Requirements::add().
+    *
+    *   The rules are checked with recursive queries on all the shards before the relation is sent to the shards of both objects.
+    */
+    template <typename T, typename Transport, typename Hash>
+    void ShardedRequirements<T, Transport, Hash>::add(const T& dependent, const T& requirement)
+    {
+        assert(dependent != requirement && "A requirement can't be requested for object itself.");
+        if (dependent == requirement)
+            return;
+        bool implicit{ exists(dependent, requirement, true) };
+        assert(!implicit && "(Implicit) requirement is already defined.");
+        if (implicit)
+            return;
+        bool opposite{ !m_reflexive && exists(requirement, dependent, true) };
+        assert(!opposite && "Opposite requirement cannot be set while reflexivity is not allowed.");
+        if (opposite)
+            return;
+        std::vector<Change<T>> changes{ { 0, ChangeKind::Added, dependent, requirement } };
+        _apply(changes);
+    }
+
+    /*! \brief Removes an existing relation where dependent depends on requirement.
+    *   \param dependent,requirement the 2 objects involved in the dependency to remove
+    *   \warning An assertion occurs if the relation does not exist.
+    */
+    template <typename T, typename Transport, typename Hash>
+    void ShardedRequirements<T, Transport, Hash>::remove(const T& dependent, const T& requirement)
+    {
+        bool found{ exists(dependent, requirement) };
+        assert(found && "Requirement does not exist.");
+        if (!found)
+            return;
+        std::vector<Change<T>> changes{ { 0, ChangeKind::Removed, dependent, requirement } };
+        _apply(changes);
+    }
+
+    /*! \brief Removes all relations involving the object as a dependent.
+    *   \param dependent the object that is declared as a dependent in the relations to remove
+    */
+    template <typename T, typename Transport, typename Hash>
+    void ShardedRequirements<T, Transport, Hash>::remove_dependent(const T& dependent)
+    {
+        std::vector<Change<T>> changes{};
+        for (const auto& req : requirements(dependent))
+            changes.push_back({ 0, ChangeKind::Removed, dependent, req });
+        _apply(changes);
+    }
+
+    /*! \brief Removes all relations involving the object as a requirement.
+    *   \param requirement the object that is declared as a requirement in the relations to remove
+    */
+    template <typename T, typename Transport, typename Hash>
+    void ShardedRequirements<T, Transport, Hash>::remove_requirement(const T& requirement)
+    {
+        std::vector<Change<T>> changes{};
+        for (const auto& dep : dependents(requirement))
+            changes.push_back({ 0, ChangeKind::Removed, dep, requirement });
+        _apply(changes);
+    }
+
+    /*! \brief Removes all existing relations involving the object as a dependent or a requirement.
+    *   \param object the object involved as a dependent or a requirement in the relations to remove
+    */
+    template <typename T, typename Transport, typename Hash>
+    void ShardedRequirements<T, Transport, Hash>::remove_all(const T& object)
+    {
+        std::vector<Change<T>> changes{};
+        for (const auto& req : requirements(object))
+            changes.push_back({ 0, ChangeKind::Removed, object, req });
+        for (const auto& dep : dependents(object))
+            changes.push_back({ 0, ChangeKind::Removed, dep, object });
+        _apply(changes);
+    }
+
+    /*! \brief Checks if a relationship between the given objects exists.
+    *   \param dependent,requirement the 2 objects to check
+    *   \param recurse also checks indirect dependencies when set to true, false by default
+    *   \return true if a relationship exists with the given direction
+    *
+    *   The recursive check stops at the end of the round of exchanges that reaches the requirement.
+    */
+    template <typename T, typename Transport, typename Hash>
+    bool ShardedRequirements<T, Transport, Hash>::exists(const T& dependent, const T& requirement, bool recurse) const
+    {
+        if (recurse)
+            return _walk(dependent, true, &requirement, nullptr);
+        for (const auto& req : requirements(dependent))
+            if (req == requirement)
+                return true;
+        return false;
+    }
+
+    /*! \brief Lists the direct requirements of an object.
+    *   \param dependent the object for which direct requirements are searched for
+    *   \return the list of its direct requirements, empty if the object is unknown
+    */
+    template <typename T, typename Transport, typename Hash>
+    std::vector<T> ShardedRequirements<T, Transport, Hash>::requirements(const T& dependent) const
+    {
+        return _neighbours(dependent, true);
+    }
+
+    /*! \brief Lists the direct dependents of an object.
+    *   \param requirement the object for which direct dependents are searched for
+    *   \return the list of its direct dependents, empty if the object is unknown
+    */
+    template <typename T, typename Transport, typename Hash>
+    std::vector<T> ShardedRequirements<T, Transport, Hash>::dependents(const T& requirement) const
+    {
+        return _neighbours(requirement, false);
+    }
+
+    /*! \brief Lists the objects on which the object depends, directly or indirectly, each object once.
+    *   \param dependent the object for which direct or indirect requirements are searched for
+    *   \return the list of its direct and indirect requirements, by increasing distance, itself first if it belongs to a cycle
+    */
+    template <typename T, typename Transport, typename Hash>
+    std::vector<T> ShardedRequirements<T, Transport, Hash>::transitive_requirements(const T& dependent) const
+    {
+        std::vector<T> result{};
+        _walk(dependent, true, nullptr, &result);
+        return result;
+    }
+
+    /*! \brief Lists the objects that depend on the object, directly or indirectly, each object once.
+    *   \param requirement the object for which direct or indirect dependents are searched for
+    *   \return the list of its direct and indirect dependents, by increasing distance, itself first if it belongs to a cycle
+    */
+    template <typename T, typename Transport, typename Hash>
+    std::vector<T> ShardedRequirements<T, Transport, Hash>::transitive_dependents(const T& requirement) const
+    {
+        std::vector<T> result{};
+        _walk(requirement, false, nullptr, &result);
+        return result;
+    }
+
+    template <typename T, typename Transport, typename Hash>
+    std::vector<T> ShardedRequirements<T, Transport, Hash>::_neighbours(const T& object, bool forward) const
+    {
+        std::vector<T> result{};
+        m_transport.expand(shard_of(object), { object }, forward, result);
+        return result;
+    }
+
+    /*! \brief Walks the relations breadth-first from an object, one round of exchanges with the shards per level.
+    *   \param start the object to walk from
+    *   \param forward walks requirements if true, dependents otherwise
+    *   \param target the object whose discovery stops the walk, or nullptr to walk the whole closure
+    *   \param found receives the objects reached, once each, if not nullptr
+    *   \return true if the target has been reached
+    *
+    *   The start object is listed first if it belongs to a cycle, as in Requirements::transitive_requirements().
+    */
+    template <typename T, typename Transport, typename Hash>
+    bool ShardedRequirements<T, Transport, Hash>::_walk(const T& start, bool forward, const T* target, std::vector<T>* found) const
+    {
+        const auto shards = m_transport.size();
+        std::unordered_set<T, Hash> visited{ { start }, 0, m_hash };
+        std::vector<std::vector<T>> frontier(shards);                  // objects to expand, by shard
+        std::vector<T> neighbours{};
+        bool cycle{ false };
+        frontier[shard_of(start)].push_back(start);
+        for (bool more = true; more;)
+        {
+            more = false;
+            neighbours.clear();
+            for (size_t shard = 0; shard < shards; ++shard)
+                if (!frontier[shard].empty())
+                {
+                    m_transport.expand(shard, frontier[shard], forward, neighbours);
+                    frontier[shard].clear();
+                }
+            for (const auto& next : neighbours)
+            {
+                if (target != nullptr && next == *target)
+                    return true;
+                if (next == start)
+                    cycle = true;
+                if (!visited.insert(next).second)
+                    continue;
+                if (found != nullptr)
+                    found->push_back(next);
+                frontier[shard_of(next)].push_back(next);
+                more = true;
+            }
+        }
+        if (cycle && found != nullptr)
+            found->insert(found->begin(), start);
+        return false;
+    }
+
+    /*! \brief Sends modifications to the shards of the objects involved, with one call per shard.
+    *   \param changes the modifications, whose version is assigned
+    */
+    template <typename T, typename Transport, typename Hash>
+    void ShardedRequirements<T, Transport, Hash>::_apply(std::vector<Change<T>>& changes)
+    {
+        if (changes.empty())
+            return;
+        std::vector<std::vector<Change<T>>> batches(m_transport.size());
+        for (auto& change : changes)
+        {
+            change.version = ++m_version;
+            auto dep = shard_of(change.dependent);
+            auto req = shard_of(change.requirement);
+            batches[dep].push_back(change);
+            if (req != dep)
+                batches[req].push_back(change);
+            if (change.kind == ChangeKind::Added)
+                ++m_size;
+            else
+                --m_size;
+        }
+        for (size_t shard = 0; shard < batches.size(); ++shard)
+            if (!batches[shard].empty())
+                m_transport.update(shard, batches[shard]);
+    }
+
+}
@@ -0,0 +1,280 @@
+#pragma once
+
+/*! \file requirements_simd.hpp
+*	\brief Implements the vectorized word loops of the bitsets used by Requirements.
+*   \author Christophe COUAILLET
+*
+*   The implementation is chosen once, at the first call, from the instruction sets of the running processor:
+*   AVX-512 or AVX2 on x86 with GCC or Clang, NEON on AArch64, portable loops otherwise.
+*   Define REQUIREMENTS_NO_SIMD to always use the portable loops.
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(REQUIREMENTS_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define REQUIREMENTS_SIMD_X86
+#include <immintrin.h>
+#elif !defined(REQUIREMENTS_NO_SIMD) && defined(__aarch64__)
+#define REQUIREMENTS_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Requirements
+{
+
+    /*! \brief BitsetKernels holds the loops that combine arrays of 64-bit words.
+
+        Short arrays are processed inline, longer ones by the implementation selected for the running processor.
+        Implementations are only selected at run time, so binaries built for a baseline instruction set still use AVX2 or AVX-512.
+    */
+    class BitsetKernels
+    {
+    public:
+
+        using word_type = std::uint64_t;                                                        //!< storage unit of the bits
+
+        /*! \brief Sets in target the bits set in source.
+        *   \param target,source the arrays to combine, target receives the result
+        *   \param count the number of words of both arrays
+        */
+        static void or_words(word_type* target, const word_type* source, size_t count) noexcept
+        {
+            if (count < inline_words)
+                _or_portable(target, source, count);
+            else
+                _table().or_words(target, source, count);
+        }
+
+        /*! \brief Clears in target the bits not set in source.
+        *   \param target,source the arrays to combine, target receives the result
+        *   \param count the number of words of both arrays
+        */
+        static void and_words(word_type* target, const word_type* source, size_t count) noexcept
+        {
+            if (count < inline_words)
+                _and_portable(target, source, count);
+            else
+                _table().and_words(target, source, count);
+        }
+
+        /*! \brief Checks if 2 arrays have at least one bit set in common.
+        *   \param first,second the arrays to check
+        *   \param count the number of words of both arrays
+        *   \return true if a bit is set in both arrays
+        */
+        static bool intersects(const word_type* first, const word_type* second, size_t count) noexcept
+        {
+            return count < inline_words ? _intersects_portable(first, second, count) : _table().intersects(first, second, count);
+        }
+
+        /*! \brief Counts the bits set in an array.
+        *   \param words the array to count
+        *   \param count the number of words of the array
+        *   \return the number of bits set
+        */
+        static size_t popcount(const word_type* words, size_t count) noexcept
+        {
+            return count < inline_words ? _popcount_portable(words, count) : _table().popcount(words, count);
+        }
+
+        /*! \brief Gets the position of the lowest bit set in a word.
+        *   \param word a word with at least one bit set
+        *   \return the position of its lowest bit set
+        */
+        static size_t lowest(word_type word) noexcept
+        {
+#ifdef __GNUC__
+            return static_cast<size_t>(__builtin_ctzll(word));
+#else
+            size_t bit{ 0 };
+            while ((word >> bit & 1) == 0)
+                ++bit;
+            return bit;
+#endif
+        }
+
+        /*! \brief Gets the name of the implementation selected for the running processor.
+        *   \return "avx512", "avx2", "neon" or "portable"
+        */
+        static const char* name() noexcept { return _table().name; }
+
+    private:
+        static constexpr size_t inline_words = 8;                       // arrays shorter than this are not worth an indirect call
+
+        struct Table
+        {
+            void (*or_words)(word_type*, const word_type*, size_t) noexcept;
+            void (*and_words)(word_type*, const word_type*, size_t) noexcept;
+            bool (*intersects)(const word_type*, const word_type*, size_t) noexcept;
+            size_t (*popcount)(const word_type*, size_t) noexcept;
+            const char* name;
+        };
+
+        static const Table& _table() noexcept
+        {
+            static const Table table{ _select() };
+            return table;
+        }
+
+        static Table _select() noexcept
+        {
+#if defined(REQUIREMENTS_SIMD_X86)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+                return { _or_avx512, _and_avx512, _intersects_avx512, _popcount_popcnt, "avx512" };
+            if (__builtin_cpu_supports("avx2"))
+                return { _or_avx2, _and_avx2, _intersects_avx2, __builtin_cpu_supports("popcnt") ? _popcount_popcnt : _popcount_portable, "avx2" };
+#elif defined(REQUIREMENTS_SIMD_NEON)
+            return { _or_neon, _and_neon, _intersects_neon, _popcount_neon, "neon" };
+#endif
+            return { _or_portable, _and_portable, _intersects_portable, _popcount_portable, "portable" };
+        }
+
+        static void _or_portable(word_type* target, const word_type* source, size_t count) noexcept
+        {
+            for (size_t i = 0; i < count; ++i)
+                target[i] |= source[i];
+        }
+
+        static void _and_portable(word_type* target, const word_type* source, size_t count) noexcept
+        {
+            for (size_t i = 0; i < count; ++i)
+                target[i] &= source[i];
+        }
+
+        static bool _intersects_portable(const word_type* first, const word_type* second, size_t count) noexcept
+        {
+            for (size_t i = 0; i < count; ++i)
+                if ((first[i] & second[i]) != 0)
+                    return true;
+            return false;
+        }
+
+        static size_t _popcount_portable(const word_type* words, size_t count) noexcept
+        {
+            size_t result{ 0 };
+            for (size_t i = 0; i < count; ++i)
+            {
+#ifdef __GNUC__
+                result += static_cast<size_t>(__builtin_popcountll(words[i]));
+#else
+                for (auto word = words[i]; word != 0; word &= word - 1)
+                    ++result;
+#endif
+            }
+            return result;
+        }
+
+#if defined(REQUIREMENTS_SIMD_X86)
+        __attribute__((target("avx2")))
+        static void _or_avx2(word_type* target, const word_type* source, size_t count) noexcept
+        {
+            size_t i{ 0 };
+            for (; i + 4 <= count; i += 4)
+            {
+                auto value = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(target + i)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(target + i), value);
+            }
+            _or_portable(target + i, source + i, count - i);
+        }
+
+        __attribute__((target("avx2")))
+        static void _and_avx2(word_type* target, const word_type* source, size_t count) noexcept
+        {
+            size_t i{ 0 };
+            for (; i + 4 <= count; i += 4)
+            {
+                auto value = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(target + i)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(target + i), value);
+            }
+            _and_portable(target + i, source + i, count - i);
+        }
+
+        __attribute__((target("avx2")))
+        static bool _intersects_avx2(const word_type* first, const word_type* second, size_t count) noexcept
+        {
+            size_t i{ 0 };
+            for (; i + 4 <= count; i += 4)
+                if (!_mm256_testz_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + i)),
+                    _mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + i))))
+                    return true;
+            return _intersects_portable(first + i, second + i, count - i);
+        }
+
+        __attribute__((target("avx512f")))
+        static void _or_avx512(word_type* target, const word_type* source, size_t count) noexcept
+        {
+            size_t i{ 0 };
+            for (; i + 8 <= count; i += 8)
+                _mm512_storeu_si512(target + i, _mm512_or_si512(_mm512_loadu_si512(target + i), _mm512_loadu_si512(source + i)));
+            _or_portable(target + i, source + i, count - i);
+        }
+
+        __attribute__((target("avx512f")))
+        static void _and_avx512(word_type* target, const word_type* source, size_t count) noexcept
+        {
+            size_t i{ 0 };
+            for (; i + 8 <= count; i += 8)
+                _mm512_storeu_si512(target + i, _mm512_and_si512(_mm512_loadu_si512(target + i), _mm512_loadu_si512(source + i)));
+            _and_portable(target + i, source + i, count - i);
+        }
+
+        __attribute__((target("avx512f")))
+        static bool _intersects_avx512(const word_type* first, const word_type* second, size_t count) noexcept
+        {
+            size_t i{ 0 };
+            for (; i + 8 <= count; i += 8)
+                if (_mm512_test_epi64_mask(_mm512_loadu_si512(first + i), _mm512_loadu_si512(second + i)) != 0)
+                    return true;
+            return _intersects_portable(first + i, second + i, count - i);
+        }
+
+        __attribute__((target("popcnt")))
+        static size_t _popcount_popcnt(const word_type* words, size_t count) noexcept
+        {
+            size_t result{ 0 };
+            for (size_t i = 0; i < count; ++i)
+                result += static_cast<size_t>(__builtin_popcountll(words[i]));
+            return result;
+        }
+#elif defined(REQUIREMENTS_SIMD_NEON)
+        static void _or_neon(word_type* target, const word_type* source, size_t count) noexcept
+        {
+            size_t i{ 0 };
+            for (; i + 2 <= count; i += 2)
+                vst1q_u64(target + i, vorrq_u64(vld1q_u64(target + i), vld1q_u64(source + i)));
+            _or_portable(target + i, source + i, count - i);
+        }
+
+        static void _and_neon(word_type* target, const word_type* source, size_t count) noexcept
+        {
+            size_t i{ 0 };
+            for (; i + 2 <= count; i += 2)
+                vst1q_u64(target + i, vandq_u64(vld1q_u64(target + i), vld1q_u64(source + i)));
+            _and_portable(target + i, source + i, count - i);
+        }
+
+        static bool _intersects_neon(const word_type* first, const word_type* second, size_t count) noexcept
+        {
+            size_t i{ 0 };
+            for (; i + 2 <= count; i += 2)
+                if (vmaxvq_u32(vreinterpretq_u32_u64(vandq_u64(vld1q_u64(first + i), vld1q_u64(second + i)))) != 0)
+                    return true;
+            return _intersects_portable(first + i, second + i, count - i);
+        }
+
+        static size_t _popcount_neon(const word_type* words, size_t count) noexcept
+        {
+            size_t result{ 0 };
+            size_t i{ 0 };
+            for (; i + 2 <= count; i += 2)
+                result += vaddvq_u8(vcntq_u8(vreinterpretq_u8_u64(vld1q_u64(words + i))));
+            return result + _popcount_portable(words + i, count - i);
+        }
+#endif
+    };
+
+}
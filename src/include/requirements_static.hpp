@@ -0,0 +1,314 @@
+#pragma once
+
+/*! \file requirements_static.hpp
+*	\brief Implements the template class StaticRequirements.
+*   \author Christophe COUAILLET
+*/
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace Requirements
+{
+
+    /*! \brief StaticRequirements handles the relations of the N values of a small enumeration or integral type, with the rules of Requirements.
+
+        Each value is its own node id, given by static_cast<size_t>, so no object is hashed nor allocated.
+        Relations are kept in 2 fixed-size bit matrices, the requirements and the dependents of each value, and the reachability
+        closure in a third one, updated by add(): recursive checks and closures are a bit test or a copy of a row.
+        All the members that do not return a std::vector are constexpr, so a whole instance can be built at compile time.
+        Removals rebuild the closure in O(N^2 * N / 64) word operations.
+    */
+    template <typename T, size_t N>
+    class StaticRequirements
+    {
+        static_assert(std::is_enum<T>::value || std::is_integral<T>::value, "StaticRequirements requires an enumeration or an integral type.");
+        static_assert(N > 0, "StaticRequirements requires at least one value.");
+
+    public:
+
+        static constexpr size_t word_bits = 64;                                                 //!< number of bits per word
+        static constexpr size_t words = (N + word_bits - 1) / word_bits;                        //!< number of words per set
+
+        /*! \brief Set is a fixed-size set of values of T.
+        */
+        class Set
+        {
+        public:
+
+            /*! \brief Checks if a value belongs to the set.
+            *   \param object the value to check
+            *   \return true if the value belongs to the set
+            */
+            constexpr bool test(T object) const noexcept
+            {
+                auto pos = _index(object);
+                return (m_words[pos / word_bits] >> (pos % word_bits) & 1) != 0;
+            }
+
+            /*! \brief Checks if the set is empty.
+            *   \return true if no value belongs to the set
+            */
+            constexpr bool empty() const noexcept
+            {
+                for (size_t i = 0; i < words; ++i)
+                    if (m_words[i] != 0)
+                        return false;
+                return true;
+            }
+
+            /*! \brief Counts the values of the set.
+            *   \return the number of values of the set
+            */
+            constexpr size_t count() const noexcept
+            {
+                size_t result{ 0 };
+                for (size_t i = 0; i < words; ++i)
+                    for (auto word = m_words[i]; word != 0; word &= word - 1)
+                        ++result;
+                return result;
+            }
+
+            /*! \brief Lists the values of the set.
+            *   \return the values of the set, in increasing order
+            */
+            std::vector<T> to_vector() const
+            {
+                std::vector<T> result{};
+                for (size_t pos = 0; pos < N; ++pos)
+                    if ((m_words[pos / word_bits] >> (pos % word_bits) & 1) != 0)
+                        result.push_back(static_cast<T>(pos));
+                return result;
+            }
+
+            constexpr const std::array<std::uint64_t, words>& data() const noexcept { return m_words; }     //!< words of the set
+
+        private:
+            friend class StaticRequirements;
+            std::array<std::uint64_t, words> m_words{};
+
+            constexpr void _set(size_t pos) noexcept { m_words[pos / word_bits] |= std::uint64_t{ 1 } << (pos % word_bits); }
+            constexpr void _reset(size_t pos) noexcept { m_words[pos / word_bits] &= ~(std::uint64_t{ 1 } << (pos % word_bits)); }
+            constexpr bool _test(size_t pos) const noexcept { return (m_words[pos / word_bits] >> (pos % word_bits) & 1) != 0; }
+            constexpr void _merge(const Set& other) noexcept
+            {
+                for (size_t i = 0; i < words; ++i)
+                    m_words[i] |= other.m_words[i];
+            }
+        };
+
+        /*! \brief Default constructor. Reflexivity is not allowed.
+        */
+        constexpr StaticRequirements() noexcept = default;
+
+        /*! \brief Constructor. Set the reflexive status to true to allow mutual dependencies.
+        *   \param reflexive sets the reflexive mode
+        */
+        constexpr explicit StaticRequirements(bool reflexive) noexcept : m_reflexive(reflexive) {};
+
+        /*! \brief Informs on the reflexive status of the instance.
+        *   \return true if reflexive mode is activated
+        */
+        constexpr bool reflexive() const noexcept { return m_reflexive; }
+
+        /*! \brief Checks if the instance contains dependencies.
+        *   \return true if no dependency exists
+        */
+        constexpr bool empty() const noexcept { return m_size == 0; }
+
+        /*! \brief Gets the number of dependencies of the instance.
+        *   \return the number of dependencies
+        */
+        constexpr size_t size() const noexcept { return m_size; }
+
+        constexpr void clear() noexcept;
+        constexpr void add(T dependent, T requirement) noexcept;
+        constexpr void remove(T dependent, T requirement) noexcept;
+        constexpr void remove_dependent(T dependent) noexcept;
+        constexpr void remove_requirement(T requirement) noexcept;
+        constexpr void remove_all(T object) noexcept;
+        constexpr bool exists(T dependent, T requirement, bool recurse = false) const noexcept;   // check direct or indirect dependency
+
+        /*! \brief Checks if an object has at least one requirement.
+        *   \param dependent the object to check
+        *   \return true if at least one requirement has been found for the given object
+        */
+        constexpr bool has_requirements(T dependent) const noexcept { return !m_requirements[_index(dependent)].empty(); }
+
+        /*! \brief Checks if an object has at least one dependent.
+        *   \param requirement the object to check
+        *   \return true if at least one dependent has been found for the given object
+        */
+        constexpr bool has_dependents(T requirement) const noexcept { return !m_dependents[_index(requirement)].empty(); }
+
+        /*! \brief Gets the direct requirements of an object.
+        *   \param dependent the object for which direct requirements are searched for
+        *   \return the set of its direct requirements
+        */
+        constexpr const Set& requirement_set(T dependent) const noexcept { return m_requirements[_index(dependent)]; }
+
+        /*! \brief Gets the direct dependents of an object.
+        *   \param requirement the object for which direct dependents are searched for
+        *   \return the set of its direct dependents
+        */
+        constexpr const Set& dependent_set(T requirement) const noexcept { return m_dependents[_index(requirement)]; }
+
+        /*! \brief Gets the direct and indirect requirements of an object.
+        *   \param dependent the object for which requirements are searched for
+        *   \return the set of the objects it depends on, including itself if it belongs to a cycle
+        */
+        constexpr const Set& closure(T dependent) const noexcept { return m_reach[_index(dependent)]; }
+
+        std::vector<T> requirements(T dependent) const { return requirement_set(dependent).to_vector(); }      //!< lists direct requirements of dependent
+        std::vector<T> dependents(T requirement) const { return dependent_set(requirement).to_vector(); }      //!< lists direct dependents of requirement
+        std::vector<T> transitive_requirements(T dependent) const { return closure(dependent).to_vector(); }   //!< lists direct and indirect requirements of dependent
+
+    private:
+        std::array<Set, N> m_requirements{};                            // value -> its direct requirements
+        std::array<Set, N> m_dependents{};                              // value -> its direct dependents
+        std::array<Set, N> m_reach{};                                   // value -> the values it depends on directly or indirectly
+        size_t m_size{ 0 };
+        bool m_reflexive{ false };
+
+        static constexpr size_t _index(T object) noexcept
+        {
+            auto pos = static_cast<size_t>(object);
+            assert(pos < N && "Object out of the bounds of the instance.");
+            return pos;
+        }
+
+        constexpr void _build_reachability() noexcept;
+    };
+
+    // Implementation of the class
+
+    /*! \brief Removes all the relations.
+    */
+    template <typename T, size_t N>
+    constexpr void StaticRequirements<T, N>::clear() noexcept
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            m_requirements[i] = {};
+            m_dependents[i] = {};
+            m_reach[i] = {};
+        }
+        m_size = 0;
+    }
+
+    /*! \brief Add a relation where dependent depends on requirement.
+    *   \param dependent the object that depends on the other object
+    *   \param requirement the object on which the first object depends
+    *   \warning An assertion occurs if the relation breaks a rule of Requirements::add().
+    *
+    *   The closure is updated with a union of rows for each object that reaches dependent.
+    */
+    template <typename T, size_t N>
+    constexpr void StaticRequirements<T, N>::add(T dependent, T requirement) noexcept
+    {
+        auto dep = _index(dependent);
+        auto req = _index(requirement);
+        assert(dep != req && "A requirement can't be requested for object itself.");
+        assert(!m_reach[dep]._test(req) && "(Implicit) requirement is already defined.");
+        assert((m_reflexive || !m_reach[req]._test(dep)) && "Opposite requirement cannot be set while reflexivity is not allowed.");
+        m_requirements[dep]._set(req);
+        m_dependents[req]._set(dep);
+        ++m_size;
+        Set gained{ m_reach[req] };
+        gained._set(req);
+        for (size_t id = 0; id < N; ++id)
+            if (id == dep || m_reach[id]._test(dep))
+                m_reach[id]._merge(gained);
+    }
+
+    /*! \brief Removes an existing relation where dependent depends on requirement.
+    *   \param dependent,requirement the 2 objects involved in the dependency to remove
+    *   \warning An assertion occurs if the relation does not exist.
+    */
+    template <typename T, size_t N>
+    constexpr void StaticRequirements<T, N>::remove(T dependent, T requirement) noexcept
+    {
+        auto dep = _index(dependent);
+        auto req = _index(requirement);
+        assert(m_requirements[dep]._test(req) && "Requirement does not exist.");
+        if (!m_requirements[dep]._test(req))
+            return;
+        m_requirements[dep]._reset(req);
+        m_dependents[req]._reset(dep);
+        --m_size;
+        _build_reachability();
+    }
+
+    /*! \brief Removes all relations involving the object as a dependent.
+    *   \param dependent the object that is declared as a dependent in the relations to remove
+    */
+    template <typename T, size_t N>
+    constexpr void StaticRequirements<T, N>::remove_dependent(T dependent) noexcept
+    {
+        auto dep = _index(dependent);
+        for (size_t req = 0; req < N; ++req)
+            if (m_requirements[dep]._test(req))
+            {
+                m_dependents[req]._reset(dep);
+                --m_size;
+            }
+        m_requirements[dep] = {};
+        _build_reachability();
+    }
+
+    /*! \brief Removes all relations involving the object as a requirement.
+    *   \param requirement the object that is declared as a requirement in the relations to remove
+    */
+    template <typename T, size_t N>
+    constexpr void StaticRequirements<T, N>::remove_requirement(T requirement) noexcept
+    {
+        auto req = _index(requirement);
+        for (size_t dep = 0; dep < N; ++dep)
+            if (m_dependents[req]._test(dep))
+            {
+                m_requirements[dep]._reset(req);
+                --m_size;
+            }
+        m_dependents[req] = {};
+        _build_reachability();
+    }
+
+    /*! \brief Removes all existing relations involving the object as a dependent or a requirement.
+    *   \param object the object involved as a dependent or a requirement in the relations to remove
+    */
+    template <typename T, size_t N>
+    constexpr void StaticRequirements<T, N>::remove_all(T object) noexcept
+    {
+        remove_dependent(object);
+        remove_requirement(object);
+    }
+
+    /*! \brief Checks if a relationship between the given objects exists.
+    *   \param dependent,requirement the 2 objects to check
+    *   \param recurse also checks indirect dependencies when set to true, false by default
+    *   \return true if a relationship exists with the given direction
+    */
+    template <typename T, size_t N>
+    constexpr bool StaticRequirements<T, N>::exists(T dependent, T requirement, bool recurse) const noexcept
+    {
+        return (recurse ? m_reach : m_requirements)[_index(dependent)].test(requirement);
+    }
+
+    /*! \brief Rebuilds the closure from the direct requirements (Warshall algorithm on rows of bits).
+    */
+    template <typename T, size_t N>
+    constexpr void StaticRequirements<T, N>::_build_reachability() noexcept
+    {
+        for (size_t id = 0; id < N; ++id)
+            m_reach[id] = m_requirements[id];
+        for (size_t k = 0; k < N; ++k)
+            for (size_t id = 0; id < N; ++id)
+                if (m_reach[id]._test(k))
+                    m_reach[id]._merge(m_reach[k]);
+    }
+
+}
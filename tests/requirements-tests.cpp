@@ -1,5 +1,27 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <memory_resource>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 #include <gtest/gtest.h>
+
+#define REQUIREMENTS_ENABLE_INSTRUMENTATION      // the tests run on instrumented instances, the benchmarks on plain ones
 #include <requirements.hpp>
+#include <requirements_concurrent.hpp>
+#include <requirements_mapped.hpp>
+#include <requirements_packed.hpp>
+#include <requirements_parallel.hpp>
+#include <requirements_sharded.hpp>
+#include <requirements_static.hpp>
 
 enum class NiceGuys
 {
@@ -112,6 +134,331 @@ TEST_F(RequirementsTest, All_Dependencies)
         EXPECT_TRUE(path.back() == ng::Joe || path.back() == ng::Kyle);
 }
 
+TEST_F(RequirementsTest, Topological_Order)
+{
+    auto order = req1.topological_order();
+    ASSERT_EQ(order.size(), 4);
+    auto position = [&order](ng object) { return std::find(order.begin(), order.end(), object) - order.begin(); };
+    EXPECT_LT(position(ng::John), position(ng::Jack));
+    EXPECT_LT(position(ng::Jack), position(ng::Kyle));
+    EXPECT_LT(position(ng::John), position(ng::Joe));
+    EXPECT_TRUE(req0.topological_order().empty());
+}
+
+TEST_F(RequirementsTest, Topological_Levels)
+{
+    auto levels = req1.topological_levels();
+    ASSERT_EQ(levels.size(), 3);
+    ASSERT_EQ(levels[0].size(), 1);
+    EXPECT_EQ(levels[0][0], ng::John);
+    EXPECT_EQ(levels[1].size(), 2);                 // Jack and Joe
+    ASSERT_EQ(levels[2].size(), 1);
+    EXPECT_EQ(levels[2][0], ng::Kyle);
+}
+
+TEST(RequirementsOrderTest, Online_Topological_Order)
+{
+    Requirements::Requirements<int> req{};
+    auto check = [&req]()
+    {
+        auto order = req.topological_order();
+        auto position = [&order](int object) { return std::find(order.begin(), order.end(), object) - order.begin(); };
+        size_t involved{ 0 };
+        for (int object = 0; object < 1201; ++object)
+            if (req.has_requirements(object) || req.has_dependents(object))
+                ++involved;
+        EXPECT_EQ(order.size(), involved);
+        for (const auto& relation : req.get())
+            EXPECT_LT(position(relation.second), position(relation.first)) << relation.first << " " << relation.second;
+    };
+    unsigned seed{ 42 };
+    for (int i = 0; i < 400; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        int dep = static_cast<int>(seed >> 16) % 60;
+        seed = seed * 1103515245 + 12345;
+        int r = static_cast<int>(seed >> 16) % 60;
+        if (dep != r && !req.exists(dep, r, true) && !req.exists(r, dep, true))
+            req.add(dep, r);
+        if (i % 50 == 0)
+            check();
+    }
+    check();
+    req.remove_all(5);
+    req.compact();
+    req.add(5, 99);
+    check();
+    EXPECT_TRUE(req.bulk_merge({ { 98, 99 }, { 97, 98 } }).empty());
+    req.add(99, 96);
+    check();
+}
+
+TEST(RequirementsOrderTest, Order_Kept_After_Budget_Overflow)
+{
+    Requirements::Requirements<int> req{};
+    auto pruned = [&req](int dependent, int requirement)
+    {
+        req.reset_statistics();
+        bool found = req.exists(dependent, requirement, true);
+        return !found && req.statistics().visited == 0;     // rejected by the positions, without any walk
+    };
+    for (int i = 1; i <= 300; ++i)
+    {
+        req.add(i, i - 1);              // 0 to 300 placed after each other
+        req.add(1000 + i - 1, 1000 + i);    // 1300 to 1001 placed before them
+    }
+    req.add(1300, 300);                 // moves the 301 objects of the first chain, more than the budget of the reordering
+    EXPECT_TRUE(req.exists(1000, 0, true));
+    req.add(5000, 1000);
+    EXPECT_TRUE(pruned(1000, 5000));    // 601 objects would be walked without the order
+    for (int i = 1; i <= 100; ++i)
+        req.add(2000 + i, 1000);
+    EXPECT_TRUE(pruned(1000, 2050));
+    req.remove_all(2001);
+    req.compact();                      // gives the order up, the next relation rebuilds it
+    req.add(2001, 1000);
+    EXPECT_TRUE(pruned(1000, 2001));
+    EXPECT_TRUE(req.bulk_merge({ { 3000, 2001 }, { 3001, 3000 } }).empty());
+    EXPECT_TRUE(pruned(1000, 3001));
+    auto order = req.topological_order();
+    auto position = [&order](int object) { return std::find(order.begin(), order.end(), object) - order.begin(); };
+    for (const auto& relation : req.get())
+        EXPECT_LT(position(relation.second), position(relation.first)) << relation.first << " " << relation.second;
+}
+
+TEST(RequirementsCondensationTest, Condensation)
+{
+    Requirements::Requirements<int> req{ true };
+    req.add(1, 2);      // 1 and 2 form a cycle, which requires the cycle 3, 4, 5, which requires 6
+    req.add(2, 1);
+    req.add(1, 4);
+    req.add(2, 3);
+    req.add(3, 4);
+    req.add(4, 5);
+    req.add(5, 3);
+    req.add(5, 6);
+    req.add(8, 7);
+    req.remove(8, 7);   // 7 and 8 are left without relation
+    auto graph = req.condensation();
+    EXPECT_EQ(graph.size(), 5);
+    auto first = graph.component_of(1), second = graph.component_of(3), last = graph.component_of(6);
+    EXPECT_EQ(graph.component_of(2), first);
+    EXPECT_EQ(graph.component_of(5), second);
+    EXPECT_EQ(graph.component_of(42), Requirements::Requirements<int>::npos);
+    EXPECT_TRUE(graph.cyclic(first) && graph.cyclic(second) && !graph.cyclic(last));
+    EXPECT_LT(last, second);                                    // requirements come first
+    EXPECT_LT(second, first);
+    ASSERT_EQ(graph.requirements(first).size(), 1);             // 2 -> 3 and 1 -> 4 are merged
+    EXPECT_EQ(graph.requirements(first)[0], second);
+    ASSERT_EQ(graph.dependents(second).size(), 1);
+    EXPECT_EQ(graph.dependents(second)[0], first);
+    auto objects = graph.objects(second).to_vector();
+    std::sort(objects.begin(), objects.end());
+    EXPECT_EQ(objects, (std::vector<int>{ 3, 4, 5 }));
+    auto closure = graph.transitive_requirements(first);
+    std::sort(closure.begin(), closure.end());
+    EXPECT_EQ(closure, (std::vector<Requirements::Requirements<int>::node_id>{ last, second }));
+    EXPECT_TRUE(graph.transitive_dependents(first).empty());
+    auto levels = graph.levels();
+    ASSERT_EQ(levels.size(), 3);                                // 7 and 8 are left out
+    EXPECT_EQ(levels[0], (std::vector<Requirements::Requirements<int>::node_id>{ last }));
+    EXPECT_EQ(levels[2], (std::vector<Requirements::Requirements<int>::node_id>{ first }));
+    auto chains = graph.requirement_chains(first);
+    ASSERT_EQ(chains.size(), 1);
+    EXPECT_EQ(chains[0], (std::vector<Requirements::Requirements<int>::node_id>{ first, second, last }));
+    EXPECT_EQ(graph.dependency_chains(last).size(), 1);
+}
+
+TEST(RequirementsJournalTest, Changes_Since_And_Hook)
+{
+    Requirements::Requirements<int> req{};
+    req.add(1, 2);
+    EXPECT_EQ(req.version(), 1);                                // versions are counted without journal
+    req.journal_changes(true);
+    EXPECT_EQ(req.journal_origin(), 1);
+    std::vector<size_t> published{};
+    req.set_change_hook([&published](Requirements::Span<Requirements::Change<int>> changes) { published.push_back(changes.size()); });
+    req.add(2, 3);
+    req.add(4, 3);
+    req.remove_requirement(3);                                  // a single publication for both relations
+    EXPECT_EQ(req.version(), 5);
+    EXPECT_EQ(published, (std::vector<size_t>{ 1, 1, 2 }));
+    auto changes = req.changes_since(1);
+    ASSERT_EQ(changes.size(), 4);
+    EXPECT_EQ(changes[0].version, 2);
+    EXPECT_EQ(changes[0].kind, Requirements::ChangeKind::Added);
+    EXPECT_EQ(changes[1].dependent, 4);
+    EXPECT_EQ(changes[1].requirement, 3);
+    EXPECT_EQ(changes[3].kind, Requirements::ChangeKind::Removed);
+    EXPECT_EQ(req.changes_since(5).size(), 0);
+    EXPECT_FALSE(req.bulk_merge({ { 5, 6 }, { 6, 5 } }).empty());     // rejected batches are not published
+    EXPECT_EQ(req.version(), 5);
+    EXPECT_EQ(published.size(), 3);
+    EXPECT_TRUE(req.bulk_set({ { 5, 6 }, { 6, 7 } }).empty());
+    EXPECT_EQ(published.back(), 3);                             // 1 -> 2 removed, then the 2 new relations
+    changes = req.changes_since(5);
+    ASSERT_EQ(changes.size(), 3);
+    EXPECT_EQ(changes[0].kind, Requirements::ChangeKind::Removed);
+    EXPECT_EQ(changes[0].dependent, 1);
+    EXPECT_EQ(changes[2].version, 8);
+    req.forget_changes(7);
+    EXPECT_EQ(req.journal_origin(), 7);
+    ASSERT_EQ(req.changes_since(7).size(), 1);
+    EXPECT_EQ(req.changes_since(7)[0].version, 8);
+    req.clear();
+    EXPECT_EQ(req.version(), 10);
+    EXPECT_EQ(req.changes_since(7).size(), 3);
+}
+
+TEST(RequirementsImpactTest, Impacted_Dependents)
+{
+    Requirements::Requirements<int> req{};
+    req.add(2, 1);
+    req.add(3, 1);
+    req.add(4, 2);
+    req.add(5, 3);
+    req.add(6, 4);
+    req.add(6, 5);
+    EXPECT_EQ(req.impacted_dependents(1, 1), (std::vector<int>{ 2, 3 }));
+    EXPECT_EQ(req.impacted_dependents(1, 2), (std::vector<int>{ 2, 3, 4, 5 }));
+    EXPECT_EQ(req.impacted_dependents(1, 10), (std::vector<int>{ 2, 3, 4, 5, 6 }));
+    EXPECT_EQ(req.impacted_dependents(1, 10, 3), (std::vector<int>{ 2, 3, 4 }));
+    EXPECT_TRUE(req.impacted_dependents(1, 0).empty());
+    EXPECT_TRUE(req.impacted_dependents(7, 10).empty());
+    auto expand = [](int object) { return object != 2; };      // the walk stops at 2, 6 is still reached through 3 and 5
+    EXPECT_EQ(req.impacted_dependents(1, 10, 10, expand), (std::vector<int>{ 2, 3, 5, 6 }));
+    Requirements::FrozenRequirements<int> frozen{ req };
+    EXPECT_EQ(frozen.impacted_dependents(1, 2), (std::vector<int>{ 2, 3, 4, 5 }));
+    EXPECT_EQ(frozen.impacted_dependents(1, 10, 10, expand), (std::vector<int>{ 2, 3, 5, 6 }));
+    EXPECT_EQ(req.transitive_dependents(1).size(), 5u);        // scratch buffers left clean
+}
+
+TEST(RequirementsImpactTest, Impacted_Dependents_Reentrant_Predicate)
+{
+    Requirements::Requirements<int> req{};
+    req.add(2, 1);
+    req.add(3, 1);
+    req.add(4, 2);
+    req.add(5, 3);
+    Requirements::FrozenRequirements<int> frozen{ req };
+    auto query = [&req, &frozen](int object) { return req.exists(object, 1, true) && frozen.exists(object, 1, true); };
+    EXPECT_EQ(req.impacted_dependents(1, 10, 10, query), (std::vector<int>{ 2, 3, 4, 5 }));
+    EXPECT_EQ(frozen.impacted_dependents(1, 10, 10, query), (std::vector<int>{ 2, 3, 4, 5 }));
+    auto fail = [](int) -> bool { throw std::runtime_error{ "expand" }; };
+    EXPECT_THROW(req.impacted_dependents(1, 10, 10, fail), std::runtime_error);
+    EXPECT_THROW(frozen.impacted_dependents(1, 10, 10, fail), std::runtime_error);
+    EXPECT_EQ(req.transitive_dependents(1).size(), 4u);        // scratch buffers left clean after the exception
+    EXPECT_EQ(frozen.transitive_dependents(1).size(), 4u);
+    EXPECT_EQ(frozen.impacted_dependents(1, 10), (std::vector<int>{ 2, 3, 4, 5 }));
+}
+
+TEST(RequirementsWalkTest, Resumable_Walks)
+{
+    Requirements::Requirements<int> req{};
+    for (int i = 1; i <= 2000; ++i)
+        req.add(i, i - 1);
+    auto walk = req.transitive_requirements_walk(2000);
+    size_t steps{ 0 };
+    while (walk.resume(100) == Requirements::WalkStatus::Running)
+    {
+        EXPECT_EQ(walk.objects().size(), walk.visited());
+        EXPECT_TRUE(req.exists(10, 0, true));      // other queries between 2 steps
+        ++steps;
+    }
+    EXPECT_EQ(steps, 20u);
+    EXPECT_EQ(walk.status(), Requirements::WalkStatus::Done);
+    EXPECT_EQ(walk.objects(), req.transitive_requirements(2000));
+    EXPECT_EQ(req.transitive_dependents_walk(5000).resume(), Requirements::WalkStatus::Done);   // unknown object
+
+    Requirements::Requirements<int> cached{};
+    cached.cache_reachability(true);
+    cached.add(7, 100);
+    cached.add(2, 7);
+    cached.add(101, 2);
+    cached.add(9, 101);
+    cached.add(5, 9);
+    cached.add(1, 5);
+    auto closure = cached.transitive_requirements_walk(1);
+    EXPECT_EQ(closure.resume(), Requirements::WalkStatus::Done);
+    EXPECT_EQ(closure.objects(), (std::vector<int>{ 5, 9, 101, 2, 7, 100 }));      // breadth-first
+    auto expected = cached.transitive_requirements(1);                              // by node id, from the cache
+    EXPECT_EQ(expected, (std::vector<int>{ 7, 100, 2, 101, 9, 5 }));
+    auto objects = closure.objects();
+    std::sort(objects.begin(), objects.end());
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(objects, expected);
+
+    auto cancelled = req.transitive_dependents_walk(0);
+    cancelled.resume(10);
+    cancelled.cancel();
+    EXPECT_EQ(cancelled.resume(), Requirements::WalkStatus::Cancelled);
+    EXPECT_EQ(cancelled.objects().size(), 10u);
+    auto expired = req.transitive_dependents_walk(0);
+    expired.set_deadline(std::chrono::steady_clock::now() - std::chrono::seconds{ 1 });
+    EXPECT_EQ(expired.resume(), Requirements::WalkStatus::Expired);
+    auto invalidated = req.transitive_dependents_walk(0);
+    invalidated.resume(10);
+    req.add(3000, 2000);
+    EXPECT_EQ(invalidated.resume(), Requirements::WalkStatus::Invalidated);
+
+    Requirements::Requirements<int> diamonds{};
+    for (int i = 0; i < 6; ++i)
+    {
+        diamonds.add(3 * i + 1, 3 * i);
+        diamonds.add(3 * i + 2, 3 * i);
+        diamonds.add(3 * i + 3, 3 * i + 1);
+        diamonds.add(3 * i + 3, 3 * i + 2);
+    }
+    Requirements::Requirements<int>::ChainsWalk chains{ diamonds.requirement_chains(true) };
+    while (chains.resume(10) == Requirements::WalkStatus::Running)
+        ;
+    EXPECT_EQ(chains.chains(), diamonds.all_requirements(true));
+    EXPECT_EQ(chains.chains().size(), 64u);
+}
+
+TEST_F(RequirementsTest, Requirement_Chains)
+{
+    size_t count{ 0 };
+    for (const auto& chain : req1.requirement_chains(true))
+    {
+        EXPECT_EQ(chain.back(), ng::John);
+        EXPECT_EQ(std::vector<ng>(chain.begin(), chain.end()), chain.to_vector());
+        ++count;
+    }
+    EXPECT_EQ(count, 2);
+    auto chains = req1.dependency_chains(ng::John);
+    auto first = chains.begin();
+    ASSERT_NE(first, chains.end());
+    EXPECT_EQ((*first).front(), ng::John);
+    auto kyle = req1.requirement_chains(ng::Kyle);
+    EXPECT_EQ(std::distance(kyle.begin(), kyle.end()), 1);
+}
+
+TEST_F(RequirementsTest, All_Requirements_Reflexive)
+{
+    auto chains = req2.all_requirements(ng::Harry);     // Harry -> Joe -> Harry stops at Joe
+    ASSERT_EQ(chains.size(), 1);
+    EXPECT_EQ(chains[0], std::vector<ng>({ ng::Harry, ng::Joe }));
+    EXPECT_EQ(req2.all_dependencies(false).size(), 2);
+}
+
+TEST_F(RequirementsTest, Transitive_Requirements)
+{
+    auto reqs = req1.transitive_requirements(ng::Kyle);
+    std::sort(reqs.begin(), reqs.end());
+    EXPECT_EQ(reqs, std::vector<ng>({ ng::John, ng::Jack }));
+    auto deps = req1.transitive_dependents(ng::John);
+    EXPECT_EQ(deps.size(), 3);
+    std::vector<ng> out(4);
+    auto end = req1.transitive_dependents(ng::Jack, out.begin());
+    EXPECT_EQ(end - out.begin(), 1);
+    EXPECT_EQ(out[0], ng::Kyle);
+    EXPECT_TRUE(req1.transitive_requirements(ng::Harry).empty());
+    EXPECT_EQ(req2.transitive_requirements(ng::Joe).size(), 2);         // Harry, and Joe itself through the cycle
+    req1.cache_reachability(true);
+    EXPECT_EQ(req1.transitive_requirements(ng::Kyle).size(), 2);
+}
+
 TEST_F(RequirementsTest, Exists_Recursive)
 {
     EXPECT_TRUE(req1.exists(ng::Kyle, ng::John, true));
@@ -120,6 +467,28 @@ TEST_F(RequirementsTest, Exists_Recursive)
     EXPECT_TRUE(req2.exists(ng::Joe, ng::Harry, true));
 }
 
+TEST(RequirementsDeepTest, Exists_Recursive_Long_Chain)
+{
+    Requirements::Requirements<int> chain;
+    for (int i = 0; i < 20000; ++i)
+        chain.add(i, i + 1);
+    EXPECT_TRUE(chain.exists(0, 20000, true));
+    EXPECT_FALSE(chain.exists(20000, 0, true));
+}
+
+TEST(RequirementsDeepTest, Exists_Recursive_Reflexive_Cycle)
+{
+    Requirements::Requirements<int> cycle{ true };
+    cycle.add(1, 2);
+    cycle.add(2, 3);
+    cycle.add(3, 1);
+    EXPECT_TRUE(cycle.exists(1, 3, true));
+    EXPECT_TRUE(cycle.exists(3, 3, true));
+    EXPECT_FALSE(cycle.exists(1, 4, true));
+    cycle.add(4, 5);
+    EXPECT_FALSE(cycle.exists(2, 5, true));
+}
+
 TEST_F(RequirementsTest, Remove_All)
 {
     req1.remove_all(ng::Jack);
@@ -128,6 +497,448 @@ TEST_F(RequirementsTest, Remove_All)
     EXPECT_EQ(req1.size(), 1);
 }
 
+TEST(RequirementsCompactTest, Remove_All_And_Compact)
+{
+    Requirements::Requirements<std::string> req{ false };
+    req.add("hub", "base");
+    for (int i = 0; i < 100; ++i)
+        req.add("leaf" + std::to_string(i), "hub");
+    req.add("app", "leaf7");
+    req.remove_all("hub");
+    EXPECT_EQ(req.size(), 1);
+    EXPECT_FALSE(req.has_dependents("hub"));
+    EXPECT_TRUE(req.requirements("leaf3").empty());
+    EXPECT_EQ(req.tombstones(), 1);
+    req.remove_all("leaf5");
+    req.remove_all("base");
+    req.add("leaf5", "leaf7");    // involved again: its slot is kept
+    auto count = req.node_count();
+    EXPECT_EQ(req.compact(1), 1);
+    EXPECT_EQ(req.compact(), 1);
+    EXPECT_EQ(req.tombstones(), 0);
+    EXPECT_EQ(req.node_count(), count - 2);
+    EXPECT_EQ(req.id_of("hub"), Requirements::Requirements<std::string>::npos);
+    EXPECT_EQ(req.size(), 2);
+    EXPECT_TRUE(req.exists("app", "leaf7"));
+    EXPECT_TRUE(req.exists("leaf5", "leaf7"));
+    for (Requirements::Requirements<std::string>::node_id id = 0; id < req.node_count(); ++id)
+    {
+        EXPECT_EQ(req.id_of(req.node(id)), id);
+        for (auto other : req.requirement_ids(id))
+            EXPECT_NE(std::find(req.dependent_ids(other).begin(), req.dependent_ids(other).end(), id), req.dependent_ids(other).end());
+    }
+    req.add("leaf9", "app");
+    EXPECT_TRUE(req.exists("leaf9", "leaf7", true));
+}
+
+TEST_F(RequirementsTest, Remove_Keeps_Dependents_In_Sync)
+{
+    req1.remove(ng::Jack, ng::John);
+    auto deps = req1.dependents(ng::John);
+    ASSERT_EQ(deps.size(), 1);
+    EXPECT_EQ(deps[0], ng::Joe);
+    req1.remove_requirement(ng::John);
+    EXPECT_FALSE(req1.has_dependents(ng::John));
+    EXPECT_FALSE(req1.has_requirements(ng::Joe));
+    req1.remove_dependent(ng::Kyle);
+    EXPECT_FALSE(req1.has_dependents(ng::Jack));
+    EXPECT_TRUE(req1.empty());
+}
+
+TEST_F(RequirementsTest, Node_Ids)
+{
+    EXPECT_EQ(req1.node_count(), 4);
+    auto jack = req1.id_of(ng::Jack);
+    auto john = req1.id_of(ng::John);
+    ASSERT_NE(jack, req1.npos);
+    ASSERT_NE(john, req1.npos);
+    EXPECT_EQ(req1.id_of(ng::Harry), req1.npos);
+    EXPECT_EQ(req1.node(jack), ng::Jack);
+    ASSERT_EQ(req1.requirement_ids(jack).size(), 1);
+    EXPECT_EQ(req1.requirement_ids(jack)[0], john);
+    EXPECT_EQ(req1.dependent_ids(john).size(), 2);
+    EXPECT_TRUE(req1.exists_ids(req1.id_of(ng::Kyle), john, true));
+    EXPECT_FALSE(req1.exists_ids(john, jack, true));
+}
+
+TEST(RequirementsBitsetTest, Kernels)
+{
+    std::uint64_t seed{ 0x9E3779B97F4A7C15 };
+    auto next = [&seed] { seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17; return seed; };
+    for (size_t words : { 0, 1, 7, 8, 9, 31, 64, 67 })
+    {
+        Requirements::Bitset a{}, b{};
+        size_t count_a{ 0 }, count_or{ 0 }, count_and{ 0 };
+        for (size_t pos = 0; pos < words * 64; ++pos)
+        {
+            bool in_a = next() % 3 == 0;
+            bool in_b = next() % 5 == 0;
+            if (in_a)
+                a.set(pos);
+            if (in_b)
+                b.set(pos);
+            count_a += in_a;
+            count_or += in_a || in_b;
+            count_and += in_a && in_b;
+        }
+        EXPECT_EQ(a.count(), count_a) << Requirements::BitsetKernels::name();
+        EXPECT_EQ(a.intersects(b), count_and != 0);
+        auto united = a;
+        united |= b;
+        EXPECT_EQ(united.count(), count_or);
+        auto common = a;
+        common &= b;
+        EXPECT_EQ(common.count(), count_and);
+        EXPECT_FALSE(common.intersects(Requirements::Bitset{}));
+    }
+    Requirements::Bitset sparse{};
+    sparse.set(3);
+    sparse.set(700);
+    EXPECT_EQ(sparse.find_next(4), 700);
+    EXPECT_EQ(sparse.find_next(701), Requirements::Bitset::npos);
+}
+
+TEST_F(RequirementsTest, Reachability_Cache)
+{
+    req1.cache_reachability(true);
+    EXPECT_TRUE(req1.reachability_cached());
+    EXPECT_TRUE(req1.exists(ng::Kyle, ng::John, true));
+    EXPECT_FALSE(req1.exists(ng::Jack, ng::Joe, true));
+    req1.add(ng::Harry, ng::Kyle);                  // incremental update
+    EXPECT_TRUE(req1.exists(ng::Harry, ng::John, true));
+    req1.remove(ng::Jack, ng::John);                // lazy rebuild
+    EXPECT_FALSE(req1.exists(ng::Harry, ng::John, true));
+    EXPECT_TRUE(req1.exists(ng::Harry, ng::Jack, true));
+    req2.cache_reachability(true);
+    EXPECT_TRUE(req2.exists(ng::Harry, ng::Harry, true));
+    EXPECT_TRUE(req2.exists(ng::Joe, ng::Harry, true));
+    EXPECT_FALSE(req2.exists(ng::Joe, ng::Kyle, true));
+}
+
+TEST_F(RequirementsTest, Bulk_Set)
+{
+    auto violations = req0.bulk_set(req1.get());
+    EXPECT_TRUE(violations.empty());
+    EXPECT_EQ(req0.size(), 3);
+    EXPECT_TRUE(req0.exists(ng::Kyle, ng::John, true));
+    violations = req0.bulk_set({ { ng::Harry, ng::Harry } });
+    ASSERT_EQ(violations.size(), 1);
+    EXPECT_EQ(violations[0].kind, Requirements::ViolationKind::SelfRequirement);
+    EXPECT_EQ(req0.size(), 3);                      // previous dependencies are restored
+}
+
+TEST_F(RequirementsTest, Bulk_Merge_Reports_All_Violations)
+{
+    std::vector<std::pair<ng, ng>> batch{
+        { ng::Harry, ng::Kyle },                    // valid
+        { ng::Jack, ng::John },                     // duplicate
+        { ng::Harry, ng::Jack },                    // implied by Harry -> Kyle -> Jack
+        { ng::John, ng::Joe }                       // opposite of Joe -> John
+    };
+    auto violations = req1.bulk_merge(batch.begin(), batch.end());
+    ASSERT_EQ(violations.size(), 3);
+    size_t duplicates{ 0 }, implicits{ 0 }, cycles{ 0 };
+    for (const auto& violation : violations)
+    {
+        duplicates += violation.kind == Requirements::ViolationKind::Duplicate;
+        implicits += violation.kind == Requirements::ViolationKind::ImplicitDuplicate;
+        cycles += violation.kind == Requirements::ViolationKind::Cycle;
+    }
+    EXPECT_EQ(duplicates, 1);
+    EXPECT_EQ(implicits, 1);
+    EXPECT_EQ(cycles, 1);
+    EXPECT_EQ(req1.size(), 3);                      // the batch is rolled back
+    EXPECT_FALSE(req1.has_requirements(ng::Harry));
+    batch.resize(1);
+    EXPECT_TRUE(req1.bulk_merge(batch.begin(), batch.end()).empty());
+    EXPECT_TRUE(req1.exists(ng::Harry, ng::John, true));
+}
+
+TEST(RequirementsBulkTest, Bulk_Reflexive_Implicits)
+{
+    Requirements::Requirements<int> req{ true };
+    EXPECT_TRUE(req.bulk_set({ { 1, 2 }, { 2, 3 }, { 3, 1 } }).empty());
+    auto violations = req.bulk_merge({ { 1, 3 } });            // implied by 1 -> 2 -> 3
+    ASSERT_EQ(violations.size(), 1);
+    EXPECT_EQ(violations[0].kind, Requirements::ViolationKind::ImplicitDuplicate);
+    EXPECT_EQ(req.size(), 3);
+    EXPECT_FALSE(req.exists(1, 3));
+    violations = req.bulk_set({ { 1, 2 }, { 2, 3 }, { 3, 1 }, { 1, 3 } });
+    ASSERT_EQ(violations.size(), 1);
+    EXPECT_EQ(violations[0].dependent, 1);
+    EXPECT_EQ(violations[0].requirement, 3);
+    EXPECT_TRUE(req.bulk_set({ { 1, 2 }, { 2, 1 }, { 2, 3 }, { 3, 2 } }).empty());     // 2 cycles sharing an object
+    EXPECT_EQ(req.size(), 4);
+}
+
+TEST(RequirementsBulkTest, Bulk_Rejected_Keeps_Order_And_Cache)
+{
+    Requirements::Requirements<int> req{};
+    for (int i = 1; i <= 10; ++i)
+        req.add(i, i - 1);
+    req.add(10, 20);
+    EXPECT_FALSE(req.bulk_merge({ { 30, 31 }, { 0, 10 } }).empty());     // closes a cycle, rolled back
+    req.reset_statistics();
+    EXPECT_TRUE(req.exists(10, 0, true));
+    EXPECT_EQ(req.statistics().visited, 10);     // still pruned by the topological order, 20 is skipped
+    Requirements::Requirements<int> cached{ true };
+    cached.cache_reachability(true);
+    cached.add(2, 1);
+    EXPECT_TRUE(cached.exists(2, 1, true));
+    EXPECT_FALSE(cached.bulk_merge({ { 3, 2 }, { 3, 4 }, { 3, 3 } }).empty());
+    cached.reset_statistics();
+    EXPECT_TRUE(cached.exists(2, 1, true));
+    EXPECT_FALSE(cached.exists(3, 1, true));
+    EXPECT_EQ(cached.statistics().walks, 0);     // answered by the cache built before the batch
+    EXPECT_TRUE(cached.bulk_merge({ { 3, 2 } }).empty());
+    EXPECT_TRUE(cached.exists(3, 1, true));
+}
+
+TEST(RequirementsStreamTest, Bulk_Merge_Stream)
+{
+    Requirements::Requirements<std::string> names{};
+    std::istringstream text{ "# dependent,requirement\nkyle , jack\r\njack,john\n\njoe,john\nkyle,john" };
+    auto violations = names.bulk_merge(text, ',', 4);    // lines span several chunks
+    ASSERT_EQ(violations.size(), 1);
+    EXPECT_EQ(violations[0].dependent, "kyle");
+    EXPECT_EQ(violations[0].kind, Requirements::ViolationKind::ImplicitDuplicate);
+    EXPECT_TRUE(names.empty());
+    std::istringstream valid{ "kyle , jack\r\njack,john\n\njoe,john\n" };
+    EXPECT_TRUE(names.bulk_merge(valid, ',', 4).empty());
+    EXPECT_TRUE(names.exists("kyle", "john", true));
+    EXPECT_EQ(names.size(), 3);
+
+    Requirements::Requirements<int> numbers{};
+    std::istringstream tabs{ "1\t2\n2\t3\n3\tx\n" };
+    EXPECT_THROW(numbers.bulk_merge(tabs, '\t'), std::invalid_argument);
+    EXPECT_EQ(numbers.node_count(), 0);                  // the lines read before the error are rolled back
+    std::istringstream pairs{ "1 2 3" };
+    auto parse = [](std::string_view line) { return std::make_optional(std::make_pair(int{ line[0] - '0' }, int{ line[2] - '0' })); };
+    EXPECT_TRUE(numbers.bulk_merge(pairs, parse).empty());
+    EXPECT_TRUE(numbers.exists(1, 2));
+}
+
+TEST_F(RequirementsTest, Views)
+{
+    auto deps = req1.dependents_view(ng::John);
+    EXPECT_EQ(std::vector<NiceGuys>(deps.begin(), deps.end()), req1.dependents(ng::John));
+    EXPECT_EQ(deps.to_vector(), req1.dependents(ng::John));
+    ASSERT_FALSE(deps.empty());
+    EXPECT_EQ(deps[0], req1.node(deps.ids()[0]));
+    EXPECT_EQ(req1.requirements_view(ng::Kyle).size(), req1.requirements(ng::Kyle).size());
+    EXPECT_TRUE(req1.requirements_view(ng::Harry).empty());
+    Requirements::Requirements<std::string> names{ false };
+    names.add("app", "lib");
+    EXPECT_EQ(&*names.requirements_view("app").begin(), &names.node(names.id_of("lib")));    // no copy of the objects
+}
+
+TEST_F(RequirementsTest, Freeze)
+{
+    auto frozen = req1.freeze();
+    EXPECT_EQ(frozen.size(), req1.size());
+    EXPECT_EQ(frozen.node_count(), req1.node_count());
+    EXPECT_EQ(frozen.id_of(ng::Jack), req1.id_of(ng::Jack));
+    EXPECT_TRUE(frozen.exists(ng::Kyle, ng::Jack));
+    EXPECT_FALSE(frozen.exists(ng::Kyle, ng::John));
+    EXPECT_TRUE(frozen.exists(ng::Kyle, ng::John, true));
+    EXPECT_FALSE(frozen.exists(ng::John, ng::Kyle, true));
+    EXPECT_EQ(frozen.dependents(ng::John).to_vector(), req1.dependents(ng::John));
+    EXPECT_TRUE(frozen.requirements(ng::Harry).empty());
+    EXPECT_FALSE(frozen.has_dependents(ng::Kyle));
+    auto reqs = frozen.transitive_requirements(ng::Kyle);
+    std::sort(reqs.begin(), reqs.end());
+    EXPECT_EQ(reqs, (std::vector<ng>{ ng::John, ng::Jack }));
+    req1.clear();
+    EXPECT_TRUE(frozen.has_requirements(ng::Joe));  // the copy does not depend on its source
+    auto cycle = req2.freeze();
+    EXPECT_TRUE(cycle.reflexive());
+    EXPECT_TRUE(cycle.exists(ng::Harry, ng::Harry, true));
+    EXPECT_EQ(cycle.transitive_dependents(ng::Joe).size(), 2);
+}
+
+TEST(RequirementsPackedTest, Packed_And_Memory_Usage)
+{
+    Requirements::Requirements<std::string> req{ true };
+    for (int i = 1; i < 70000; ++i)     // more than one page of offsets, gaps of several bytes
+        req.add(std::to_string(i), std::to_string(i / 2));
+    req.add("1", "69999");
+    Requirements::PackedRequirements<std::string> packed{ req };
+    EXPECT_EQ(packed.size(), req.size());
+    EXPECT_EQ(packed.node_count(), req.node_count());
+    EXPECT_TRUE(packed.reflexive());
+    auto sorted = [](std::vector<std::string> objects) { std::sort(objects.begin(), objects.end()); return objects; };
+    for (int i : { 0, 1, 2, 300, 34999, 65535, 65536, 69999 })
+    {
+        auto object = std::to_string(i);
+        EXPECT_EQ(packed.id_of(object), req.id_of(object));
+        EXPECT_EQ(sorted(packed.requirements(object)), sorted(req.requirements(object)));
+        EXPECT_EQ(sorted(packed.dependents(object)), sorted(req.dependents(object)));
+        EXPECT_EQ(packed.has_dependents(object), req.has_dependents(object));
+    }
+    EXPECT_EQ(packed.id_of("70000"), packed.npos);
+    EXPECT_TRUE(packed.exists("69999", "34999"));
+    EXPECT_FALSE(packed.exists("69999", "17499"));
+    EXPECT_TRUE(packed.exists("69999", "17499", true));
+    EXPECT_TRUE(packed.exists("1", "1", true));
+    EXPECT_EQ(sorted(packed.transitive_requirements("300")), sorted(req.transitive_requirements("300")));
+    EXPECT_EQ(sorted(packed.transitive_dependents("34999")), sorted(req.transitive_dependents("34999")));
+
+    auto before = req.memory_usage();
+    EXPECT_NE(before.scratch, 0u);
+    EXPECT_EQ(before.cache, 0u);
+    req.shrink_to_fit();
+    auto after = req.memory_usage();
+    EXPECT_EQ(after.scratch, 0u);
+    EXPECT_LE(after.adjacency, before.adjacency);
+    EXPECT_LE(after.total(), before.total());
+    EXPECT_TRUE(req.exists("69999", "17499", true));
+    EXPECT_LT(packed.memory_usage().adjacency * 3, after.adjacency);      // 1 relation per object is the worst case of the offsets
+    EXPECT_LT(packed.memory_usage().total(), Requirements::FrozenRequirements<std::string>{ req }.memory_usage().total());
+}
+
+TEST(RequirementsAllocatorTest, Pmr_Arena)
+{
+    std::array<std::byte, 1 << 16> buffer{};
+    std::pmr::monotonic_buffer_resource arena{ buffer.data(), buffer.size(), std::pmr::null_memory_resource() };
+    Requirements::pmr::Requirements<std::pmr::string> req{ false, &arena };
+    EXPECT_EQ(req.get_allocator().resource(), &arena);
+    req.add("build", "compile");
+    req.add("compile", "configure");
+    req.add("test", "build");
+    req.cache_reachability(true);
+    EXPECT_TRUE(req.exists("test", "configure", true));
+    EXPECT_TRUE(req.bulk_merge({ { { "deploy", "test" } }, &arena }).empty());
+    auto reqs = req.requirements("test");
+    EXPECT_EQ(reqs.get_allocator().resource(), &arena);
+    EXPECT_EQ(reqs.front().get_allocator().resource(), &arena);
+    EXPECT_EQ(req.topological_order().front(), "configure");
+    EXPECT_EQ(req.all_requirements(std::pmr::string{ "deploy" }).size(), 1);
+    EXPECT_EQ(req.freeze().transitive_requirements("deploy").size(), 4);
+    EXPECT_THROW(req.add(std::pmr::string(buffer.size(), 'x'), "configure"), std::bad_alloc);  // the arena never falls back to the heap
+}
+
+TEST_F(RequirementsTest, Mapped_File)
+{
+    auto path = ::testing::TempDir() + "requirements-mapped.bin";
+    Requirements::save(req1.freeze(), path);
+    {
+        Requirements::MappedRequirements<NiceGuys> mapped{ path };
+        EXPECT_FALSE(mapped.reflexive());
+        EXPECT_EQ(mapped.size(), req1.size());
+        EXPECT_EQ(mapped.node_count(), req1.node_count());
+        EXPECT_EQ(mapped.id_of(ng::Joe), req1.id_of(ng::Joe));
+        EXPECT_EQ(mapped.id_of(ng::Harry), Requirements::Requirements<NiceGuys>::npos);
+        EXPECT_TRUE(mapped.exists(ng::Kyle, ng::John, true));
+        EXPECT_FALSE(mapped.exists(ng::Kyle, ng::John));
+        EXPECT_EQ(mapped.dependents(ng::John), req1.dependents(ng::John));
+        EXPECT_THROW(Requirements::MappedRequirements<std::string>{ path }, std::runtime_error);
+    }
+    Requirements::Requirements<std::string> names{ true };
+    names.add("harry", "joe");
+    names.add("joe", "harry");
+    names.add("kyle", "joe");
+    Requirements::save(names.freeze(), path);
+    {
+        Requirements::MappedRequirements<std::string> mapped{ path };
+        EXPECT_TRUE(mapped.reflexive());
+        EXPECT_EQ(mapped.node(mapped.id_of("kyle")), "kyle");
+        EXPECT_TRUE(mapped.exists("harry", "harry", true));
+        EXPECT_FALSE(mapped.has_dependents("kyle"));
+        EXPECT_EQ(mapped.requirements("kyle"), (std::vector<std::string>{ "joe" }));
+    }
+    std::ofstream{ path, std::ios::binary | std::ios::trunc } << "not a requirements file";
+    EXPECT_THROW(Requirements::MappedRequirements<std::string>{ path }, std::runtime_error);
+    std::remove(path.c_str());
+}
+
+TEST(RequirementsMoveTest, Move_And_Emplace)
+{
+    Requirements::Requirements<std::string> req{ false };
+    std::string build{ "build" }, compile{ "compile" };
+    req.add(std::move(build), std::move(compile));
+    EXPECT_TRUE(build.empty());     // new objects are moved into the table
+    EXPECT_TRUE(compile.empty());
+    std::string test{ "test" }, again{ "build" };
+    req.add(std::move(test), std::move(again));
+    EXPECT_EQ(again, "build");      // known objects are left untouched
+    req.emplace("deploy", "test");
+    EXPECT_TRUE(req.exists("deploy", "compile", true));
+    std::unordered_multimap<std::string, std::string> table{ { "lint", "compile" }, { "package", "build" } };
+    req.merge(std::move(table));
+    EXPECT_TRUE(table.empty());
+    EXPECT_EQ(req.size(), 5);
+    req.set({ { "a", "b" } });
+    EXPECT_EQ(req.size(), 1);
+    EXPECT_EQ(req.requirements("a"), std::vector<std::string>{ "b" });
+}
+
+TEST(RequirementsInstrumentationTest, Statistics_And_Trace_Hook)
+{
+    Requirements::Requirements<int> req{ false };
+    std::vector<std::string> operations{};
+    req.set_trace_hook([&operations](const Requirements::TraceSpan& span)
+        {
+            operations.push_back(span.operation);
+            EXPECT_GE(span.duration.count(), 0);
+            EXPECT_NE(span.statistics, nullptr);
+        });
+    for (int i = 1; i <= 10; ++i)
+        req.add(i, i - 1);
+    req.add(10, 20);
+    EXPECT_EQ(operations.size(), 11);
+    EXPECT_EQ(operations.front(), "add");
+    req.reset_statistics();
+    EXPECT_TRUE(req.exists(10, 0, true));
+    EXPECT_EQ(req.statistics().lookups, 2);
+    EXPECT_EQ(req.statistics().walks, 1);
+    EXPECT_EQ(req.statistics().visited, 10);     // 10 and 9 to 1, 20 comes before 0 in the topological order and is skipped
+    EXPECT_EQ(req.statistics().peak_visited, 10);
+    auto chains = req.all_requirements(10);
+    EXPECT_EQ(req.statistics().chains, 2);
+    EXPECT_EQ(req.statistics().peak_chains, 2);
+    EXPECT_EQ(req.statistics().peak_chain_objects, 13);
+    EXPECT_EQ(operations.back(), "all_requirements");
+    req.set_trace_hook({});
+    req.add(11, 10);
+    EXPECT_EQ(operations.back(), "all_requirements");
+}
+
+constexpr Requirements::StaticRequirements<NiceGuys, 5> static_guys()
+{
+    Requirements::StaticRequirements<NiceGuys, 5> result{};
+    result.add(ng::Kyle, ng::Jack);
+    result.add(ng::Jack, ng::John);
+    result.add(ng::Joe, ng::John);
+    return result;
+}
+
+TEST(RequirementsStaticTest, Static_Requirements)
+{
+    constexpr auto guys = static_guys();        // built at compile time
+    static_assert(guys.size() == 3, "");
+    static_assert(guys.exists(ng::Kyle, ng::John, true), "");
+    static_assert(!guys.exists(ng::Kyle, ng::John), "");
+    static_assert(guys.closure(ng::Kyle).count() == 2, "");
+    EXPECT_EQ(guys.dependents(ng::John), (std::vector<NiceGuys>{ ng::Jack, ng::Joe }));
+    EXPECT_TRUE(guys.requirements(ng::Harry).empty());
+    auto copy = guys;
+    copy.remove(ng::Jack, ng::John);
+    EXPECT_FALSE(copy.exists(ng::Kyle, ng::John, true));
+    copy.add(ng::Kyle, ng::John);
+    copy.remove_all(ng::Kyle);
+    EXPECT_EQ(copy.size(), 1);
+    EXPECT_FALSE(copy.has_dependents(ng::Jack));
+    Requirements::StaticRequirements<int, 200> cycle{ true };
+    for (int i = 0; i < 199; ++i)
+        cycle.add(i + 1, i);
+    cycle.add(0, 199);
+    EXPECT_TRUE(cycle.exists(0, 0, true));
+    EXPECT_EQ(cycle.closure(100).count(), 200);
+    cycle.remove(0, 199);
+    EXPECT_FALSE(cycle.exists(0, 0, true));
+    EXPECT_EQ(cycle.transitive_requirements(3), (std::vector<int>{ 0, 1, 2 }));
+}
+
 TEST_F(RequirementsTest, Clear)
 {
     req1.clear();
@@ -137,3 +948,204 @@ TEST_F(RequirementsTest, Clear)
     EXPECT_EQ(req2.size(), 0);
     EXPECT_TRUE(req2.empty());
 }
+
+TEST_F(RequirementsTest, Execute_After_Requirements)
+{
+    std::mutex mutex{};
+    std::vector<ng> done{};
+    Requirements::execute(req1, [&](ng object)
+        {
+            std::lock_guard<std::mutex> lock{ mutex };
+            for (auto req : req1.requirements(object))
+                EXPECT_NE(std::find(done.begin(), done.end(), req), done.end());
+            done.push_back(object);
+        }, 4);
+    EXPECT_EQ(done.size(), 4);
+}
+
+TEST(RequirementsExecuteTest, Execute_Wide_Graph_And_Exceptions)
+{
+    Requirements::Requirements<int> wide;
+    for (int i = 1; i <= 1000; ++i)
+    {
+        wide.add(i, 0);
+        wide.add(-i, i);
+    }
+    Requirements::ThreadPool pool{ 8 };
+    std::atomic<int> count{ 0 };
+    Requirements::execute(wide, [&count](int) { ++count; }, pool);
+    EXPECT_EQ(count, 2001);
+    EXPECT_THROW(Requirements::execute(wide, [](int object) { if (object == 7) throw std::runtime_error("failed"); }, pool), std::runtime_error);
+}
+
+TEST(RequirementsExecuteTest, Parallel_Chains)
+{
+    Requirements::Requirements<int> req{ true };
+    for (int i = 0; i < 60; ++i)
+    {
+        req.add(i + 1, i / 2);
+        if (i % 9 == 0 && !req.exists(i / 4, i + 1, true))
+            req.add(i / 4, i + 1);      // creates cycles
+    }
+    Requirements::ThreadPool pool{ 4 };
+    for (bool without_duplicates : { false, true })
+    {
+        EXPECT_EQ(Requirements::all_requirements(req, without_duplicates, pool), req.all_requirements(without_duplicates));
+        EXPECT_EQ(Requirements::all_dependencies(req, without_duplicates, pool), req.all_dependencies(without_duplicates));
+    }
+    EXPECT_EQ(Requirements::all_requirements(req, false, 2), req.all_requirements(false));
+    size_t count{ 0 };
+    for (auto chain : req.requirement_chains(false, 10, 20))
+    {
+        EXPECT_GE(req.id_of(chain.front()), 10u);
+        EXPECT_LT(req.id_of(chain.front()), 20u);
+        ++count;
+    }
+    EXPECT_NE(count, 0u);
+}
+
+TEST(RequirementsShardedTest, Sharded_Queries_And_Updates)
+{
+    Requirements::Requirements<int> reference{};
+    Requirements::ShardedRequirements<int> sharded{ false, 4 };
+    for (int i = 1; i < 120; ++i)
+    {
+        reference.add(i, i / 2);
+        sharded.add(i, i / 2);
+        if (i % 5 == 0 && !reference.exists(i, i / 3, true))
+        {
+            reference.add(i, i / 3);
+            sharded.add(i, i / 3);
+        }
+    }
+    EXPECT_EQ(sharded.size(), reference.size());
+    auto sorted = [](std::vector<int> objects) { std::sort(objects.begin(), objects.end()); return objects; };
+    for (int object : { 0, 7, 64, 119, 500 })
+    {
+        EXPECT_EQ(sorted(sharded.requirements(object)), sorted(reference.requirements(object)));
+        EXPECT_EQ(sorted(sharded.dependents(object)), sorted(reference.dependents(object)));
+        EXPECT_EQ(sorted(sharded.transitive_requirements(object)), sorted(reference.transitive_requirements(object)));
+        EXPECT_EQ(sorted(sharded.transitive_dependents(object)), sorted(reference.transitive_dependents(object)));
+    }
+    EXPECT_TRUE(sharded.exists(100, 3, true));
+    EXPECT_FALSE(sharded.exists(100, 3));
+    EXPECT_FALSE(sharded.exists(3, 100, true));
+    auto calls = sharded.transport().calls();
+    sharded.transitive_requirements(119);                               // 7 levels: at most one message per shard and level
+    EXPECT_LE(sharded.transport().calls() - calls, 8u * 4u);
+    sharded.remove_all(2);
+    reference.remove_all(2);
+    EXPECT_EQ(sharded.size(), reference.size());
+    EXPECT_EQ(sharded.exists(8, 1, true), reference.exists(8, 1, true));
+    EXPECT_EQ(sharded.exists(100, 1, true), reference.exists(100, 1, true));
+    EXPECT_TRUE(sharded.dependents(2).empty());
+    for (size_t shard = 0; shard < 4; ++shard)
+        EXPECT_FALSE(sharded.transport().shard(shard).exists(4, 2));
+    Requirements::ShardedRequirements<int> cyclic{ true, 3 };
+    cyclic.add(1, 2);
+    cyclic.add(2, 3);
+    cyclic.add(3, 1);
+    EXPECT_EQ(cyclic.transitive_requirements(1), (std::vector<int>{ 1, 2, 3 }));
+    EXPECT_TRUE(cyclic.exists(1, 1, true));
+    cyclic.clear();
+    EXPECT_TRUE(cyclic.empty());
+    EXPECT_EQ(cyclic.version(), 6u);
+}
+
+TEST(RequirementsBatchTest, Exists_Many)
+{
+    Requirements::Requirements<int> req{ true };
+    auto add = [&req](int dependent, int requirement)
+    {
+        if (dependent != requirement && !req.exists(dependent, requirement, true))
+            req.add(dependent, requirement);
+    };
+    for (int i = 0; i < 200; ++i)
+    {
+        add(i + 1, i / 2);
+        if (i % 7 == 0)
+            add(i / 3, i % 11 + 150);     // creates cycles
+    }
+    std::vector<std::pair<int, int>> queries{};
+    for (int dep = 0; dep < 220; dep += 3)
+        for (int r = 0; r < 220; r += 5)
+            queries.push_back({ dep, r });
+    queries.push_back({ 1000, 0 });     // unknown object
+    for (bool recurse : { false, true })
+    {
+        Requirements::Bitset results{};
+        results.set(queries.size() + 10);   // previous content is overwritten
+        req.exists_many(queries.begin(), queries.end(), results, recurse);
+        Requirements::Bitset parallel{};
+        Requirements::exists_many(req, queries.begin(), queries.end(), parallel, recurse, 4);
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            auto expected = req.exists(queries[i].first, queries[i].second, recurse);
+            EXPECT_EQ(results.test(i), expected) << queries[i].first << " " << queries[i].second;
+            EXPECT_EQ(parallel.test(i), expected) << queries[i].first << " " << queries[i].second;
+        }
+    }
+    std::vector<int> objects{ 3, 1000, 0 };
+    auto lists = req.requirements_many(objects.begin(), objects.end());
+    ASSERT_EQ(lists.size(), 3);
+    EXPECT_EQ(lists[0], req.requirements(3));
+    EXPECT_TRUE(lists[1].empty());
+}
+
+TEST_F(RequirementsTest, Concurrent_Snapshot_Isolation)
+{
+    Requirements::ConcurrentRequirements<NiceGuys> shared{};
+    shared.add(ng::Kyle, ng::Jack);
+    shared.add(ng::Jack, ng::John);
+    {
+        auto before = shared.snapshot();
+        shared.add(ng::Joe, ng::John);
+        shared.remove_dependent(ng::Kyle);
+        EXPECT_EQ(before.size(), 2);
+        EXPECT_TRUE(before.exists(ng::Kyle, ng::John, true));
+        EXPECT_EQ(before.id_of(ng::Joe), Requirements::Requirements<NiceGuys>::npos);
+        auto after = shared.snapshot();
+        EXPECT_EQ(after.version(), before.version() + 2);
+        EXPECT_EQ(after.size(), 2);
+        EXPECT_FALSE(after.has_requirements(ng::Kyle));
+        EXPECT_EQ(after.dependents(ng::John), (std::vector<ng>{ ng::Jack, ng::Joe }));
+        EXPECT_EQ(after.id_of(ng::Jack), before.id_of(ng::Jack));
+    }
+    EXPECT_TRUE(shared.bulk_merge({ { ng::John, ng::Jack } }).size() == 1);
+    shared.clear();
+    EXPECT_TRUE(shared.empty());
+    EXPECT_FALSE(shared.exists(ng::Jack, ng::John));
+}
+
+TEST(RequirementsConcurrentTest, Readers_See_Consistent_Versions)
+{
+    Requirements::ConcurrentRequirements<int> shared{};
+    constexpr int length = 2000;
+    std::atomic<bool> stop{ false };
+    std::atomic<int> failures{ 0 };
+    std::vector<std::thread> readers{};
+    for (int i = 0; i < 4; ++i)
+        readers.emplace_back([&]
+            {
+                while (!stop)
+                {
+                    // the writer extends the chain 0 <- 1 <- 2 ... then removes it from its end
+                    auto snapshot = shared.snapshot();
+                    auto last = static_cast<int>(snapshot.size());
+                    if (last > 0 && (!snapshot.exists(last, last - 1) || !snapshot.exists(last, 0, true)))
+                        ++failures;
+                    if (snapshot.has_requirements(last + 1) || snapshot.has_dependents(last))
+                        ++failures;
+                }
+            });
+    for (int i = 1; i <= length; ++i)
+        shared.add(i, i - 1);
+    for (int i = length; i > 0; --i)
+        shared.remove_dependent(i);
+    stop = true;
+    for (auto& reader : readers)
+        reader.join();
+    EXPECT_EQ(failures, 0);
+    EXPECT_TRUE(shared.empty());
+    EXPECT_EQ(shared.snapshot().node_count(), length + 1);
+}